@@ -0,0 +1,134 @@
+// Per-key calls against batched get_many/put_many on caches far larger
+// than the last-level cache.
+//
+// Each policy is filled with capacity keys, so its index and nodes span
+// hundreds of megabytes and nearly every lookup misses the CPU caches.
+// Gets then draw uniform keys from the filled set, and puts uniform keys
+// over twice that (half update a cached key, half insert and evict). Both
+// streams go through the CacheHandle once as a loop of cache_get/cache_put
+// and once as cache_get_many/cache_put_many calls of each batch size, in
+// ns per key. Batches longer than CACHE_BATCH_CHUNK are worked through a
+// chunk at a time.
+//
+// Usage: bench_batch [capacity] [operations] [policy]
+
+#include "bench_common.h"
+#include "replacement_algorithms/cache_batch.h"
+#include "replacement_algorithms/cache_registry.h"
+#include <string.h>
+
+static const int batch_sizes[] = { 8, 32, 128 };
+#define BATCH_SIZES (int)(sizeof(batch_sizes) / sizeof(batch_sizes[0]))
+
+// Spread small integers over the key space
+static inline int scatter(long i) {
+    return (int)((uint32_t)i * 2654435761u);
+}
+
+// ns per key of a get pass; batch 1 is a loop of cache_get
+static double time_gets(CacheHandle* cache, const int* keys, int* values, long count, int batch) {
+    uint64_t start = bench_now_ns();
+    if (batch == 1) {
+        for (long i = 0; i < count; i++) {
+            values[i] = cache_get(cache, keys[i]);
+        }
+    } else {
+        for (long i = 0; i < count; i += batch) {
+            int n = count - i < batch ? (int)(count - i) : batch;
+            cache_get_many(cache, keys + i, values + i, n);
+        }
+    }
+    return (double)(bench_now_ns() - start) / (double)count;
+}
+
+// ns per key of a put pass; batch 1 is a loop of cache_put
+static double time_puts(CacheHandle* cache, const int* keys, const int* values, long count, int batch) {
+    uint64_t start = bench_now_ns();
+    if (batch == 1) {
+        for (long i = 0; i < count; i++) {
+            cache_put(cache, keys[i], values[i]);
+        }
+    } else {
+        for (long i = 0; i < count; i += batch) {
+            int n = count - i < batch ? (int)(count - i) : batch;
+            cache_put_many(cache, keys + i, values + i, n);
+        }
+    }
+    return (double)(bench_now_ns() - start) / (double)count;
+}
+
+// Fill one policy and time every pass
+static void run_policy(const CacheOps* ops, long capacity, const int* get_keys,
+                       const int* put_keys, int* values, long count) {
+    CacheConfig config = { (int)capacity, CACHE_INDEX_PRESIZED, 0 };
+    CacheHandle* cache = cache_create(ops->name, &config);
+    if (!cache) {
+        printf("%-12sfailed\n", ops->label);
+        return;
+    }
+    for (long i = 0; i < capacity; i++) {
+        cache_put(cache, scatter(i), (int)i);
+    }
+
+    printf("%-12s", ops->label);
+    double gets[BATCH_SIZES + 1];
+    double puts[BATCH_SIZES + 1];
+    for (int b = 0; b <= BATCH_SIZES; b++) {
+        gets[b] = time_gets(cache, get_keys, values, count, b ? batch_sizes[b - 1] : 1);
+    }
+    for (int b = 0; b <= BATCH_SIZES; b++) {
+        puts[b] = time_puts(cache, put_keys, values, count, b ? batch_sizes[b - 1] : 1);
+    }
+    for (int b = 0; b <= BATCH_SIZES; b++) {
+        printf("%.1f\t", gets[b]);
+    }
+    printf("|\t");
+    for (int b = 0; b <= BATCH_SIZES; b++) {
+        printf("%.1f\t", puts[b]);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    cache_destroy(cache);
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 4194304);
+    long count = bench_arg_long(argc, argv, 2, 2000000);
+    const char* only = argc > 3 ? argv[3] : NULL;
+
+    int* get_keys = (int*)malloc((size_t)count * sizeof(int));
+    int* put_keys = (int*)malloc((size_t)count * sizeof(int));
+    int* values = (int*)malloc((size_t)count * sizeof(int));
+    if (!get_keys || !put_keys || !values) {
+        fprintf(stderr, "Failed to allocate the key streams\n");
+        return 1;
+    }
+
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (long i = 0; i < count; i++) {
+        uint64_t r = bench_next_random(&state);
+        get_keys[i] = scatter((long)((r >> 8) % (uint64_t)capacity));
+        put_keys[i] = scatter((long)((r >> 24) % (uint64_t)(capacity * 2)));
+    }
+
+    printf("Capacity %ld, %ld operations per pass, %d keys per chunk, ns/key\n",
+           capacity, count, CACHE_BATCH_CHUNK);
+    printf("----------------------------------------------------------------------------\n");
+    printf("\t\tget\t\t\t\t|\tput\n");
+    printf("Policy\t\t1\t8\t32\t128\t|\t1\t8\t32\t128\n");
+    printf("----------------------------------------------------------------------------\n");
+
+    for (size_t p = 0; p < cache_policy_count(); p++) {
+        const CacheOps* ops = cache_policy_at(p);
+        if (only && strcmp(only, ops->name) != 0) {
+            continue;
+        }
+        run_policy(ops, capacity, get_keys, put_keys, values, count);
+    }
+
+    free(get_keys);
+    free(put_keys);
+    free(values);
+    return 0;
+}
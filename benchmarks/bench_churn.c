@@ -0,0 +1,85 @@
+// Steady-state churn: every put misses and evicts.
+//
+// Each cache is filled to capacity first, then timed over a stream of new
+// keys. With node storage preallocated per cache, the timed phase makes no
+// allocator calls; minor page faults during it are reported as a check
+// that no new memory is being touched. Run under `perf stat -e
+// dTLB-load-misses` to see the effect of the huge-page-backed arenas.
+//
+// Usage: bench_churn [capacity] [puts]
+
+#include "bench_common.h"
+#include <sys/resource.h>
+#include "replacement_algorithms/lru_cache.h"
+#include "replacement_algorithms/lfu_cache.h"
+#include "replacement_algorithms/fifo_cache.h"
+#include "replacement_algorithms/random_cache.h"
+#include "replacement_algorithms/clock_cache.h"
+#include "replacement_algorithms/arc_cache.h"
+#include "replacement_algorithms/s3fifo_cache.h"
+#include "replacement_algorithms/lirs_cache.h"
+#include "replacement_algorithms/lru2_cache.h"
+#include "replacement_algorithms/twoq_cache.h"
+
+typedef struct {
+    const char* name;
+    Cache* (*create)(int capacity);
+    void (*destroy)(Cache* cache);
+    void (*put)(Cache* cache, int key, int value);
+} Backend;
+
+static long minor_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 1000000);
+    long puts = bench_arg_long(argc, argv, 2, 5000000);
+    const Backend backends[] = {
+        { "LRU", create_lru_cache, destroy_lru_cache, put_lru },
+        { "LFU", create_lfu_cache, destroy_lfu_cache, put_lfu },
+        { "FIFO", create_fifo_cache, destroy_fifo_cache, put_fifo },
+        { "Random", create_random_cache, destroy_random_cache, put_random },
+        { "CLOCK", create_clock_cache, destroy_clock_cache, put_clock },
+        { "ARC", create_arc_cache, destroy_arc_cache, put_arc },
+        { "S3-FIFO", create_s3fifo_cache, destroy_s3fifo_cache, put_s3fifo },
+        { "LIRS", create_lirs_cache, destroy_lirs_cache, put_lirs },
+        { "LRU-2", create_lru2_cache, destroy_lru2_cache, put_lru2 },
+        { "2Q", create_twoq_cache, destroy_twoq_cache, put_twoq },
+    };
+
+    printf("Churn at capacity %ld, %ld evicting puts\n", capacity, puts);
+    printf("------------------------------------------------\n");
+    printf("Policy\tns/put\tminor faults\n");
+    printf("------------------------------------------------\n");
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        const Backend* backend = &backends[b];
+        Cache* cache = backend->create((int)capacity);
+        if (!cache) {
+            fprintf(stderr, "Failed to create %s cache\n", backend->name);
+            return 1;
+        }
+
+        uint64_t rng = 0x853c49e6748fea9bull;
+        for (long i = 0; i < capacity; i++) {
+            backend->put(cache, (int)bench_next_random(&rng), (int)i);
+        }
+
+        long faults = minor_faults();
+        uint64_t start = bench_now_ns();
+        for (long i = 0; i < puts; i++) {
+            backend->put(cache, (int)bench_next_random(&rng), (int)i);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        faults = minor_faults() - faults;
+
+        printf("%s\t%.1f\t%ld\n", backend->name, (double)elapsed / (double)puts, faults);
+        backend->destroy(cache);
+    }
+    printf("------------------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+// Monotonic clock in nanoseconds
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Cheap key stream so key generation doesn't dominate the timings
+static inline uint64_t bench_next_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// Parse an optional size argument, e.g. "10000000"
+static inline long bench_arg_long(int argc, char** argv, int index, long fallback) {
+    if (argc > index) {
+        long value = strtol(argv[index], NULL, 10);
+        if (value > 0) {
+            return value;
+        }
+    }
+    return fallback;
+}
+
+// Fill keys[0..count) with a Zipf(exponent) stream over universe keys.
+// Ranks are drawn by inverting the CDF, then scattered with an odd
+// multiplier so popular keys aren't numerically adjacent. Returns -1 if
+// the CDF table can't be allocated.
+static inline int bench_zipf_keys(int* keys, long count, long universe,
+                                  double exponent, uint64_t seed) {
+    double* cdf = (double*)malloc((size_t)universe * sizeof(double));
+    if (!cdf) {
+        return -1;
+    }
+
+    double total = 0;
+    for (long k = 0; k < universe; k++) {
+        total += 1.0 / pow((double)(k + 1), exponent);
+        cdf[k] = total;
+    }
+
+    uint64_t state = seed ? seed : 1;
+    for (long i = 0; i < count; i++) {
+        double u = (double)(bench_next_random(&state) >> 11) / 9007199254740992.0 * total;
+        long lo = 0, hi = universe - 1;
+        while (lo < hi) {
+            long mid = (lo + hi) / 2;
+            if (cdf[mid] < u) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        keys[i] = (int)((uint32_t)lo * 2654435761u);
+    }
+
+    free(cdf);
+    return 0;
+}
+
+#endif // BENCH_COMMON_H
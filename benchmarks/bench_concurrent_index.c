@@ -0,0 +1,310 @@
+// Stress test and read scaling of the lock-free ConcurrentIndex.
+//
+// The stress phase starts a growable index at its smallest size and has
+// one writer insert, update and remove churn keys (forcing rebuilds and
+// table retirement) while the reader threads look up both the churn keys
+// and a set of pinned keys that are never removed. Every handle found must
+// be one the writer stored for that key, and a pinned key must never be
+// missed; any violation is counted and fails the run.
+//
+// The throughput phase looks up uniform keys over twice the key count (so
+// half of them hit), all reads or with 1% toggling a key in or out, from 1
+// to max threads. The shared CacheIndex behind one mutex, and behind a
+// reader-writer lock with lookups in shared mode, is compared against the
+// ConcurrentIndex with its writes under a mutex. Each figure is the best of
+// BENCH_PASSES.
+//
+// Usage: bench_concurrent_index [keys] [operations per thread] [max threads]
+
+#include "bench_common.h"
+#include "replacement_algorithms/cache_index.h"
+#include "replacement_algorithms/concurrent_index.h"
+#include <pthread.h>
+
+#define BENCH_PASSES 3
+#define STRESS_PINNED 1024
+#define STRESS_CHURN 65536
+#define STRESS_WRITES 2000000
+
+typedef enum {
+    INDEX_MUTEX,            // CacheIndex, every operation under a mutex
+    INDEX_RWLOCK,           // CacheIndex, lookups in shared mode
+    INDEX_LOCK_FREE         // ConcurrentIndex, writes under a mutex
+} IndexKind;
+
+static const char* const kind_names[] = { "mutex", "rwlock", "lock-free" };
+
+// An index under test with its locks
+typedef struct Target {
+    IndexKind kind;
+    CacheIndex index;
+    ConcurrentIndex concurrent;
+    pthread_mutex_t mutex;
+    pthread_rwlock_t rwlock;
+} Target;
+
+// One thread's share of the work
+typedef struct Worker {
+    pthread_t thread;
+    Target* target;
+    pthread_barrier_t* start;
+    long universe;
+    long count;
+    int write_percent;
+    uint64_t seed;
+    long found;
+    uint64_t begin;         // When this thread started and finished
+    uint64_t end;
+} Worker;
+
+// Handle stored for key; the stress writer also stores it with the low bit flipped
+static inline uint32_t handle_of(int key) {
+    return ((uint32_t)key * 2654435761u) >> 2;
+}
+
+// Look a key up under the target's locking scheme
+static uint32_t target_find(Target* target, int key) {
+    uint32_t handle;
+    switch (target->kind) {
+        case INDEX_MUTEX:
+            pthread_mutex_lock(&target->mutex);
+            handle = cache_index_find(&target->index, key);
+            pthread_mutex_unlock(&target->mutex);
+            return handle;
+        case INDEX_RWLOCK:
+            pthread_rwlock_rdlock(&target->rwlock);
+            handle = cache_index_find(&target->index, key);
+            pthread_rwlock_unlock(&target->rwlock);
+            return handle;
+        case INDEX_LOCK_FREE:
+            handle = concurrent_index_find(&target->concurrent, key);
+            return handle == CONCURRENT_INDEX_NONE ? CACHE_INDEX_NONE : handle;
+    }
+    return CACHE_INDEX_NONE;
+}
+
+// Insert key if absent, remove it if present
+static void target_toggle(Target* target, int key) {
+    switch (target->kind) {
+        case INDEX_MUTEX:
+            pthread_mutex_lock(&target->mutex);
+            if (cache_index_remove(&target->index, key) == CACHE_INDEX_NONE) {
+                cache_index_insert(&target->index, key, handle_of(key));
+            }
+            pthread_mutex_unlock(&target->mutex);
+            break;
+        case INDEX_RWLOCK:
+            pthread_rwlock_wrlock(&target->rwlock);
+            if (cache_index_remove(&target->index, key) == CACHE_INDEX_NONE) {
+                cache_index_insert(&target->index, key, handle_of(key));
+            }
+            pthread_rwlock_unlock(&target->rwlock);
+            break;
+        case INDEX_LOCK_FREE:
+            pthread_mutex_lock(&target->mutex);
+            if (concurrent_index_remove(&target->concurrent, key) == CONCURRENT_INDEX_NONE) {
+                concurrent_index_insert(&target->concurrent, key, handle_of(key));
+            }
+            pthread_mutex_unlock(&target->mutex);
+            break;
+    }
+}
+
+static void* run_worker(void* arg) {
+    Worker* worker = (Worker*)arg;
+    uint64_t state = worker->seed;
+    long found = 0;
+
+    pthread_barrier_wait(worker->start);
+    worker->begin = bench_now_ns();
+    for (long i = 0; i < worker->count; i++) {
+        uint64_t r = bench_next_random(&state);
+        int key = (int)((r >> 8) % (uint64_t)worker->universe);
+        if ((int)(r & 127) < worker->write_percent * 128 / 100) {
+            target_toggle(worker->target, key);
+        } else {
+            found += target_find(worker->target, key) != CACHE_INDEX_NONE;
+        }
+    }
+    worker->end = bench_now_ns();
+    worker->found = found;
+    return NULL;
+}
+
+// Millions of operations per second over all threads
+static double run_threads(Target* target, long universe, long count, int threads, int write_percent) {
+    Worker workers[threads];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)threads + 1);
+
+    for (int t = 0; t < threads; t++) {
+        workers[t].target = target;
+        workers[t].start = &start;
+        workers[t].universe = universe;
+        workers[t].count = count;
+        workers[t].write_percent = write_percent;
+        workers[t].seed = 0x9e3779b97f4a7c15ull * (uint64_t)(t + 1);
+        pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]);
+    }
+
+    pthread_barrier_wait(&start);
+    uint64_t begin = UINT64_MAX;
+    uint64_t end = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        begin = workers[t].begin < begin ? workers[t].begin : begin;
+        end = workers[t].end > end ? workers[t].end : end;
+    }
+
+    pthread_barrier_destroy(&start);
+    return (double)count * threads * 1e3 / (double)(end - begin);
+}
+
+// Stress phase state
+typedef struct Stress {
+    ConcurrentIndex index;
+    int done;
+    long lookups;
+    long errors;
+} Stress;
+
+// Check lookups against what the writer may have stored
+static void* stress_reader(void* arg) {
+    Stress* stress = (Stress*)arg;
+    uint64_t state = (uint64_t)(uintptr_t)&state | 1;
+    long lookups = 0;
+    long errors = 0;
+
+    while (!__atomic_load_n(&stress->done, __ATOMIC_ACQUIRE)) {
+        int key = (int)(bench_next_random(&state) % (STRESS_PINNED + STRESS_CHURN));
+        uint32_t handle = concurrent_index_find(&stress->index, key);
+        if (handle == CONCURRENT_INDEX_NONE) {
+            errors += key < STRESS_PINNED;      // Pinned keys are always present
+        } else if (handle != handle_of(key) && handle != (handle_of(key) ^ 1)) {
+            errors++;                           // Another key's handle, or garbage
+        }
+        lookups++;
+    }
+
+    __atomic_add_fetch(&stress->lookups, lookups, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stress->errors, errors, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Run the stress phase; returns the number of errors
+static long run_stress(int readers) {
+    Stress stress;
+    if (concurrent_index_init(&stress.index, STRESS_PINNED + STRESS_CHURN, CACHE_INDEX_GROWABLE) != 0) {
+        fprintf(stderr, "Failed to create the index\n");
+        return 1;
+    }
+    stress.done = 0;
+    stress.lookups = 0;
+    stress.errors = 0;
+    for (int key = 0; key < STRESS_PINNED; key++) {
+        concurrent_index_insert(&stress.index, key, handle_of(key));
+    }
+
+    pthread_t threads[readers];
+    for (int t = 0; t < readers; t++) {
+        pthread_create(&threads[t], NULL, stress_reader, &stress);
+    }
+
+    // Churn keys fill the index up and drain it again, so it both grows
+    // and rebuilds to clear tombstones
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    for (long i = 0; i < STRESS_WRITES; i++) {
+        uint64_t r = bench_next_random(&state);
+        long span = (i / (STRESS_WRITES / 8)) % 2 ? STRESS_CHURN / 16 : STRESS_CHURN;
+        int key = STRESS_PINNED + (int)((r >> 8) % (uint64_t)span);
+        uint32_t handle = r & 1 ? handle_of(key) : handle_of(key) ^ 1;
+
+        if ((r & 6) == 0) {
+            concurrent_index_update(&stress.index, key, handle);
+        } else if (concurrent_index_remove(&stress.index, key) == CONCURRENT_INDEX_NONE) {
+            concurrent_index_insert(&stress.index, key, handle);
+        }
+        if ((r & 0xff) == 0) {
+            concurrent_index_update(&stress.index, (int)(r >> 40) % STRESS_PINNED,
+                                    handle_of((int)(r >> 40) % STRESS_PINNED));
+        }
+    }
+    __atomic_store_n(&stress.done, 1, __ATOMIC_RELEASE);
+
+    for (int t = 0; t < readers; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    printf("Stress: %ld lookups by %d threads during %d writes, %zu keys left, %ld errors\n",
+           stress.lookups, readers, STRESS_WRITES, concurrent_index_count(&stress.index),
+           stress.errors);
+
+    concurrent_index_destroy(&stress.index);
+    return stress.errors;
+}
+
+int main(int argc, char** argv) {
+    long keys = bench_arg_long(argc, argv, 1, 1000000);
+    long count = bench_arg_long(argc, argv, 2, 1000000);
+    int max_threads = (int)bench_arg_long(argc, argv, 3, 64);
+    long universe = keys * 2;
+
+    if (run_stress(max_threads < 4 ? max_threads : 4) != 0) {
+        return 1;
+    }
+
+    Target targets[3];
+    for (int k = 0; k < 3; k++) {
+        Target* target = &targets[k];
+        target->kind = (IndexKind)k;
+        pthread_mutex_init(&target->mutex, NULL);
+        pthread_rwlock_init(&target->rwlock, NULL);
+        int failed = target->kind == INDEX_LOCK_FREE
+            ? concurrent_index_init(&target->concurrent, (int)universe, CACHE_INDEX_PRESIZED)
+            : cache_index_init(&target->index, (int)universe, CACHE_INDEX_PRESIZED);
+        if (failed) {
+            fprintf(stderr, "Failed to create the %s index\n", kind_names[k]);
+            return 1;
+        }
+        // Every other key, so lookups hit half the time
+        for (long key = 0; key < universe; key += 2) {
+            target_toggle(target, (int)key);
+        }
+    }
+
+    printf("\n%ld keys, lookups over %ld, %ld operations per thread, Mops/s\n",
+           keys, universe, count);
+
+    for (int write_percent = 0; write_percent <= 1; write_percent++) {
+        printf("\n%s\n", write_percent ? "99% lookups, 1% toggles" : "Lookups only");
+        printf("------------------------------------------------\n");
+        printf("Threads");
+        for (int k = 0; k < 3; k++) {
+            printf("\t%s", kind_names[k]);
+        }
+        printf("\n------------------------------------------------\n");
+
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%d", threads);
+            for (int k = 0; k < 3; k++) {
+                double best = 0;
+                for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                    double mops = run_threads(&targets[k], universe, count, threads, write_percent);
+                    best = mops > best ? mops : best;
+                }
+                printf("\t%.2f", best);
+            }
+            printf("\n");
+        }
+    }
+
+    for (int k = 0; k < 3; k++) {
+        if (targets[k].kind == INDEX_LOCK_FREE) {
+            concurrent_index_destroy(&targets[k].concurrent);
+        } else {
+            cache_index_destroy(&targets[k].index);
+        }
+        pthread_mutex_destroy(&targets[k].mutex);
+        pthread_rwlock_destroy(&targets[k].rwlock);
+    }
+    return 0;
+}
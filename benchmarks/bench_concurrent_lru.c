@@ -0,0 +1,187 @@
+// Read scaling and hit ratio of the concurrent LRU from 1 to max threads.
+//
+// Two workloads on Zipf 0.99 keys over 16 times the capacity: a
+// read-through stream (get, plus put on a miss) and a gets-only stream
+// against the warmed cache. Each is split evenly across the threads and
+// run through one LRU behind a single mutex (exact LRU), the sharded
+// front end with an LRU and a mutex per shard, and the concurrent LRU,
+// whose gets take no lock and record recency through lossy buffers. The
+// hit ratio is reported next to each throughput so the cost of the
+// approximate recency can be read off against the exact one. Each figure
+// is the best of BENCH_PASSES.
+//
+// Usage: bench_concurrent_lru [capacity] [operations] [max threads] [shards]
+
+#include "bench_common.h"
+#include "replacement_algorithms/concurrent_lru_cache.h"
+#include "replacement_algorithms/sharded_cache.h"
+#include <pthread.h>
+
+#define BENCH_PASSES 3
+
+// A cache under test, behind a common pair of calls
+typedef struct Target {
+    const char* name;
+    void* cache;
+    int (*get)(void* cache, int key);
+    void (*put)(void* cache, int key, int value);
+} Target;
+
+// One thread's share of the stream
+typedef struct Worker {
+    pthread_t thread;
+    const Target* target;
+    pthread_barrier_t* start;
+    const int* keys;
+    long count;
+    int fill;               // Put on a miss
+    long hits;
+    uint64_t begin;         // When this thread started and finished its slice
+    uint64_t end;
+} Worker;
+
+static int sharded_get(void* cache, int key) {
+    return sharded_cache_get((ShardedCache*)cache, key);
+}
+
+static void sharded_put(void* cache, int key, int value) {
+    sharded_cache_put((ShardedCache*)cache, key, value);
+}
+
+static int concurrent_get(void* cache, int key) {
+    return get_concurrent_lru((Cache*)cache, key);
+}
+
+static void concurrent_put(void* cache, int key, int value) {
+    put_concurrent_lru((Cache*)cache, key, value);
+}
+
+// Replay a slice of the stream; returns the number of hits
+static long replay(const Target* target, const int* keys, long count, int fill) {
+    long hits = 0;
+    for (long i = 0; i < count; i++) {
+        if (target->get(target->cache, keys[i]) != -1) {
+            hits++;
+        } else if (fill) {
+            target->put(target->cache, keys[i], (int)i);
+        }
+    }
+    return hits;
+}
+
+static void* run_worker(void* arg) {
+    Worker* worker = (Worker*)arg;
+    pthread_barrier_wait(worker->start);
+    worker->begin = bench_now_ns();
+    worker->hits = replay(worker->target, worker->keys, worker->count, worker->fill);
+    worker->end = bench_now_ns();
+    return NULL;
+}
+
+// Millions of operations per second with the stream split across threads;
+// the hit ratio of the run goes to *hit_ratio
+static double run_threads(const Target* target, const int* keys, long count, int threads,
+                          int fill, double* hit_ratio) {
+    Worker workers[threads];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)threads + 1);
+
+    for (int t = 0; t < threads; t++) {
+        long first = count * t / threads;
+        workers[t].target = target;
+        workers[t].start = &start;
+        workers[t].keys = keys + first;
+        workers[t].count = count * (t + 1) / threads - first;
+        workers[t].fill = fill;
+        pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]);
+    }
+
+    // Time from the first thread starting to the last one finishing
+    pthread_barrier_wait(&start);
+    uint64_t begin = UINT64_MAX;
+    uint64_t end = 0;
+    long hits = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        begin = workers[t].begin < begin ? workers[t].begin : begin;
+        end = workers[t].end > end ? workers[t].end : end;
+        hits += workers[t].hits;
+    }
+
+    pthread_barrier_destroy(&start);
+    *hit_ratio = (double)hits / (double)count;
+    return (double)count * 1e3 / (double)(end - begin);
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 65536);
+    long count = bench_arg_long(argc, argv, 2, 1000000);
+    int max_threads = (int)bench_arg_long(argc, argv, 3, 64);
+    int shards = (int)bench_arg_long(argc, argv, 4, 64);
+    long universe = capacity * 16;
+
+    int* keys = (int*)malloc((size_t)count * sizeof(int));
+    if (!keys || bench_zipf_keys(keys, count, universe, 0.99, 0x9e3779b97f4a7c15ull) != 0) {
+        fprintf(stderr, "Failed to generate the key stream\n");
+        return 1;
+    }
+
+    ShardedCacheConfig global = { (int)capacity, 1, SHARD_LOCK_MUTEX, CACHE_INDEX_PRESIZED };
+    ShardedCacheConfig sharded = { (int)capacity, shards, SHARD_LOCK_MUTEX, CACHE_INDEX_PRESIZED };
+    Target targets[] = {
+        { "1 mutex", sharded_cache_create("lru", &global), sharded_get, sharded_put },
+        { "sharded", sharded_cache_create("lru", &sharded), sharded_get, sharded_put },
+        { "C-LRU", create_concurrent_lru_cache((int)capacity), concurrent_get, concurrent_put },
+    };
+    const int target_count = (int)(sizeof(targets) / sizeof(targets[0]));
+    for (int c = 0; c < target_count; c++) {
+        if (!targets[c].cache) {
+            fprintf(stderr, "Failed to create the %s cache\n", targets[c].name);
+            return 1;
+        }
+    }
+
+    printf("LRU, capacity %ld, %ld Zipf 0.99 operations over %ld keys split across the threads\n",
+           capacity, count, universe);
+    printf("Mops/s and hit ratio; sharded uses %d shards\n",
+           sharded_cache_shard_count((ShardedCache*)targets[1].cache));
+
+    for (int fill = 1; fill >= 0; fill--) {
+        // Warm every cache with one single-threaded read-through pass
+        for (int c = 0; c < target_count; c++) {
+            replay(&targets[c], keys, count, 1);
+        }
+
+        printf("\n%s\n", fill ? "Read-through (put on miss)" : "Gets only");
+        printf("------------------------------------------------------------------------\n");
+        printf("Threads");
+        for (int c = 0; c < target_count; c++) {
+            printf("\t%-15s", targets[c].name);
+        }
+        printf("\n------------------------------------------------------------------------\n");
+
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%d", threads);
+            for (int c = 0; c < target_count; c++) {
+                double best = 0;
+                double hit_ratio = 0;
+                for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                    double ratio;
+                    double mops = run_threads(&targets[c], keys, count, threads, fill, &ratio);
+                    if (mops > best) {
+                        best = mops;
+                        hit_ratio = ratio;
+                    }
+                }
+                printf("\t%6.2f %6.2f%%", best, hit_ratio * 100);
+            }
+            printf("\n");
+        }
+    }
+
+    sharded_cache_destroy((ShardedCache*)targets[0].cache);
+    sharded_cache_destroy((ShardedCache*)targets[1].cache);
+    destroy_concurrent_lru_cache((Cache*)targets[2].cache);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Cost of dispatching through the CacheHandle ops table.
+//
+// A Zipf key stream is replayed against every registered policy as get,
+// plus put on a miss, once through cache_get/cache_put (an indirect call
+// per operation) and once through loops stamped out per policy with
+// CACHE_DEFINE_STATIC, which call the backend directly. Both go through
+// the same handle and keep the same counters. The first pass warms the
+// cache and is not timed; each figure is the fastest of BENCH_PASSES.
+//
+// Usage: bench_dispatch [capacity] [universe] [operations] [zipf exponent x 100]
+
+#include "bench_common.h"
+#include "replacement_algorithms/cache_registry.h"
+#include <string.h>
+
+#define BENCH_PASSES 3
+
+typedef void (*ReplayFn)(CacheHandle* cache, const int* keys, long count);
+
+// Replay through the ops table
+static void replay_dynamic(CacheHandle* cache, const int* keys, long count) {
+    for (long i = 0; i < count; i++) {
+        if (cache_get(cache, keys[i]) == -1) {
+            cache_put(cache, keys[i], (int)i);
+        }
+    }
+}
+
+// One directly dispatched replay per policy
+#define DEFINE_STATIC_REPLAY(name, create, ops, label, description, read_only_get, min_capacity, seed) \
+    CACHE_DEFINE_STATIC(name, ops) \
+    static void replay_static_##name(CacheHandle* cache, const int* keys, long count) { \
+        for (long i = 0; i < count; i++) { \
+            if (name##_get(cache, keys[i]) == -1) { \
+                name##_put(cache, keys[i], (int)i); \
+            } \
+        } \
+    }
+
+CACHE_POLICIES(DEFINE_STATIC_REPLAY)
+
+#define STATIC_REPLAY_ENTRY(name, create, ops, label, description, read_only_get, min_capacity, seed) { #name, replay_static_##name },
+
+static const struct {
+    const char* name;
+    ReplayFn replay;
+} static_replays[] = {
+    CACHE_POLICIES(STATIC_REPLAY_ENTRY)
+};
+
+// Fastest of BENCH_PASSES replays, in ns per operation
+static double best_pass(ReplayFn replay, CacheHandle* cache, const int* keys, long count) {
+    uint64_t best = UINT64_MAX;
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        uint64_t start = bench_now_ns();
+        replay(cache, keys, count);
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return (double)best / (double)count;
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 100000);
+    long universe = bench_arg_long(argc, argv, 2, 1000000);
+    long count = bench_arg_long(argc, argv, 3, 2000000);
+    double exponent = (double)bench_arg_long(argc, argv, 4, 99) / 100.0;
+    CacheConfig config = { (int)capacity, CACHE_INDEX_PRESIZED, 0 };
+
+    int* keys = (int*)malloc((size_t)count * sizeof(int));
+    if (!keys || bench_zipf_keys(keys, count, universe, exponent, 0x9e3779b97f4a7c15ull) != 0) {
+        fprintf(stderr, "Failed to generate the key stream\n");
+        return 1;
+    }
+
+    printf("Zipf %.2f over %ld keys, capacity %ld, %ld operations\n",
+           exponent, universe, capacity, count);
+    printf("------------------------------------------------\n");
+    printf("Policy\t\tops table ns/op\tdirect ns/op\thit ratio\n");
+    printf("------------------------------------------------\n");
+
+    for (size_t p = 0; p < sizeof(static_replays) / sizeof(static_replays[0]); p++) {
+        CacheHandle* cache = cache_create(static_replays[p].name, &config);
+        if (!cache) {
+            printf("%-16sfailed\n", static_replays[p].name);
+            continue;
+        }
+
+        replay_dynamic(cache, keys, count);     // Warm up
+        memset(&cache->stats, 0, sizeof(cache->stats));
+        double dynamic_ns = best_pass(replay_dynamic, cache, keys, count);
+        double static_ns = best_pass(static_replays[p].replay, cache, keys, count);
+
+        CacheStats stats;
+        cache_get_stats(cache, &stats);
+        printf("%-16s%.1f\t\t%.1f\t\t%.2f%%\n", cache->ops->label, dynamic_ns, static_ns,
+               100.0 * (double)stats.hits / (double)(stats.hits + stats.misses));
+        cache_destroy(cache);
+    }
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Memory footprint: resident bytes per cached entry for each backend.
+//
+// Each cache is created and filled to capacity with distinct keys, and the
+// growth in resident set size is divided by the number of entries. This
+// counts everything the cache touches (nodes or slots, the key index, and
+// allocator overhead), not just sizeof of its structs. Resident size is
+// read from /proc/self/statm, so the numbers are only available on Linux.
+// Each backend is measured in a forked child so memory the allocator kept
+// from an earlier backend can't hide part of a later one's growth.
+//
+// Usage: bench_footprint [capacity]
+
+#include "bench_common.h"
+#include <unistd.h>
+#include <sys/wait.h>
+#include "replacement_algorithms/lru_cache.h"
+#include "replacement_algorithms/lfu_cache.h"
+#include "replacement_algorithms/fifo_cache.h"
+#include "replacement_algorithms/random_cache.h"
+#include "replacement_algorithms/clock_cache.h"
+#include "replacement_algorithms/arc_cache.h"
+#include "replacement_algorithms/s3fifo_cache.h"
+#include "replacement_algorithms/lirs_cache.h"
+#include "replacement_algorithms/lru2_cache.h"
+#include "replacement_algorithms/twoq_cache.h"
+
+typedef struct {
+    const char* name;
+    Cache* (*create)(int capacity);
+    void (*destroy)(Cache* cache);
+    void (*put)(Cache* cache, int key, int value);
+} Backend;
+
+// Resident set size in bytes, or -1 if it can't be read
+static long resident_bytes(void) {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    long size, resident;
+
+    if (!statm) {
+        return -1;
+    }
+    if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+        resident = -1;
+    }
+    fclose(statm);
+    return resident < 0 ? -1 : resident * sysconf(_SC_PAGESIZE);
+}
+
+// Fill one backend to capacity and report its resident growth
+static int measure(const Backend* backend, long capacity) {
+    long before = resident_bytes();
+
+    Cache* cache = backend->create((int)capacity);
+    if (!cache) {
+        fprintf(stderr, "Failed to create %s cache\n", backend->name);
+        return 1;
+    }
+
+    // Sequential keys are distinct, so the cache ends up exactly full
+    for (long i = 0; i < capacity; i++) {
+        backend->put(cache, (int)i, (int)i);
+    }
+
+    long grown = resident_bytes() - before;
+    printf("%s\t%.1f\t\t%.1f\n", backend->name,
+           (double)grown / (1024.0 * 1024.0), (double)grown / (double)capacity);
+    fflush(stdout);
+    backend->destroy(cache);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 1000000);
+    const Backend backends[] = {
+        { "LRU", create_lru_cache, destroy_lru_cache, put_lru },
+        { "W-TinyLFU", create_wtinylfu_cache, destroy_lru_cache, put_lru },
+        { "LFU", create_lfu_cache, destroy_lfu_cache, put_lfu },
+        { "FIFO", create_fifo_cache, destroy_fifo_cache, put_fifo },
+        { "Random", create_random_cache, destroy_random_cache, put_random },
+        { "CLOCK", create_clock_cache, destroy_clock_cache, put_clock },
+        { "ARC", create_arc_cache, destroy_arc_cache, put_arc },
+        { "S3-FIFO", create_s3fifo_cache, destroy_s3fifo_cache, put_s3fifo },
+        { "LIRS", create_lirs_cache, destroy_lirs_cache, put_lirs },
+        { "LRU-2", create_lru2_cache, destroy_lru2_cache, put_lru2 },
+        { "2Q", create_twoq_cache, destroy_twoq_cache, put_twoq },
+    };
+
+    if (resident_bytes() < 0) {
+        fprintf(stderr, "Resident set size is not available on this system\n");
+        return 1;
+    }
+
+    printf("Footprint at capacity %ld\n", capacity);
+    printf("------------------------------------------------\n");
+    printf("Policy\tresident MB\tbytes/entry\n");
+    printf("------------------------------------------------\n");
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        fflush(stdout);
+        pid_t child = fork();
+        if (child < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (child == 0) {
+            return measure(&backends[b], capacity);
+        }
+
+        int status;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            return 1;
+        }
+    }
+    printf("------------------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Put latency while the key index grows.
+//
+// Fills an LRU cache from empty to capacity, timing every put. In growable
+// mode the index starts at 64 buckets and doubles by incremental rehashing;
+// presized mode allocates the full index up front. The tail percentiles
+// show whether any single put stalls on a table migration.
+//
+// Usage: bench_index_growth [capacity]
+
+#include "bench_common.h"
+#include "replacement_algorithms/lru_cache.h"
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run(const char* name, CacheIndexSizing sizing, long capacity, uint32_t* latencies) {
+    Cache* cache = create_lru_cache_sized((int)capacity, sizing);
+    if (!cache) {
+        fprintf(stderr, "Failed to create cache of capacity %ld\n", capacity);
+        exit(1);
+    }
+
+    uint64_t rng = 0x9e3779b97f4a7c15ull;
+    uint64_t total = bench_now_ns();
+    for (long i = 0; i < capacity; i++) {
+        int key = (int)(bench_next_random(&rng) & 0x7fffffff);
+        uint64_t start = bench_now_ns();
+        put_lru(cache, key, (int)i);
+        uint64_t elapsed = bench_now_ns() - start;
+        latencies[i] = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    }
+    total = bench_now_ns() - total;
+    destroy_lru_cache(cache);
+
+    qsort(latencies, (size_t)capacity, sizeof(uint32_t), compare_u32);
+    printf("%s\t%.1f\t%u\t%u\t%u\t%u\n",
+           name,
+           (double)total / (double)capacity,
+           latencies[capacity / 2],
+           latencies[(long)(capacity * 0.99)],
+           latencies[(long)(capacity * 0.999)],
+           latencies[capacity - 1]);
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 10000000);
+    uint32_t* latencies = (uint32_t*)malloc((size_t)capacity * sizeof(uint32_t));
+    if (!latencies) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    printf("LRU fill to %ld entries, per-put latency in ns\n", capacity);
+    printf("------------------------------------------------\n");
+    printf("Mode\t\tavg\tp50\tp99\tp99.9\tmax\n");
+    printf("------------------------------------------------\n");
+    run("presized", CACHE_INDEX_PRESIZED, capacity, latencies);
+    run("growable", CACHE_INDEX_GROWABLE, capacity, latencies);
+    printf("------------------------------------------------\n");
+
+    free(latencies);
+    return 0;
+}
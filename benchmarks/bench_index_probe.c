@@ -0,0 +1,131 @@
+// Lookup cost of the open-addressing index against the chained table the
+// backends used before (one malloc'd HashEntry per key, key % buckets).
+//
+// Both tables get the same number of slots/buckets and are filled to each
+// load factor; then random present keys (hits) and absent keys (misses)
+// are looked up.
+//
+// Usage: bench_index_probe [log2_slots] [lookups]
+
+#include "bench_common.h"
+#include "replacement_algorithms/cache_index.h"
+
+// Chained table baseline
+typedef struct HashEntry {
+    int key;
+    uint32_t handle;
+    struct HashEntry* next;
+} HashEntry;
+
+typedef struct {
+    HashEntry** buckets;
+    size_t size;
+} ChainedTable;
+
+static void chained_init(ChainedTable* table, size_t size) {
+    table->buckets = (HashEntry**)calloc(size, sizeof(HashEntry*));
+    table->size = size;
+}
+
+static void chained_insert(ChainedTable* table, int key, uint32_t handle) {
+    size_t h = (unsigned int)key % table->size;
+    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
+    entry->key = key;
+    entry->handle = handle;
+    entry->next = table->buckets[h];
+    table->buckets[h] = entry;
+}
+
+static uint32_t chained_find(ChainedTable* table, int key) {
+    HashEntry* entry = table->buckets[(unsigned int)key % table->size];
+    while (entry) {
+        if (entry->key == key) {
+            return entry->handle;
+        }
+        entry = entry->next;
+    }
+    return CACHE_INDEX_NONE;
+}
+
+static void chained_destroy(ChainedTable* table) {
+    for (size_t i = 0; i < table->size; i++) {
+        HashEntry* entry = table->buckets[i];
+        while (entry) {
+            HashEntry* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(table->buckets);
+}
+
+// Scramble i over the whole key space (a bijection, so keys never repeat)
+static int key_at(uint32_t i) {
+    i ^= i >> 16;
+    i *= 0x7feb352du;
+    i ^= i >> 15;
+    i *= 0x846ca68bu;
+    i ^= i >> 16;
+    return (int)i;
+}
+
+// Present keys come from [0, count), absent keys from the upper half
+static int present_key(uint64_t* rng, long count) {
+    return key_at((uint32_t)(bench_next_random(rng) % (uint64_t)count));
+}
+
+static int absent_key(uint64_t* rng, long count) {
+    return key_at(0x80000000u | (uint32_t)(bench_next_random(rng) % (uint64_t)count));
+}
+
+int main(int argc, char** argv) {
+    long log2_slots = bench_arg_long(argc, argv, 1, 22);
+    long lookups = bench_arg_long(argc, argv, 2, 4000000);
+    size_t slots = (size_t)1 << log2_slots;
+    static const double loads[] = { 0.5, 0.6, 0.7, 0.8, 0.9 };
+
+    printf("Index lookups over %zu slots, ns/lookup\n", slots);
+    printf("------------------------------------------------\n");
+    printf("Load\tswiss hit\tswiss miss\tchained hit\tchained miss\n");
+    printf("------------------------------------------------\n");
+
+    for (size_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+        long count = (long)(loads[l] * (double)slots);
+        volatile uint32_t sink = 0;
+        double results[4];
+
+        // Size the open-addressing index to exactly `slots` slots
+        CacheIndex index;
+        if (cache_index_init(&index, (int)(slots - slots / 8), CACHE_INDEX_PRESIZED) != 0) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        ChainedTable chained;
+        chained_init(&chained, slots);
+
+        for (long i = 0; i < count; i++) {
+            int key = key_at((uint32_t)i);
+            cache_index_insert(&index, key, (uint32_t)i);
+            chained_insert(&chained, key, (uint32_t)i);
+        }
+
+        for (int variant = 0; variant < 4; variant++) {
+            uint64_t rng = 0x2545f4914f6cdd1dull;
+            uint64_t start = bench_now_ns();
+            for (long i = 0; i < lookups; i++) {
+                int key = (variant & 1) ? absent_key(&rng, count) : present_key(&rng, count);
+                sink += variant < 2 ? cache_index_find(&index, key) : chained_find(&chained, key);
+            }
+            results[variant] = (double)(bench_now_ns() - start) / (double)lookups;
+        }
+
+        printf("%.1f\t%.1f\t\t%.1f\t\t%.1f\t\t%.1f\n",
+               loads[l], results[0], results[1], results[2], results[3]);
+
+        cache_index_destroy(&index);
+        chained_destroy(&chained);
+    }
+    printf("------------------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Lookup throughput of sequential, staged and interleaved lookups on a
+// table far larger than the CPU caches.
+//
+// The shared index maps keys to handles of 32-byte nodes in an arena, as
+// in the LRU backend, and each lookup reads the value from the found node,
+// so it pays for the index group and then the node. Keys are drawn
+// uniformly from a universe a quarter larger than the table, so about 80%
+// of lookups hit. The same stream is run as a loop of cache_index_find, as
+// staged chunks (prefetch all groups, then find and prefetch all nodes),
+// and through cache_index_find_interleaved at each group size. Every mode
+// must produce the same checksum.
+//
+// Usage: bench_interleave [keys] [lookups]
+
+#include "bench_common.h"
+#include "replacement_algorithms/cache_batch.h"
+#include "replacement_algorithms/node_arena.h"
+
+#define BENCH_PASSES 3
+#define BENCH_BATCH 1024    // Keys handed to each interleaved call
+
+static const int group_sizes[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+// Node shaped like an LRU entry
+typedef struct BenchNode {
+    uint32_t prev;
+    uint32_t next;
+    int key;
+    int value;
+    uint64_t padding[2];
+} BenchNode;
+
+// Table under test
+typedef struct Table {
+    CacheIndex index;
+    NodeArena nodes;
+} Table;
+
+static inline int scatter(long i) {
+    return (int)((uint32_t)i * 2654435761u);
+}
+
+// Value of the node behind a handle, or 0 on a miss
+static inline uint64_t node_value(const Table* table, uint32_t handle) {
+    if (handle == CACHE_INDEX_NONE) {
+        return 0;
+    }
+    return (uint64_t)(uint32_t)((const BenchNode*)node_arena_at(&table->nodes, handle))->value;
+}
+
+// One find per key
+static uint64_t run_sequential(Table* table, const int* keys, long count) {
+    uint64_t sum = 0;
+    for (long i = 0; i < count; i++) {
+        sum += node_value(table, cache_index_find(&table->index, keys[i]));
+    }
+    return sum;
+}
+
+// Chunks of CACHE_BATCH_CHUNK: prefetch every group, then find every key
+// and prefetch its node, then read the nodes
+static uint64_t run_staged(Table* table, const int* keys, long count) {
+    uint64_t sum = 0;
+    for (long base = 0; base < count; base += CACHE_BATCH_CHUNK) {
+        int n = count - base < CACHE_BATCH_CHUNK ? (int)(count - base) : CACHE_BATCH_CHUNK;
+        for (long i = base; i < base + n; i++) {
+            cache_index_prefetch(&table->index, keys[i]);
+        }
+        for (long i = base; i < base + n; i++) {
+            uint32_t handle = cache_index_find(&table->index, keys[i]);
+            if (handle != CACHE_INDEX_NONE) {
+                __builtin_prefetch(node_arena_at(&table->nodes, handle));
+            }
+        }
+        for (long i = base; i < base + n; i++) {
+            sum += node_value(table, cache_index_find(&table->index, keys[i]));
+        }
+    }
+    return sum;
+}
+
+// Interleaved lookups with group_size in flight
+static uint64_t run_interleaved(Table* table, const int* keys, long count, int group_size) {
+    uint32_t handles[BENCH_BATCH];
+    uint64_t sum = 0;
+    for (long base = 0; base < count; base += BENCH_BATCH) {
+        int n = count - base < BENCH_BATCH ? (int)(count - base) : BENCH_BATCH;
+        cache_index_find_interleaved(&table->index, keys + base, handles, n, group_size,
+                                     &table->nodes, UINT32_MAX, 0);
+        for (int i = 0; i < n; i++) {
+            sum += node_value(table, handles[i]);
+        }
+    }
+    return sum;
+}
+
+// Best of BENCH_PASSES runs of one mode, in millions of lookups per second;
+// group_size 0 is sequential and -1 staged
+static double best_rate(Table* table, const int* keys, long count, int group_size, uint64_t* sum) {
+    uint64_t best = UINT64_MAX;
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        uint64_t start = bench_now_ns();
+        if (group_size == 0) {
+            *sum = run_sequential(table, keys, count);
+        } else if (group_size < 0) {
+            *sum = run_staged(table, keys, count);
+        } else {
+            *sum = run_interleaved(table, keys, count, group_size);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return (double)count * 1e3 / (double)best;
+}
+
+int main(int argc, char** argv) {
+    long keys = bench_arg_long(argc, argv, 1, 16777216);
+    long count = bench_arg_long(argc, argv, 2, 4000000);
+    long universe = keys + keys / 4;
+
+    Table table;
+    if (cache_index_init(&table.index, (int)keys, CACHE_INDEX_PRESIZED) != 0 ||
+        node_arena_init(&table.nodes, sizeof(BenchNode), (uint32_t)keys) != 0) {
+        fprintf(stderr, "Failed to create the table\n");
+        return 1;
+    }
+    for (long i = 0; i < keys; i++) {
+        BenchNode* node = (BenchNode*)node_arena_alloc(&table.nodes);
+        node->key = scatter(i);
+        node->value = (int)i;
+        cache_index_insert(&table.index, node->key, node_arena_handle(&table.nodes, node));
+    }
+
+    int* stream = (int*)malloc((size_t)count * sizeof(int));
+    if (!stream) {
+        fprintf(stderr, "Failed to allocate the key stream\n");
+        return 1;
+    }
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (long i = 0; i < count; i++) {
+        stream[i] = scatter((long)((bench_next_random(&state) >> 8) % (uint64_t)universe));
+    }
+
+    printf("%ld keys, %ld lookups over %ld, Mlookups/s\n", keys, count, universe);
+    printf("------------------------------------------------\n");
+    printf("Mode\t\tgroup\tMlookups/s\tspeedup\n");
+    printf("------------------------------------------------\n");
+
+    uint64_t expected;
+    double sequential = best_rate(&table, stream, count, 0, &expected);
+    printf("sequential\t-\t%.2f\t\t1.00x\n", sequential);
+
+    uint64_t sum;
+    double staged = best_rate(&table, stream, count, -1, &sum);
+    printf("staged\t\t%d\t%.2f\t\t%.2fx%s\n", CACHE_BATCH_CHUNK, staged, staged / sequential,
+           sum == expected ? "" : "\tWRONG");
+    int failed = sum != expected;
+
+    for (size_t g = 0; g < sizeof(group_sizes) / sizeof(group_sizes[0]); g++) {
+        double rate = best_rate(&table, stream, count, group_sizes[g], &sum);
+        printf("interleaved\t%d\t%.2f\t\t%.2fx%s\n", group_sizes[g], rate, rate / sequential,
+               sum == expected ? "" : "\tWRONG");
+        failed |= sum != expected;
+    }
+
+    free(stream);
+    cache_index_destroy(&table.index);
+    node_arena_destroy(&table.nodes);
+    return failed;
+}
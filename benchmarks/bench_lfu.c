@@ -0,0 +1,49 @@
+// Put-under-eviction cost of the LFU backend as capacity grows.
+//
+// Every timed put inserts a key that is not resident, so each one evicts.
+// With frequency buckets the cost should stay flat from 1K to 10M entries.
+//
+// Usage: bench_lfu [max_capacity] [puts_per_run]
+
+#include "bench_common.h"
+#include "replacement_algorithms/lfu_cache.h"
+
+int main(int argc, char** argv) {
+    long max_capacity = bench_arg_long(argc, argv, 1, 10000000);
+    long puts = bench_arg_long(argc, argv, 2, 1000000);
+
+    printf("LFU put-under-eviction\n");
+    printf("------------------------------------------------\n");
+    printf("Capacity\tPuts\tns/put\n");
+    printf("------------------------------------------------\n");
+
+    for (long capacity = 1000; capacity <= max_capacity; capacity *= 10) {
+        Cache* cache = create_lfu_cache((int)capacity);
+        if (!cache) {
+            fprintf(stderr, "Failed to create cache of capacity %ld\n", capacity);
+            return 1;
+        }
+
+        // Fill the cache and give part of it a spread of frequencies
+        for (long i = 0; i < capacity; i++) {
+            put_lfu(cache, (int)i, (int)i);
+        }
+        uint64_t rng = 88172645463325252ull;
+        for (long i = 0; i < capacity; i++) {
+            get_lfu(cache, (int)(bench_next_random(&rng) % (uint64_t)capacity));
+        }
+
+        int next_key = (int)capacity;
+        uint64_t start = bench_now_ns();
+        for (long i = 0; i < puts; i++) {
+            put_lfu(cache, next_key++, (int)i);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+
+        printf("%ld\t%ld\t%.1f\n", capacity, puts, (double)elapsed / (double)puts);
+        destroy_lfu_cache(cache);
+    }
+    printf("------------------------------------------------\n");
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+// One-pass LRU miss-ratio curve against one LRU simulation per capacity.
+//
+// A Zipf(0.9) stream of gets, with one request in ten a put, is fed to
+// trace_mrc once and replayed through trace_sim with the lru backend at
+// capacities from 1/1000 of the universe up to all of it. The curve must
+// report exactly the hits each simulation counts; the program exits
+// non-zero if any capacity differs. It also reports how long the curve
+// took against the simulations it replaces.
+//
+// Usage: bench_mrc [requests] [universe]
+
+#include "bench_common.h"
+#include "trace/trace_mrc.h"
+
+static const double capacity_fractions[] = { 0.001, 0.01, 0.05, 0.1, 0.25, 0.5, 1.0 };
+
+int main(int argc, char** argv) {
+    long count = bench_arg_long(argc, argv, 1, 4000000);
+    long universe = bench_arg_long(argc, argv, 2, 1000000);
+
+    int* keys = (int*)malloc((size_t)count * sizeof(int));
+    TraceRecord* records = (TraceRecord*)malloc((size_t)count * sizeof(TraceRecord));
+    if (!keys || !records || bench_zipf_keys(keys, count, universe, 0.9, 42) != 0) {
+        fprintf(stderr, "Failed to generate the trace\n");
+        return 1;
+    }
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    for (long i = 0; i < count; i++) {
+        records[i].key = keys[i];
+        records[i].size = 1 + (uint32_t)(bench_next_random(&state) >> 54);
+        records[i].op = bench_next_random(&state) % 10 == 0 ? TRACE_PUT : TRACE_GET;
+    }
+    free(keys);
+
+    TraceMrc* mrc = trace_mrc_create();
+    uint64_t start = bench_now_ns();
+    if (!mrc || trace_mrc_replay(mrc, records, (size_t)count) != 0) {
+        fprintf(stderr, "Failed to build the curve\n");
+        return 1;
+    }
+    uint64_t mrc_ns = bench_now_ns() - start;
+
+    printf("%ld requests over %ld keys, curve up to capacity %zu in %.3f s\n", count, universe,
+           trace_mrc_max_distance(mrc), (double)mrc_ns / 1e9);
+    printf("------------------------------------------------------------\n");
+    printf("Capacity\tMRC miss\tLRU miss\tLRU sim s\n");
+    printf("------------------------------------------------------------\n");
+
+    int failed = 0;
+    uint64_t sim_ns = 0;
+    for (size_t i = 0; i < sizeof(capacity_fractions) / sizeof(capacity_fractions[0]); i++) {
+        int capacity = (int)(universe * capacity_fractions[i]);
+        capacity = capacity > 0 ? capacity : 1;
+
+        TraceSim sim;
+        if (trace_sim_init(&sim, "lru", capacity, 0) != 0) {
+            fprintf(stderr, "Failed to create an LRU cache of %d\n", capacity);
+            return 1;
+        }
+        trace_sim_replay(&sim, records, (size_t)count);
+        TraceSimStats expected, actual;
+        trace_sim_get_stats(&sim, &expected);
+        trace_sim_destroy(&sim);
+        trace_mrc_stats(mrc, (size_t)capacity, &actual);
+        sim_ns += expected.elapsed_ns;
+
+        int same = actual.hits == expected.hits && actual.hit_bytes == expected.hit_bytes &&
+                   actual.requests == expected.requests;
+        printf("%d\t\t%.4f\t\t%.4f\t\t%.3f%s\n", capacity,
+               1.0 - (double)actual.hits / (double)actual.requests,
+               1.0 - (double)expected.hits / (double)expected.requests,
+               (double)expected.elapsed_ns / 1e9, same ? "" : "\tWRONG");
+        failed |= !same;
+    }
+    printf("------------------------------------------------------------\n");
+    printf("Curve: %.3f s for every capacity; simulations: %.3f s for %zu\n", (double)mrc_ns / 1e9,
+           (double)sim_ns / 1e9, sizeof(capacity_fractions) / sizeof(capacity_fractions[0]));
+
+    trace_mrc_destroy(mrc);
+    free(records);
+    return failed;
+}
@@ -0,0 +1,164 @@
+// Throughput scaling of the sharded cache from 1 to max threads.
+//
+// A fixed stream of get, plus put on a miss, is split evenly across the
+// threads, so perfect scaling halves the elapsed time each time the
+// thread count doubles. One shard behind a mutex stands in for wrapping a
+// whole cache in one lock; it is compared with the configured shard count
+// under each lock kind, on Zipf and uniform keys over four times the
+// capacity. Caches are warmed with one single-threaded pass first, and
+// each figure is the best of BENCH_PASSES.
+//
+// Usage: bench_sharded [capacity] [operations] [shards] [max threads] [policy]
+
+#include "bench_common.h"
+#include "replacement_algorithms/sharded_cache.h"
+#include <pthread.h>
+
+#define BENCH_PASSES 3
+
+// One thread's share of the stream
+typedef struct Worker {
+    pthread_t thread;
+    ShardedCache* cache;
+    pthread_barrier_t* start;
+    const int* keys;
+    long count;
+    uint64_t begin;         // When this thread started and finished its slice
+    uint64_t end;
+} Worker;
+
+// Replay a slice of the stream
+static void replay(ShardedCache* cache, const int* keys, long count) {
+    for (long i = 0; i < count; i++) {
+        if (sharded_cache_get(cache, keys[i]) == -1) {
+            sharded_cache_put(cache, keys[i], (int)i);
+        }
+    }
+}
+
+static void* run_worker(void* arg) {
+    Worker* worker = (Worker*)arg;
+    pthread_barrier_wait(worker->start);
+    worker->begin = bench_now_ns();
+    replay(worker->cache, worker->keys, worker->count);
+    worker->end = bench_now_ns();
+    return NULL;
+}
+
+// Millions of operations per second with the stream split across threads
+static double run_threads(ShardedCache* cache, const int* keys, long count, int threads) {
+    Worker workers[threads];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, (unsigned)threads + 1);
+
+    for (int t = 0; t < threads; t++) {
+        long first = count * t / threads;
+        workers[t].cache = cache;
+        workers[t].start = &start;
+        workers[t].keys = keys + first;
+        workers[t].count = count * (t + 1) / threads - first;
+        pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]);
+    }
+
+    // Time from the first thread starting to the last one finishing; the
+    // main thread may not run again until well after the barrier opens
+    pthread_barrier_wait(&start);
+    uint64_t begin = UINT64_MAX;
+    uint64_t end = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        begin = workers[t].begin < begin ? workers[t].begin : begin;
+        end = workers[t].end > end ? workers[t].end : end;
+    }
+    uint64_t elapsed = end - begin;
+
+    pthread_barrier_destroy(&start);
+    return (double)count * 1e3 / (double)elapsed;
+}
+
+int main(int argc, char** argv) {
+    long capacity = bench_arg_long(argc, argv, 1, 262144);
+    long count = bench_arg_long(argc, argv, 2, 1000000);
+    int shards = (int)bench_arg_long(argc, argv, 3, 64);
+    int max_threads = (int)bench_arg_long(argc, argv, 4, 64);
+    const char* policy = argc > 5 ? argv[5] : "lru";
+    long universe = capacity * 4;
+
+    const struct {
+        const char* name;
+        int shards;
+        ShardLockKind lock;
+    } configs[] = {
+        { "1 mutex", 1, SHARD_LOCK_MUTEX },
+        { "spin", shards, SHARD_LOCK_SPIN },
+        { "mutex", shards, SHARD_LOCK_MUTEX },
+        { "rwlock", shards, SHARD_LOCK_RWLOCK },
+    };
+    const int config_count = (int)(sizeof(configs) / sizeof(configs[0]));
+
+    int* zipf = (int*)malloc((size_t)count * sizeof(int));
+    int* uniform = (int*)malloc((size_t)count * sizeof(int));
+    if (!zipf || !uniform || bench_zipf_keys(zipf, count, universe, 0.99, 0x9e3779b97f4a7c15ull) != 0) {
+        fprintf(stderr, "Failed to generate the key streams\n");
+        return 1;
+    }
+    uint64_t state = 0x2545f4914f6cdd1dull;
+    for (long i = 0; i < count; i++) {
+        uniform[i] = (int)(bench_next_random(&state) % (uint64_t)universe);
+    }
+
+    const struct {
+        const char* name;
+        const int* keys;
+    } streams[] = {
+        { "Zipf 0.99", zipf },
+        { "Uniform", uniform },
+    };
+
+    printf("%s, capacity %ld, %ld operations split across the threads, Mops/s\n",
+           policy, capacity, count);
+
+    for (int s = 0; s < 2; s++) {
+        ShardedCache* caches[config_count];
+        for (int c = 0; c < config_count; c++) {
+            ShardedCacheConfig config = { (int)capacity, configs[c].shards, configs[c].lock,
+                                          CACHE_INDEX_PRESIZED };
+            caches[c] = sharded_cache_create(policy, &config);
+            if (!caches[c]) {
+                fprintf(stderr, "Failed to create a %s cache\n", policy);
+                return 1;
+            }
+            replay(caches[c], streams[s].keys, count);  // Warm up
+        }
+
+        printf("\n%s over %ld keys (%d shards)\n", streams[s].name, universe,
+               sharded_cache_shard_count(caches[1]));
+        printf("------------------------------------------------\n");
+        printf("Threads");
+        for (int c = 0; c < config_count; c++) {
+            printf("\t%s", configs[c].name);
+        }
+        printf("\n------------------------------------------------\n");
+
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            printf("%d", threads);
+            for (int c = 0; c < config_count; c++) {
+                double best = 0;
+                for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                    double mops = run_threads(caches[c], streams[s].keys, count, threads);
+                    best = mops > best ? mops : best;
+                }
+                printf("\t%.2f", best);
+            }
+            printf("\n");
+        }
+
+        for (int c = 0; c < config_count; c++) {
+            sharded_cache_destroy(caches[c]);
+        }
+    }
+
+    free(zipf);
+    free(uniform);
+    return 0;
+}
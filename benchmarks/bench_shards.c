@@ -0,0 +1,150 @@
+// Accuracy and cost of SHARDS miniature simulations against full ones.
+//
+// Three synthetic get traces are replayed: Zipf(0.8), Zipf(1.0), and a mix
+// of Zipf(0.9) with a cyclic loop over a fifth of the keys, which LRU-like
+// policies handle badly and scan-resistant ones don't. For each policy
+// the full hit ratio at capacities of 1% to 50% of the keys is compared
+// with fixed-rate SHARDS at rate 0.01 and fixed-size SHARDS with 8192
+// sampled keys. The error is in percentage points of hit ratio: the mean
+// and the worst absolute error over the capacities.
+//
+// Usage: bench_shards [requests] [universe] [policy]
+
+#include <string.h>
+#include "bench_common.h"
+#include "trace/trace_shards.h"
+
+#define SHARDS_RATE 0.01
+#define SHARDS_KEYS 8192
+
+static const double capacity_fractions[] = { 0.01, 0.05, 0.1, 0.25, 0.5 };
+#define CAPACITY_COUNT ((int)(sizeof(capacity_fractions) / sizeof(capacity_fractions[0])))
+
+static const char* const trace_names[] = { "zipf-0.8", "zipf-1.0", "zipf+loop" };
+
+// Fill records with trace t
+static int make_trace(int t, TraceRecord* records, int* keys, long count, long universe) {
+    double exponent = t == 0 ? 0.8 : t == 1 ? 1.0 : 0.9;
+    if (bench_zipf_keys(keys, count, universe, exponent, 7 + (uint64_t)t) != 0) {
+        return -1;
+    }
+
+    long loop = universe / 5;
+    long position = 0;
+    for (long i = 0; i < count; i++) {
+        records[i].key = keys[i];
+        records[i].size = 1;
+        records[i].op = TRACE_GET;
+        if (t == 2 && (i & 1)) {
+            // Loop keys sit above the Zipf ones
+            records[i].key = (int)((uint32_t)(universe + position) * 2654435761u);
+            position = (position + 1) % loop;
+        }
+    }
+    return 0;
+}
+
+static double hit_ratio(const TraceSimStats* stats) {
+    return stats->requests ? 100.0 * (double)stats->hits / (double)stats->requests : 0.0;
+}
+
+// Estimate with one SHARDS mode, adding its errors against full[] and its
+// time; returns -1 if the sampler can't be created
+static int run_shards(const char* policy, TraceShardsMode mode, const int* capacities,
+                      const TraceRecord* records, long count, const double* full,
+                      double* mean_error, double* max_error, uint64_t* elapsed) {
+    TraceShardsConfig config = { policy, capacities, CAPACITY_COUNT, mode, SHARDS_RATE, SHARDS_KEYS, 0 };
+    TraceShards* shards = trace_shards_create(&config);
+    if (!shards || trace_shards_replay(shards, records, (size_t)count) != 0) {
+        trace_shards_destroy(shards);
+        return -1;
+    }
+
+    *mean_error = 0.0;
+    *max_error = 0.0;
+    for (int c = 0; c < CAPACITY_COUNT; c++) {
+        TraceSimStats stats;
+        trace_shards_stats(shards, c, &stats);
+        double error = fabs(hit_ratio(&stats) - full[c]);
+        *mean_error += error / CAPACITY_COUNT;
+        *max_error = error > *max_error ? error : *max_error;
+        *elapsed = stats.elapsed_ns;
+    }
+    trace_shards_destroy(shards);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    long count = bench_arg_long(argc, argv, 1, 2000000);
+    long universe = bench_arg_long(argc, argv, 2, 500000);
+    const char* only = argc > 3 ? argv[3] : NULL;
+
+    int capacities[CAPACITY_COUNT];
+    for (int c = 0; c < CAPACITY_COUNT; c++) {
+        capacities[c] = (int)(universe * capacity_fractions[c]);
+        capacities[c] = capacities[c] > 0 ? capacities[c] : 1;
+    }
+
+    int* keys = (int*)malloc((size_t)count * sizeof(int));
+    TraceRecord* records = (TraceRecord*)malloc((size_t)count * sizeof(TraceRecord));
+    if (!keys || !records) {
+        fprintf(stderr, "Failed to allocate the trace\n");
+        return 1;
+    }
+
+    printf("%ld gets over %ld keys, capacities 1%%-50%% of the keys, hit ratio error in points\n",
+           count, universe);
+    printf("fixed rate %.2f, fixed size %d keys; time in ms (full is all capacities)\n",
+           SHARDS_RATE, SHARDS_KEYS);
+
+    for (int t = 0; t < (int)(sizeof(trace_names) / sizeof(trace_names[0])); t++) {
+        if (make_trace(t, records, keys, count, universe) != 0) {
+            fprintf(stderr, "Failed to generate %s\n", trace_names[t]);
+            return 1;
+        }
+
+        printf("\n%s\n", trace_names[t]);
+        printf("------------------------------------------------------------------------------\n");
+        printf("Policy\t\tfull ms\trate mean\trate max\trate ms\tsize mean\tsize max\tsize ms\n");
+        printf("------------------------------------------------------------------------------\n");
+        for (size_t p = 0; p < cache_policy_count(); p++) {
+            const CacheOps* ops = cache_policy_at(p);
+            if (only && strcmp(only, ops->name) != 0) {
+                continue;
+            }
+
+            double full[CAPACITY_COUNT];
+            uint64_t full_ns = 0;
+            for (int c = 0; c < CAPACITY_COUNT; c++) {
+                TraceSim sim;
+                if (trace_sim_init(&sim, ops->name, capacities[c], 0) != 0) {
+                    fprintf(stderr, "Failed to create a %s cache\n", ops->name);
+                    return 1;
+                }
+                trace_sim_replay(&sim, records, (size_t)count);
+                TraceSimStats stats;
+                trace_sim_get_stats(&sim, &stats);
+                trace_sim_destroy(&sim);
+                full[c] = hit_ratio(&stats);
+                full_ns += stats.elapsed_ns;
+            }
+
+            double rate_mean, rate_max, size_mean, size_max;
+            uint64_t rate_ns = 0, size_ns = 0;
+            if (run_shards(ops->name, TRACE_SHARDS_FIXED_RATE, capacities, records, count, full,
+                           &rate_mean, &rate_max, &rate_ns) != 0 ||
+                run_shards(ops->name, TRACE_SHARDS_FIXED_SIZE, capacities, records, count, full,
+                           &size_mean, &size_max, &size_ns) != 0) {
+                fprintf(stderr, "Failed to sample for %s\n", ops->name);
+                return 1;
+            }
+            printf("%-12s\t%.0f\t%.2f\t\t%.2f\t\t%.0f\t%.2f\t\t%.2f\t\t%.0f\n", ops->label,
+                   (double)full_ns / 1e6, rate_mean, rate_max, (double)rate_ns / 1e6,
+                   size_mean, size_max, (double)size_ns / 1e6);
+        }
+    }
+
+    free(keys);
+    free(records);
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Speed and sanity of the workload generators in trace/trace_workload.h.
+//
+// Each kind fills a 64K-key buffer over and over until it has produced the
+// requested number of keys, and reports ns per key; Zipf is also timed as
+// whole requests (10% puts, sizes 1-4096) and against bench_zipf_keys,
+// which builds a CDF table and binary-searches it. Then the Zipf sampler
+// is checked at several exponents: the counts of the ten most popular
+// ranks must lie within five standard deviations of r^-alpha / H(n,
+// alpha). Scrambled Zipf must map the ranks to distinct keys. Exits
+// non-zero if a check fails.
+//
+// Usage: bench_workload [count] [keys]
+
+#include <string.h>
+#include "bench_common.h"
+#include "trace/trace_workload.h"
+
+#define BUFFER_KEYS 65536
+#define TOP_RANKS 10
+
+static const double check_alphas[] = { 0.5, 0.99, 1.0, 1.2, 2.0 };
+
+// ns per key to generate count keys of config's stream
+static double time_keys(const TraceWorkloadConfig* config, long count, int* buffer) {
+    TraceWorkload workload;
+    trace_workload_init(&workload, config);
+    uint64_t start = bench_now_ns();
+    for (long done = 0; done < count; done += BUFFER_KEYS) {
+        size_t n = count - done < BUFFER_KEYS ? (size_t)(count - done) : BUFFER_KEYS;
+        trace_workload_keys(&workload, buffer, n);
+    }
+    return (double)(bench_now_ns() - start) / (double)count;
+}
+
+// Check the top ranks' frequencies at one exponent; returns 0 if they fit
+static int check_zipf(double alpha, long count, int keys, int* buffer) {
+    TraceWorkloadConfig config;
+    trace_workload_config_default(&config, TRACE_WORKLOAD_ZIPF, keys);
+    config.alpha = alpha;
+    config.seed = 11;
+    TraceWorkload workload;
+    trace_workload_init(&workload, &config);
+
+    uint64_t counts[TOP_RANKS] = { 0 };
+    for (long done = 0; done < count; done += BUFFER_KEYS) {
+        size_t n = count - done < BUFFER_KEYS ? (size_t)(count - done) : BUFFER_KEYS;
+        trace_workload_keys(&workload, buffer, n);
+        for (size_t i = 0; i < n; i++) {
+            if (buffer[i] < TOP_RANKS) {
+                counts[buffer[i]]++;
+            }
+        }
+    }
+
+    double total = 0;
+    for (int r = 1; r <= keys; r++) {
+        total += pow((double)r, -alpha);
+    }
+    double worst = 0;
+    for (int r = 0; r < TOP_RANKS && r < keys; r++) {
+        double expected = (double)count * pow((double)(r + 1), -alpha) / total;
+        double deviations = fabs((double)counts[r] - expected) / sqrt(expected > 1 ? expected : 1);
+        worst = deviations > worst ? deviations : worst;
+    }
+    printf("zipf alpha %.2f: top %d ranks within %.2f standard deviations%s\n", alpha, TOP_RANKS,
+           worst, worst <= 5.0 ? "" : "\tWRONG");
+    return worst <= 5.0 ? 0 : 1;
+}
+
+// Check that scrambling maps 0..keys-1 onto distinct keys in range
+static int check_scramble(int keys) {
+    TraceWorkloadConfig config;
+    trace_workload_config_default(&config, TRACE_WORKLOAD_SCRAMBLED_ZIPF, keys);
+    TraceWorkload workload;
+    trace_workload_init(&workload, &config);
+
+    unsigned char* seen = (unsigned char*)calloc((size_t)keys, 1);
+    int failed = !seen;
+    for (int k = 0; !failed && k < keys; k++) {
+        int key = trace_workload_scramble(&workload, k);
+        failed = key < 0 || key >= keys || seen[key]++ != 0;
+    }
+    free(seen);
+    printf("scrambled-zipf over %d keys: %s\n", keys, failed ? "collision\tWRONG" : "a permutation");
+    return failed;
+}
+
+int main(int argc, char** argv) {
+    long count = bench_arg_long(argc, argv, 1, 20000000);
+    int keys = (int)bench_arg_long(argc, argv, 2, 1000000);
+
+    int* buffer = (int*)malloc(BUFFER_KEYS * sizeof(int));
+    TraceRecord* records = (TraceRecord*)malloc(BUFFER_KEYS * sizeof(TraceRecord));
+    int* table_keys = (int*)malloc((size_t)count * sizeof(int));
+    if (!buffer || !records || !table_keys) {
+        fprintf(stderr, "Failed to allocate buffers\n");
+        return 1;
+    }
+
+    printf("%ld keys from a space of %d, ns per key\n", count, keys);
+    printf("----------------------------------------\n");
+    for (int kind = TRACE_WORKLOAD_ZIPF; kind <= TRACE_WORKLOAD_HOTSPOT; kind++) {
+        TraceWorkloadConfig config;
+        trace_workload_config_default(&config, (TraceWorkloadKind)kind, keys);
+        printf("%-24s %.2f\n", trace_workload_kind_name((TraceWorkloadKind)kind),
+               time_keys(&config, count, buffer));
+    }
+
+    TraceWorkloadConfig config;
+    trace_workload_config_default(&config, TRACE_WORKLOAD_ZIPF, keys);
+    config.put_ratio = 0.1;
+    config.max_size = 4096;
+    TraceWorkload workload;
+    trace_workload_init(&workload, &config);
+    uint64_t start = bench_now_ns();
+    for (long done = 0; done < count; done += BUFFER_KEYS) {
+        size_t n = count - done < BUFFER_KEYS ? (size_t)(count - done) : BUFFER_KEYS;
+        trace_workload_records(&workload, records, n);
+    }
+    printf("%-24s %.2f\n", "zipf records", (double)(bench_now_ns() - start) / (double)count);
+
+    start = bench_now_ns();
+    bench_zipf_keys(table_keys, count, keys, 0.99, 1);
+    printf("%-24s %.2f\n", "bench_zipf_keys (table)", (double)(bench_now_ns() - start) / (double)count);
+    printf("----------------------------------------\n");
+
+    int failed = 0;
+    for (size_t a = 0; a < sizeof(check_alphas) / sizeof(check_alphas[0]); a++) {
+        failed |= check_zipf(check_alphas[a], count, keys, buffer);
+    }
+    failed |= check_scramble(keys);
+
+    free(buffer);
+    free(records);
+    free(table_keys);
+    return failed;
+}
@@ -0,0 +1,430 @@
+#include "arc_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <string.h>
+
+// Adaptive Replacement Cache (Megiddo & Modha). Resident entries live in
+// T1 (seen once recently) or T2 (seen at least twice); B1 and B2 remember
+// the keys recently evicted from each. A hit in B1 means T1 was too small,
+// a hit in B2 that T2 was, and the target size p of T1 moves accordingly.
+//
+// Every list is an intrusive doubly linked list of 32-bit handles. The list
+// an entry is on is kept in the top two bits of its index handle, so ghost
+// entries hold nothing but their key and links.
+
+enum { ARC_T1, ARC_T2, ARC_B1, ARC_B2, ARC_LISTS };
+
+#define ARC_LIST_SHIFT 30
+#define ARC_HANDLE_MASK ((1u << ARC_LIST_SHIFT) - 1)
+#define ARC_MAX_CAPACITY ((int)ARC_HANDLE_MASK)
+
+// Ghost entry, and the first part of every resident one
+typedef struct ArcLink {
+    int key;
+    uint32_t prev;
+    uint32_t next;
+} ArcLink;
+
+// Resident entry
+typedef struct ArcNode {
+    ArcLink link;
+    int value;
+} ArcNode;
+
+// One of the four lists, head is most recently used
+typedef struct ArcList {
+    NodeArena* arena;       // Where this list's entries are stored
+    uint32_t head;
+    uint32_t tail;
+    int size;
+} ArcList;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;       // Resident and ghost keys
+    NodeArena nodes;        // Entries of T1 and T2
+    NodeArena ghosts;       // Entries of B1 and B2
+    ArcList lists[ARC_LISTS];
+    int p;                  // Target size of T1
+    uint64_t evictions;
+    int capacity;
+};
+
+static ArcLink* link_at(const ArcList* list, uint32_t handle) {
+    return (ArcLink*)node_arena_at(list->arena, handle);
+}
+
+// Index handle for an entry of the given list
+static uint32_t tag_handle(int list, uint32_t handle) {
+    return (uint32_t)list << ARC_LIST_SHIFT | handle;
+}
+
+// Add an entry at the most recently used end of a list
+static void list_push_front(ArcList* list, uint32_t handle) {
+    ArcLink* link = link_at(list, handle);
+
+    link->prev = NODE_ARENA_NONE;
+    link->next = list->head;
+    if (list->head != NODE_ARENA_NONE) {
+        link_at(list, list->head)->prev = handle;
+    } else {
+        list->tail = handle;
+    }
+    list->head = handle;
+    list->size++;
+}
+
+// Remove an entry from a list
+static void list_unlink(ArcList* list, uint32_t handle) {
+    ArcLink* link = link_at(list, handle);
+
+    if (link->prev != NODE_ARENA_NONE) {
+        link_at(list, link->prev)->next = link->next;
+    } else {
+        list->head = link->next;
+    }
+
+    if (link->next != NODE_ARENA_NONE) {
+        link_at(list, link->next)->prev = link->prev;
+    } else {
+        list->tail = link->prev;
+    }
+    list->size--;
+}
+
+static int resident_size(const Cache* cache) {
+    return cache->lists[ARC_T1].size + cache->lists[ARC_T2].size;
+}
+
+// Forget the oldest ghost of B1 or B2
+static void drop_ghost(Cache* cache, int list_id) {
+    ArcList* list = &cache->lists[list_id];
+    uint32_t handle = list->tail;
+    ArcLink* ghost = link_at(list, handle);
+
+    list_unlink(list, handle);
+    cache_index_remove(&cache->index, ghost->key);
+    node_arena_free(&cache->ghosts, ghost);
+}
+
+// Evict the least recently used entry of T1 or T2 and remember its key in
+// the matching ghost list
+static void demote(Cache* cache, int list_id) {
+    ArcList* list = &cache->lists[list_id];
+    uint32_t handle = list->tail;
+    ArcNode* node = (ArcNode*)link_at(list, handle);
+    int key = node->link.key;
+
+    list_unlink(list, handle);
+    node_arena_free(&cache->nodes, node);
+    cache->evictions++;
+
+    ArcLink* ghost = (ArcLink*)node_arena_alloc(&cache->ghosts);
+    ArcList* ghost_list = &cache->lists[list_id + ARC_B1];
+    uint32_t ghost_handle = node_arena_handle(&cache->ghosts, ghost);
+
+    ghost->key = key;
+    list_push_front(ghost_list, ghost_handle);
+    cache_index_update(&cache->index, key, tag_handle(list_id + ARC_B1, ghost_handle));
+}
+
+// Make room for one resident entry: shrink T1 if it is over its target
+// (or at it, when the request was a B2 hit), otherwise shrink T2
+static void replace(Cache* cache, int in_b2) {
+    int t1 = cache->lists[ARC_T1].size;
+
+    if (t1 > 0 && (t1 > cache->p || (in_b2 && t1 == cache->p) ||
+                   cache->lists[ARC_T2].size == 0)) {
+        demote(cache, ARC_T1);
+    } else {
+        demote(cache, ARC_T2);
+    }
+}
+
+// Evict the least recently used entry of T1 without keeping a ghost
+static void discard_t1(Cache* cache) {
+    ArcList* list = &cache->lists[ARC_T1];
+    uint32_t handle = list->tail;
+    ArcNode* node = (ArcNode*)link_at(list, handle);
+
+    list_unlink(list, handle);
+    cache_index_remove(&cache->index, node->link.key);
+    node_arena_free(&cache->nodes, node);
+    cache->evictions++;
+}
+
+// Allocate a resident entry and put it at the front of T1 or T2
+static ArcNode* create_node(Cache* cache, int list_id, int key, int value) {
+    ArcNode* node = (ArcNode*)node_arena_alloc(&cache->nodes);
+    if (node) {
+        node->link.key = key;
+        node->value = value;
+        list_push_front(&cache->lists[list_id], node_arena_handle(&cache->nodes, node));
+    }
+    return node;
+}
+
+// Move a resident entry to the front of T2
+static void promote(Cache* cache, int list_id, uint32_t handle) {
+    list_unlink(&cache->lists[list_id], handle);
+    list_push_front(&cache->lists[ARC_T2], handle);
+
+    if (list_id != ARC_T2) {
+        int key = link_at(&cache->lists[ARC_T2], handle)->key;
+        cache_index_update(&cache->index, key, tag_handle(ARC_T2, handle));
+    }
+}
+
+// Create a new cache
+Cache* create_arc_cache(int capacity) {
+    return create_arc_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_arc_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0 || capacity > ARC_MAX_CAPACITY) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    // The index holds resident and ghost keys, at most twice the capacity
+    if (cache_index_init(&cache->index, 2 * capacity, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(ArcNode), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->ghosts, sizeof(ArcLink), (uint32_t)capacity) != 0) {
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    for (int i = 0; i < ARC_LISTS; i++) {
+        cache->lists[i].arena = i < ARC_B1 ? &cache->nodes : &cache->ghosts;
+        cache->lists[i].head = NODE_ARENA_NONE;
+        cache->lists[i].tail = NODE_ARENA_NONE;
+        cache->lists[i].size = 0;
+    }
+    cache->p = 0;
+    cache->evictions = 0;
+    cache->capacity = capacity;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_arc_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    node_arena_destroy(&cache->ghosts);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
+    free(cache);
+}
+
+// Get value from cache
+int get_arc(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t tagged = cache_index_find(&cache->index, key);
+    int list_id = (int)(tagged >> ARC_LIST_SHIFT);
+    if (tagged == CACHE_INDEX_NONE || list_id >= ARC_B1) {
+        return -1;  // Key not found (ghosts hold no value)
+    }
+
+    uint32_t handle = tagged & ARC_HANDLE_MASK;
+    promote(cache, list_id, handle);
+    return ((ArcNode*)node_arena_at(&cache->nodes, handle))->value;
+}
+
+// Put value in cache
+void put_arc(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    uint32_t tagged = cache_index_find(&cache->index, key);
+    int capacity = cache->capacity;
+
+    if (tagged != CACHE_INDEX_NONE) {
+        int list_id = (int)(tagged >> ARC_LIST_SHIFT);
+        uint32_t handle = tagged & ARC_HANDLE_MASK;
+
+        // Resident: update and count it as a second reference
+        if (list_id < ARC_B1) {
+            ((ArcNode*)node_arena_at(&cache->nodes, handle))->value = value;
+            promote(cache, list_id, handle);
+            return;
+        }
+
+        // Ghost hit: grow the target of the list it was evicted from
+        int b1 = cache->lists[ARC_B1].size;
+        int b2 = cache->lists[ARC_B2].size;
+        if (list_id == ARC_B1) {
+            int delta = b1 >= b2 ? 1 : b2 / b1;
+            cache->p = cache->p + delta < capacity ? cache->p + delta : capacity;
+        } else {
+            int delta = b2 >= b1 ? 1 : b1 / b2;
+            cache->p = cache->p - delta > 0 ? cache->p - delta : 0;
+        }
+
+        list_unlink(&cache->lists[list_id], handle);
+        node_arena_free(&cache->ghosts, node_arena_at(&cache->ghosts, handle));
+        if (resident_size(cache) >= capacity) {
+            replace(cache, list_id == ARC_B2);
+        }
+
+        ArcNode* node = create_node(cache, ARC_T2, key, value);
+        if (!node) {
+            cache_index_remove(&cache->index, key);
+            return;
+        }
+        cache_index_update(&cache->index, key,
+                           tag_handle(ARC_T2, node_arena_handle(&cache->nodes, node)));
+        return;
+    }
+
+    // New key
+    int l1 = cache->lists[ARC_T1].size + cache->lists[ARC_B1].size;
+    int total = l1 + cache->lists[ARC_T2].size + cache->lists[ARC_B2].size;
+
+    if (l1 >= capacity) {
+        if (cache->lists[ARC_T1].size < capacity) {
+            drop_ghost(cache, ARC_B1);
+            if (resident_size(cache) >= capacity) {
+                replace(cache, 0);  // Not full if entries were erased
+            }
+        } else {
+            discard_t1(cache);
+        }
+    } else if (total >= capacity) {
+        if (total >= 2 * capacity) {
+            drop_ghost(cache, ARC_B2);
+        }
+        if (resident_size(cache) >= capacity) {
+            replace(cache, 0);
+        }
+    }
+
+    ArcNode* node = create_node(cache, ARC_T1, key, value);
+    if (!node) {
+        return;
+    }
+    uint32_t handle = node_arena_handle(&cache->nodes, node);
+    if (cache_index_insert(&cache->index, key, tag_handle(ARC_T1, handle)) != 0) {
+        list_unlink(&cache->lists[ARC_T1], handle);
+        node_arena_free(&cache->nodes, node);
+    }
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(arc, nodes, ARC_HANDLE_MASK, (uint32_t)ARC_B1 << ARC_LIST_SHIFT)
+
+// Remove key from the cache; returns -1 if it was not cached. Ghosts are
+// left alone, since they hold no value
+int erase_arc(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t tagged = cache_index_find(&cache->index, key);
+    int list_id = (int)(tagged >> ARC_LIST_SHIFT);
+    if (tagged == CACHE_INDEX_NONE || list_id >= ARC_B1) {
+        return -1;
+    }
+
+    uint32_t handle = tagged & ARC_HANDLE_MASK;
+    list_unlink(&cache->lists[list_id], handle);
+    cache_index_remove(&cache->index, key);
+    node_arena_free(&cache->nodes, node_arena_at(&cache->nodes, handle));
+    return 0;
+}
+
+// Evict the entry a new key would displace, keeping its ghost; returns -1
+// if the cache is empty. The oldest ghost is forgotten first if the ghost
+// lists are full
+int evict_arc(Cache* cache) {
+    if (!cache || resident_size(cache) == 0) {
+        return -1;
+    }
+
+    if (cache->lists[ARC_B1].size + cache->lists[ARC_B2].size >= cache->capacity) {
+        drop_ghost(cache, cache->lists[ARC_B2].size > 0 ? ARC_B2 : ARC_B1);
+    }
+    replace(cache, 0);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. The target p is clamped to it, entries are
+// evicted to their ghost lists as evict_arc picks them, and the oldest
+// ghosts are forgotten until B1 and B2 together, and T1 and B1 together,
+// fit the new capacity again
+int resize_arc(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    cache->capacity = capacity;
+    cache->p = cache->p < capacity ? cache->p : capacity;
+    while (resident_size(cache) > capacity) {
+        evict_arc(cache);
+    }
+    while (cache->lists[ARC_B1].size + cache->lists[ARC_B2].size > capacity) {
+        drop_ghost(cache, cache->lists[ARC_B2].size > 0 ? ARC_B2 : ARC_B1);
+    }
+    while (cache->lists[ARC_T1].size + cache->lists[ARC_B1].size > capacity) {
+        drop_ghost(cache, ARC_B1);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_arc_stats(Cache* cache, CacheStats* stats) {
+    stats->size = resident_size(cache);
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print cache contents
+void print_arc_cache_contents(Cache* cache, const char* message) {
+    static const char* names[] = { "T1", "T2" };
+
+    printf("\n%s:\n", message);
+    printf("Cache contents (T1 then T2, Most → Least Recent):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tList\n");
+    printf("------------------------------------------------\n");
+
+    for (int list_id = ARC_T1; list_id <= ARC_T2; list_id++) {
+        const ArcList* list = &cache->lists[list_id];
+        for (uint32_t handle = list->head; handle != NODE_ARENA_NONE;
+             handle = link_at(list, handle)->next) {
+            ArcNode* current = (ArcNode*)link_at(list, handle);
+            printf("%d\t%d\t%s\n",
+                   current->link.key,
+                   current->value,
+                   names[list_id]);
+        }
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d (target T1 size %d, ghosts B1 %d, B2 %d)\n",
+           resident_size(cache), cache->capacity, cache->p,
+           cache->lists[ARC_B1].size, cache->lists[ARC_B2].size);
+}
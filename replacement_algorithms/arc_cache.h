@@ -0,0 +1,21 @@
+#ifndef ARC_CACHE_H
+#define ARC_CACHE_H
+
+#include "cache_interface.h"
+
+Cache* create_arc_cache(int capacity);
+Cache* create_arc_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_arc_cache(Cache* cache);
+int get_arc(Cache* cache, int key);
+void put_arc(Cache* cache, int key, int value);
+void get_many_arc(Cache* cache, const int* keys, int* values, int count);
+void put_many_arc(Cache* cache, const int* keys, const int* values, int count);
+int erase_arc(Cache* cache, int key);
+int evict_arc(Cache* cache);
+int resize_arc(Cache* cache, int capacity);
+void get_arc_stats(Cache* cache, CacheStats* stats);
+void print_arc_cache_contents(Cache* cache, const char* message);
+
+// ARC specific declarations can be added here if needed
+
+#endif // ARC_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef CACHE_BATCH_H
+#define CACHE_BATCH_H
+
+#include "cache_index.h"
+#include "node_arena.h"
+
+// Batched get/put for the backends.
+//
+// A lookup that misses the CPU caches waits first for the index group and
+// then for the node, and a loop of single gets waits for each key in turn.
+// The batch calls work through the keys CACHE_BATCH_CHUNK at a time: the
+// chunk is first looked up with cache_index_find_interleaved, which keeps
+// CACHE_BATCH_INTERLEAVE lookups in flight and also loads each found
+// key's node, and only then is the ordinary get or put run on each key in
+// order. The misses of a whole chunk overlap, and the policy sees exactly
+// the calls a loop would make.
+
+#define CACHE_BATCH_CHUNK 32        // Keys looked up before any is resolved
+#define CACHE_BATCH_INTERLEAVE 16   // Lookups in flight at once
+
+// Bring the index lines and nodes of up to CACHE_BATCH_CHUNK keys into
+// the CPU caches. A present key's node is handle & mask in nodes, unless
+// handle & skip marks an entry without one (a ghost). The handles are
+// dropped: the get or put that follows repeats the lookup on cached lines
+static inline void cache_batch_prefetch(CacheIndex* index, const NodeArena* nodes,
+                                        uint32_t mask, uint32_t skip,
+                                        const int* keys, int count) {
+    uint32_t handles[CACHE_BATCH_CHUNK];
+    cache_index_find_interleaved(index, keys, handles, count, CACHE_BATCH_INTERLEAVE,
+                                 nodes, mask, skip);
+}
+
+// Define get_many_<ops> and put_many_<ops> for a backend whose Cache has
+// an index member and its nodes in the arena member nodes
+#define CACHE_BATCH_DEFINE(ops, nodes, mask, skip) \
+    void get_many_##ops(Cache* cache, const int* keys, int* values, int count) { \
+        for (int base = 0; base < count; base += CACHE_BATCH_CHUNK) { \
+            int n = count - base < CACHE_BATCH_CHUNK ? count - base : CACHE_BATCH_CHUNK; \
+            if (cache) { \
+                cache_batch_prefetch(&cache->index, &cache->nodes, mask, skip, keys + base, n); \
+            } \
+            for (int i = base; i < base + n; i++) { \
+                values[i] = get_##ops(cache, keys[i]); \
+            } \
+        } \
+    } \
+    void put_many_##ops(Cache* cache, const int* keys, const int* values, int count) { \
+        for (int base = 0; base < count; base += CACHE_BATCH_CHUNK) { \
+            int n = count - base < CACHE_BATCH_CHUNK ? count - base : CACHE_BATCH_CHUNK; \
+            if (cache) { \
+                cache_batch_prefetch(&cache->index, &cache->nodes, mask, skip, keys + base, n); \
+            } \
+            for (int i = base; i < base + n; i++) { \
+                put_##ops(cache, keys[i], values[i]); \
+            } \
+        } \
+    }
+
+#endif // CACHE_BATCH_H 
\ No newline at end of file
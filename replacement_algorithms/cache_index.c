@@ -0,0 +1,476 @@
+#include "cache_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CTRL_EMPTY ((int8_t)-128)   // 0x80
+#define CTRL_DELETED ((int8_t)-2)   // 0xFE
+
+#define INDEX_GROWABLE_START 64     // Initial slots in growable mode
+#define INDEX_REHASH_STEP 2         // Groups migrated per write
+
+// Slots for a table presized to hold count keys at a load of at most 7/8,
+// which leaves room for deleted markers before a cleanup is needed
+static size_t slots_for(size_t count) {
+    size_t slots = CACHE_INDEX_GROUP_WIDTH;
+    while (slots - slots / 8 < count) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+// Tables are allowed to fill to 15/16 counting deleted markers
+static size_t max_load(size_t slots) {
+    return slots - slots / 16;
+}
+
+static size_t table_slots(const CacheIndexTable* table) {
+    return (table->group_mask + 1) * CACHE_INDEX_GROUP_WIDTH;
+}
+
+// Scale the top 32 hash bits onto the group count, i.e. take the top bits
+static size_t hash_group(const CacheIndexTable* table, uint64_t h) {
+    return (size_t)(((h >> 32) * (uint64_t)(table->group_mask + 1)) >> 32);
+}
+
+static int8_t hash_tag(uint64_t h) {
+    return (int8_t)((h >> 25) & 0x7f);
+}
+
+#if defined(__SSE2__)
+
+// Bit i set when control byte i of the group equals tag
+static inline uint32_t group_match(const int8_t* group, int8_t tag) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+}
+
+// Bit i set when slot i is empty or deleted (the only bytes with the top bit set)
+static inline uint32_t group_match_free(const int8_t* group) {
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+
+#else
+
+static inline uint32_t group_match(const int8_t* group, int8_t tag) {
+    uint32_t mask = 0;
+    for (int i = 0; i < CACHE_INDEX_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(group[i] == tag) << i;
+    }
+    return mask;
+}
+
+static inline uint32_t group_match_free(const int8_t* group) {
+    uint32_t mask = 0;
+    for (int i = 0; i < CACHE_INDEX_GROUP_WIDTH; i++) {
+        mask |= (uint32_t)(group[i] < 0) << i;
+    }
+    return mask;
+}
+
+#endif
+
+static inline int lowest_bit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
+// Set up a table with the given number of slots (a power of two, >= 16),
+// reusing the index's spare buffer when it has the right size
+static int table_init(CacheIndex* index, CacheIndexTable* table, size_t slots) {
+    // Control bytes and slots share one allocation; slots stay 16-byte aligned
+    char* block;
+    if (index->spare && index->spare_slots == slots) {
+        block = (char*)index->spare;
+        index->spare = NULL;
+    } else {
+        block = (char*)malloc(slots + slots * sizeof(CacheIndexSlot));
+        if (!block) {
+            return -1;
+        }
+    }
+
+    table->ctrl = (int8_t*)block;
+    table->slots = (CacheIndexSlot*)(block + slots);
+    memset(table->ctrl, CTRL_EMPTY, slots);
+    table->group_mask = slots / CACHE_INDEX_GROUP_WIDTH - 1;
+    table->used = 0;
+    table->growth_left = max_load(slots);
+    return 0;
+}
+
+static void table_destroy(CacheIndexTable* table) {
+    free(table->ctrl);
+    table->ctrl = NULL;
+    table->slots = NULL;
+}
+
+// Find the slot holding key in one table, or -1
+static long table_find(const CacheIndexTable* table, int key, uint64_t h) {
+    size_t group = hash_group(table, h);
+    int8_t tag = hash_tag(h);
+
+    for (size_t step = 1; step <= table->group_mask + 1; step++) {
+        const int8_t* ctrl = table->ctrl + group * CACHE_INDEX_GROUP_WIDTH;
+        uint32_t match = group_match(ctrl, tag);
+
+        while (match) {
+            size_t slot = group * CACHE_INDEX_GROUP_WIDTH + lowest_bit(match);
+            if (table->slots[slot].key == key) {
+                return (long)slot;
+            }
+            match &= match - 1;
+        }
+
+        // An empty slot ends every probe sequence that reaches this group
+        if (group_match(ctrl, CTRL_EMPTY)) {
+            return -1;
+        }
+        group = (group + step) & table->group_mask;
+    }
+    return -1;
+}
+
+// Store key in the first free slot of its probe sequence
+static void table_insert(CacheIndexTable* table, int key, uint32_t handle, uint64_t h) {
+    size_t group = hash_group(table, h);
+
+    for (size_t step = 1; ; step++) {
+        uint32_t free_slots = group_match_free(table->ctrl + group * CACHE_INDEX_GROUP_WIDTH);
+        if (free_slots) {
+            size_t slot = group * CACHE_INDEX_GROUP_WIDTH + lowest_bit(free_slots);
+            if (table->ctrl[slot] == CTRL_EMPTY) {
+                table->growth_left--;
+            }
+            table->ctrl[slot] = hash_tag(h);
+            table->slots[slot].key = key;
+            table->slots[slot].handle = handle;
+            table->used++;
+            return;
+        }
+        group = (group + step) & table->group_mask;
+    }
+}
+
+// Clear a slot; it can go back to empty only if no probe passes through it
+static void table_erase(CacheIndexTable* table, size_t slot) {
+    const int8_t* group = table->ctrl + (slot & ~(size_t)(CACHE_INDEX_GROUP_WIDTH - 1));
+
+    if (group_match(group, CTRL_EMPTY)) {
+        table->ctrl[slot] = CTRL_EMPTY;
+        table->growth_left++;
+    } else {
+        table->ctrl[slot] = CTRL_DELETED;
+    }
+    table->used--;
+}
+
+// Move a bounded number of groups from tables[0] to tables[1]
+static void rehash_step(CacheIndex* index, size_t groups) {
+    CacheIndexTable* from = &index->tables[0];
+    CacheIndexTable* to = &index->tables[1];
+
+    for (size_t moved = 0; moved < groups && index->rehash_group <= from->group_mask; moved++) {
+        size_t base = index->rehash_group++ * CACHE_INDEX_GROUP_WIDTH;
+
+        for (size_t slot = base; slot < base + CACHE_INDEX_GROUP_WIDTH; slot++) {
+            if (from->ctrl[slot] >= 0) {
+                CacheIndexSlot* s = &from->slots[slot];
+                table_insert(to, s->key, s->handle, cache_hash_key(s->key));
+                // Keep probe chains through this group intact for unmoved keys
+                from->ctrl[slot] = CTRL_DELETED;
+                from->used--;
+            }
+        }
+    }
+
+    if (index->rehash_group > from->group_mask) {
+        // Migration finished: the new table becomes the only one. A retired
+        // table of the same size is kept so periodic cleanups of deleted
+        // markers don't allocate
+        if (table_slots(from) == table_slots(to)) {
+            free(index->spare);
+            index->spare = from->ctrl;
+            index->spare_slots = table_slots(from);
+        } else {
+            table_destroy(from);
+        }
+        *from = *to;
+        to->ctrl = NULL;
+        to->slots = NULL;
+        index->rehashing = 0;
+    }
+}
+
+// Start a migration once the table runs out of empty slots: to a table
+// twice the size if it is genuinely full, otherwise to one of the same size
+// to flush deleted markers
+static void maybe_rehash(CacheIndex* index) {
+    CacheIndexTable* table = &index->tables[0];
+
+    if (index->rehashing || table->growth_left > 0) {
+        return;
+    }
+
+    size_t slots = table_slots(table);
+    if (table->used > max_load(slots) / 2) {
+        slots *= 2;
+    }
+    if (table_init(index, &index->tables[1], slots) != 0) {
+        return;     // Keep probing the crowded table
+    }
+    index->rehash_group = 0;
+    index->rehashing = 1;
+}
+
+// Initialize the index for a cache of the given capacity
+int cache_index_init(CacheIndex* index, int capacity, CacheIndexSizing sizing) {
+    size_t slots = slots_for((size_t)capacity);
+
+    if (sizing == CACHE_INDEX_GROWABLE && slots > INDEX_GROWABLE_START) {
+        slots = INDEX_GROWABLE_START;
+    }
+
+    index->tables[1].ctrl = NULL;
+    index->tables[1].slots = NULL;
+    index->spare = NULL;
+    index->spare_slots = 0;
+    index->rehash_group = 0;
+    index->rehashing = 0;
+    return table_init(index, &index->tables[0], slots);
+}
+
+// Free the index
+void cache_index_destroy(CacheIndex* index) {
+    table_destroy(&index->tables[0]);
+    table_destroy(&index->tables[1]);
+    free(index->spare);
+    index->spare = NULL;
+}
+
+// Look up the handle stored for key, or CACHE_INDEX_NONE
+uint32_t cache_index_find(CacheIndex* index, int key) {
+    uint64_t h = cache_hash_key(key);
+
+    for (int t = 0; t <= index->rehashing; t++) {
+        long slot = table_find(&index->tables[t], key, h);
+        if (slot >= 0) {
+            return index->tables[t].slots[slot].handle;
+        }
+    }
+    return CACHE_INDEX_NONE;
+}
+
+// Start loading a group's control bytes and slots
+static inline void prefetch_group(const CacheIndexTable* table, size_t group) {
+    size_t base = group * CACHE_INDEX_GROUP_WIDTH;
+    __builtin_prefetch(table->ctrl + base);
+    __builtin_prefetch(table->slots + base);
+    __builtin_prefetch(table->slots + base + CACHE_INDEX_GROUP_WIDTH / 2);
+}
+
+// Start loading the control bytes and slots of the group a lookup of key
+// probes first, so a later find doesn't wait for them
+void cache_index_prefetch(const CacheIndex* index, int key) {
+    uint64_t h = cache_hash_key(key);
+
+    for (int t = 0; t <= index->rehashing; t++) {
+        prefetch_group(&index->tables[t], hash_group(&index->tables[t], h));
+    }
+}
+
+// Stage of a lookup in flight: the line it has requested and waits for
+typedef enum {
+    LOOKUP_GROUP,           // Control bytes of the group to probe
+    LOOKUP_SLOT,            // Slot whose tag matched
+    LOOKUP_NODE             // Node of the key, which was found
+} LookupStage;
+
+// One lookup in flight in cache_index_find_interleaved
+typedef struct Lookup {
+    int pos;                // Position of its key in the batch
+    int key;
+    uint64_t h;
+    size_t group;           // Group being probed
+    size_t step;            // Probe step that reached the group
+    uint32_t match;         // Slots of the group whose tag matched, not yet checked
+    int8_t tag;
+    uint8_t table;          // Table the group belongs to
+    uint8_t stage;          // LookupStage
+} Lookup;
+
+// Request the control bytes of the lookup's next group
+static inline void lookup_request_group(const CacheIndexTable* table, Lookup* lookup) {
+    __builtin_prefetch(table->ctrl + lookup->group * CACHE_INDEX_GROUP_WIDTH);
+    lookup->stage = LOOKUP_GROUP;
+}
+
+// Begin a lookup: hash the key and request its first group
+static void lookup_start(const CacheIndex* index, Lookup* lookup, int pos, int key) {
+    lookup->pos = pos;
+    lookup->key = key;
+    lookup->h = cache_hash_key(key);
+    lookup->tag = hash_tag(lookup->h);
+    lookup->table = 0;
+    lookup->step = 1;
+    lookup->group = hash_group(&index->tables[0], lookup->h);
+    lookup_request_group(&index->tables[0], lookup);
+}
+
+// Advance a lookup whose requested line has had time to arrive, up to
+// the next line it needs; returns 0 once that is requested, or 1 with
+// *handle stored when the lookup is done. Probes in the same order as
+// cache_index_find
+static int lookup_resume(const CacheIndex* index, Lookup* lookup, const NodeArena* nodes,
+                         uint32_t mask, uint32_t skip, uint32_t* handle) {
+    const CacheIndexTable* table = &index->tables[lookup->table];
+    const int8_t* ctrl = table->ctrl + lookup->group * CACHE_INDEX_GROUP_WIDTH;
+
+    switch (lookup->stage) {
+        case LOOKUP_NODE:
+            return 1;
+
+        case LOOKUP_GROUP:
+            lookup->match = group_match(ctrl, lookup->tag);
+            break;
+
+        case LOOKUP_SLOT: {
+            size_t slot = lookup->group * CACHE_INDEX_GROUP_WIDTH + lowest_bit(lookup->match);
+            lookup->match &= lookup->match - 1;
+            if (table->slots[slot].key == lookup->key) {
+                *handle = table->slots[slot].handle;
+                if (!nodes || (*handle & skip)) {
+                    return 1;
+                }
+                __builtin_prefetch(node_arena_at(nodes, *handle & mask));
+                lookup->stage = LOOKUP_NODE;
+                return 0;
+            }
+            break;
+        }
+    }
+
+    // Check the next slot with a matching tag
+    if (lookup->match) {
+        size_t slot = lookup->group * CACHE_INDEX_GROUP_WIDTH + lowest_bit(lookup->match);
+        __builtin_prefetch(&table->slots[slot]);
+        lookup->stage = LOOKUP_SLOT;
+        return 0;
+    }
+
+    if (group_match(ctrl, CTRL_EMPTY) || lookup->step > table->group_mask) {
+        // The key isn't in this table; while rehashing, try the new one
+        if (lookup->table >= index->rehashing) {
+            *handle = CACHE_INDEX_NONE;
+            return 1;
+        }
+        table = &index->tables[++lookup->table];
+        lookup->step = 1;
+        lookup->group = hash_group(table, lookup->h);
+    } else {
+        lookup->group = (lookup->group + lookup->step++) & table->group_mask;
+    }
+    lookup_request_group(table, lookup);
+    return 0;
+}
+
+// Look up count keys with up to group_size lookups in flight, each a small
+// state machine that requests the next line it needs (a group's control
+// bytes, a slot whose tag matched, or the node of a found key) and yields
+// to the next lookup instead of waiting for it. Finished lookups are replaced from the remaining keys, so the
+// group stays full. handles[i] receives what cache_index_find(keys[i])
+// would return. When nodes is set, a found key's node (handle & mask in
+// nodes, unless handle & skip marks one without a node) has been loaded
+// by the time its lookup finishes
+void cache_index_find_interleaved(const CacheIndex* index, const int* keys, uint32_t* handles,
+                                  int count, int group_size, const NodeArena* nodes,
+                                  uint32_t mask, uint32_t skip) {
+    Lookup lookups[CACHE_INDEX_INTERLEAVE_MAX];
+    if (group_size < 1) {
+        group_size = 1;
+    } else if (group_size > CACHE_INDEX_INTERLEAVE_MAX) {
+        group_size = CACHE_INDEX_INTERLEAVE_MAX;
+    }
+
+    int next = 0;
+    int active = 0;
+    while (active < group_size && next < count) {
+        lookup_start(index, &lookups[active++], next, keys[next]);
+        next++;
+    }
+
+    // Round robin over the lookups in flight
+    while (active > 0) {
+        for (int i = 0; i < active; ) {
+            Lookup* lookup = &lookups[i];
+            if (!lookup_resume(index, lookup, nodes, mask, skip, &handles[lookup->pos])) {
+                i++;
+            } else if (next < count) {
+                lookup_start(index, lookup, next, keys[next]);
+                next++;
+                i++;
+            } else {
+                *lookup = lookups[--active];
+            }
+        }
+    }
+}
+
+// Add a key that is not already present
+int cache_index_insert(CacheIndex* index, int key, uint32_t handle) {
+    if (index->rehashing) {
+        // Should the new table fill up first, finish the migration now
+        size_t groups = index->tables[1].growth_left > 0 ? INDEX_REHASH_STEP : (size_t)-1;
+        rehash_step(index, groups);
+    }
+
+    CacheIndexTable* table = &index->tables[index->rehashing];
+    if (table->growth_left == 0) {
+        return -1;  // Could not allocate a larger table
+    }
+
+    table_insert(table, key, handle, cache_hash_key(key));
+    maybe_rehash(index);
+    return 0;
+}
+
+// Replace the handle stored for key; returns -1 if key is not present
+int cache_index_update(CacheIndex* index, int key, uint32_t handle) {
+    uint64_t h = cache_hash_key(key);
+
+    for (int t = 0; t <= index->rehashing; t++) {
+        long slot = table_find(&index->tables[t], key, h);
+        if (slot >= 0) {
+            index->tables[t].slots[slot].handle = handle;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Remove key and return its handle, or CACHE_INDEX_NONE if it was not present
+uint32_t cache_index_remove(CacheIndex* index, int key) {
+    uint64_t h = cache_hash_key(key);
+
+    if (index->rehashing) {
+        rehash_step(index, INDEX_REHASH_STEP);
+    }
+
+    for (int t = 0; t <= index->rehashing; t++) {
+        CacheIndexTable* table = &index->tables[t];
+        long slot = table_find(table, key, h);
+        if (slot >= 0) {
+            uint32_t handle = table->slots[slot].handle;
+            table_erase(table, (size_t)slot);
+            return handle;
+        }
+    }
+    return CACHE_INDEX_NONE;
+}
+
+// Number of keys in the index
+size_t cache_index_count(const CacheIndex* index) {
+    return index->tables[0].used + (index->rehashing ? index->tables[1].used : 0);
+}
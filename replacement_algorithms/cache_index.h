@@ -0,0 +1,80 @@
+#ifndef CACHE_INDEX_H
+#define CACHE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "node_arena.h"
+
+// Key -> node handle index shared by the replacement backends.
+//
+// An open-addressing table in the SwissTable layout: one control byte per
+// slot (empty, deleted, or 7 bits of the key's hash) stored apart from the
+// slots themselves. Lookups compare a whole 16-slot group of control bytes
+// at once (SSE2 where available) and only touch a slot when its tag
+// matches, so a miss usually costs one cache line and a hit two.
+//
+// When the table needs to grow, or to flush deleted markers, a second table
+// is allocated and groups are moved over a few at a time on each
+// insert/remove, so no single put pays for migrating the whole table.
+//
+// cache_index_find_interleaved looks up a batch of keys with several
+// lookups in flight, switching to another lookup whenever one has to wait
+// for memory, so their cache misses overlap.
+
+// How a cache sizes its key index
+typedef enum {
+    CACHE_INDEX_PRESIZED,   // Allocate the index for the full capacity up front
+    CACHE_INDEX_GROWABLE    // Start small and grow by incremental rehashing
+} CacheIndexSizing;
+
+#define CACHE_INDEX_GROUP_WIDTH 16
+#define CACHE_INDEX_NONE UINT32_MAX     // Returned when a key is not present
+#define CACHE_INDEX_INTERLEAVE_MAX 64   // Most lookups cache_index_find_interleaved runs at once
+
+// Key and 32-bit node handle, stored inline in the table
+typedef struct CacheIndexSlot {
+    int key;
+    uint32_t handle;
+} CacheIndexSlot;
+
+// One control-byte array plus its slots
+typedef struct CacheIndexTable {
+    int8_t* ctrl;           // One byte per slot, groups of 16
+    CacheIndexSlot* slots;
+    size_t group_mask;      // Group count - 1
+    size_t used;            // Live keys in this table
+    size_t growth_left;     // Empty slots that may still be filled
+} CacheIndexTable;
+
+// Index structure
+typedef struct CacheIndex {
+    CacheIndexTable tables[2];  // tables[1] only exists while rehashing
+    int8_t* spare;              // Retired same-size table kept for the next cleanup
+    size_t spare_slots;
+    size_t rehash_group;        // Next group of tables[0] to migrate
+    int rehashing;
+} CacheIndex;
+
+// Mix all key bits into a 64-bit hash; the index uses the top bits to
+// pick a group and bits 25-31 as the control-byte tag
+static inline uint64_t cache_hash_key(int key) {
+    uint64_t h = (uint64_t)(uint32_t)key * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ull;
+    h ^= h >> 32;
+    return h;
+}
+
+int cache_index_init(CacheIndex* index, int capacity, CacheIndexSizing sizing);
+void cache_index_destroy(CacheIndex* index);
+uint32_t cache_index_find(CacheIndex* index, int key);
+void cache_index_prefetch(const CacheIndex* index, int key);
+void cache_index_find_interleaved(const CacheIndex* index, const int* keys, uint32_t* handles,
+                                  int count, int group_size, const NodeArena* nodes,
+                                  uint32_t mask, uint32_t skip);
+int cache_index_insert(CacheIndex* index, int key, uint32_t handle);
+int cache_index_update(CacheIndex* index, int key, uint32_t handle);
+uint32_t cache_index_remove(CacheIndex* index, int key);
+size_t cache_index_count(const CacheIndex* index);
+
+#endif // CACHE_INDEX_H
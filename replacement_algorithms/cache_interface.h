@@ -4,38 +4,182 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
-
-#define MAX_CACHE_SIZE 100
+#include "cache_index.h"
 
 // Generic cache interface
 typedef struct Cache Cache;
 
+// Counters for one cache. Backends fill in size, capacity and evictions;
+// hits, misses, puts and erases are counted by the CacheHandle wrapper in
+// cache_registry.h, so the backends' get and put paths stay untouched
+typedef struct CacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t puts;
+    uint64_t erases;
+    uint64_t evictions;     // Entries dropped to make room or by evict
+    int size;
+    int capacity;
+} CacheStats;
+
 // Function declarations for LRU cache
 Cache* create_lru_cache(int capacity);
+Cache* create_lru_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_lru_cache(Cache* cache);
 int get_lru(Cache* cache, int key);
 void put_lru(Cache* cache, int key, int value);
+void get_many_lru(Cache* cache, const int* keys, int* values, int count);
+void put_many_lru(Cache* cache, const int* keys, const int* values, int count);
+int erase_lru(Cache* cache, int key);
+int evict_lru(Cache* cache);
+int resize_lru(Cache* cache, int capacity);
+void get_lru_stats(Cache* cache, CacheStats* stats);
 void print_lru_cache_contents(Cache* cache, const char* message);
 
+// W-TinyLFU mode of the LRU cache (uses the LRU functions above)
+Cache* create_wtinylfu_cache(int capacity);
+Cache* create_wtinylfu_cache_sized(int capacity, CacheIndexSizing sizing);
+
 // Function declarations for LFU cache
 Cache* create_lfu_cache(int capacity);
+Cache* create_lfu_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_lfu_cache(Cache* cache);
 int get_lfu(Cache* cache, int key);
 void put_lfu(Cache* cache, int key, int value);
+void get_many_lfu(Cache* cache, const int* keys, int* values, int count);
+void put_many_lfu(Cache* cache, const int* keys, const int* values, int count);
+int erase_lfu(Cache* cache, int key);
+int evict_lfu(Cache* cache);
+int resize_lfu(Cache* cache, int capacity);
+void get_lfu_stats(Cache* cache, CacheStats* stats);
 void print_lfu_cache_contents(Cache* cache, const char* message);
 
 // Function declarations for FIFO cache
 Cache* create_fifo_cache(int capacity);
+Cache* create_fifo_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_fifo_cache(Cache* cache);
 int get_fifo(Cache* cache, int key);
 void put_fifo(Cache* cache, int key, int value);
+void get_many_fifo(Cache* cache, const int* keys, int* values, int count);
+void put_many_fifo(Cache* cache, const int* keys, const int* values, int count);
+int erase_fifo(Cache* cache, int key);
+int evict_fifo(Cache* cache);
+int resize_fifo(Cache* cache, int capacity);
+void get_fifo_stats(Cache* cache, CacheStats* stats);
 void print_fifo_cache_contents(Cache* cache, const char* message);
 
 // Function declarations for Random cache
 Cache* create_random_cache(int capacity);
+Cache* create_random_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_random_cache(Cache* cache);
 int get_random(Cache* cache, int key);
 void put_random(Cache* cache, int key, int value);
+void get_many_random(Cache* cache, const int* keys, int* values, int count);
+void put_many_random(Cache* cache, const int* keys, const int* values, int count);
+int erase_random(Cache* cache, int key);
+int evict_random(Cache* cache);
+int resize_random(Cache* cache, int capacity);
+void get_random_stats(Cache* cache, CacheStats* stats);
 void print_random_cache_contents(Cache* cache, const char* message);
+void seed_random_cache(Cache* cache, uint64_t seed);
+
+// Function declarations for CLOCK cache
+Cache* create_clock_cache(int capacity);
+Cache* create_clock_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_clock_cache(Cache* cache);
+int get_clock(Cache* cache, int key);
+void put_clock(Cache* cache, int key, int value);
+void get_many_clock(Cache* cache, const int* keys, int* values, int count);
+void put_many_clock(Cache* cache, const int* keys, const int* values, int count);
+int erase_clock(Cache* cache, int key);
+int evict_clock(Cache* cache);
+int resize_clock(Cache* cache, int capacity);
+void get_clock_stats(Cache* cache, CacheStats* stats);
+void print_clock_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for ARC cache
+Cache* create_arc_cache(int capacity);
+Cache* create_arc_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_arc_cache(Cache* cache);
+int get_arc(Cache* cache, int key);
+void put_arc(Cache* cache, int key, int value);
+void get_many_arc(Cache* cache, const int* keys, int* values, int count);
+void put_many_arc(Cache* cache, const int* keys, const int* values, int count);
+int erase_arc(Cache* cache, int key);
+int evict_arc(Cache* cache);
+int resize_arc(Cache* cache, int capacity);
+void get_arc_stats(Cache* cache, CacheStats* stats);
+void print_arc_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for S3-FIFO cache
+Cache* create_s3fifo_cache(int capacity);
+Cache* create_s3fifo_cache_sized(int capacity, CacheIndexSizing sizing);
+Cache* create_s3fifo_cache_split(int capacity, int small_percent, CacheIndexSizing sizing);
+void destroy_s3fifo_cache(Cache* cache);
+int get_s3fifo(Cache* cache, int key);
+void put_s3fifo(Cache* cache, int key, int value);
+void get_many_s3fifo(Cache* cache, const int* keys, int* values, int count);
+void put_many_s3fifo(Cache* cache, const int* keys, const int* values, int count);
+int erase_s3fifo(Cache* cache, int key);
+int evict_s3fifo(Cache* cache);
+int resize_s3fifo(Cache* cache, int capacity);
+void get_s3fifo_stats(Cache* cache, CacheStats* stats);
+void print_s3fifo_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for LIRS cache
+Cache* create_lirs_cache(int capacity);
+Cache* create_lirs_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_lirs_cache(Cache* cache);
+int get_lirs(Cache* cache, int key);
+void put_lirs(Cache* cache, int key, int value);
+void get_many_lirs(Cache* cache, const int* keys, int* values, int count);
+void put_many_lirs(Cache* cache, const int* keys, const int* values, int count);
+int erase_lirs(Cache* cache, int key);
+int evict_lirs(Cache* cache);
+int resize_lirs(Cache* cache, int capacity);
+void get_lirs_stats(Cache* cache, CacheStats* stats);
+void print_lirs_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for LRU-2 cache
+Cache* create_lru2_cache(int capacity);
+Cache* create_lru2_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_lru2_cache(Cache* cache);
+int get_lru2(Cache* cache, int key);
+void put_lru2(Cache* cache, int key, int value);
+void get_many_lru2(Cache* cache, const int* keys, int* values, int count);
+void put_many_lru2(Cache* cache, const int* keys, const int* values, int count);
+int erase_lru2(Cache* cache, int key);
+int evict_lru2(Cache* cache);
+int resize_lru2(Cache* cache, int capacity);
+void get_lru2_stats(Cache* cache, CacheStats* stats);
+void print_lru2_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for 2Q cache
+Cache* create_twoq_cache(int capacity);
+Cache* create_twoq_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_twoq_cache(Cache* cache);
+int get_twoq(Cache* cache, int key);
+void put_twoq(Cache* cache, int key, int value);
+void get_many_twoq(Cache* cache, const int* keys, int* values, int count);
+void put_many_twoq(Cache* cache, const int* keys, const int* values, int count);
+int erase_twoq(Cache* cache, int key);
+int evict_twoq(Cache* cache);
+int resize_twoq(Cache* cache, int capacity);
+void get_twoq_stats(Cache* cache, CacheStats* stats);
+void print_twoq_cache_contents(Cache* cache, const char* message);
+
+// Function declarations for Concurrent LRU cache (thread-safe)
+Cache* create_concurrent_lru_cache(int capacity);
+Cache* create_concurrent_lru_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_concurrent_lru_cache(Cache* cache);
+int get_concurrent_lru(Cache* cache, int key);
+void put_concurrent_lru(Cache* cache, int key, int value);
+void get_many_concurrent_lru(Cache* cache, const int* keys, int* values, int count);
+void put_many_concurrent_lru(Cache* cache, const int* keys, const int* values, int count);
+int erase_concurrent_lru(Cache* cache, int key);
+int evict_concurrent_lru(Cache* cache);
+int resize_concurrent_lru(Cache* cache, int capacity);
+void get_concurrent_lru_stats(Cache* cache, CacheStats* stats);
+void print_concurrent_lru_cache_contents(Cache* cache, const char* message);
 
 #endif // CACHE_INTERFACE_H 
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "cache_registry.h"
+#include <string.h>
+
+#define CACHE_OPS_ENTRY(name, create, ops, label, description, read_only_get, min_capacity, seed) \
+    { #name, label, description, read_only_get, min_capacity, create_##create##_cache_sized, destroy_##ops##_cache, \
+      get_##ops, put_##ops, get_many_##ops, put_many_##ops, erase_##ops, evict_##ops, resize_##ops, \
+      get_##ops##_stats, print_##ops##_cache_contents, seed },
+
+static const CacheOps policies[] = {
+    CACHE_POLICIES(CACHE_OPS_ENTRY)
+};
+
+#define POLICY_COUNT (sizeof(policies) / sizeof(policies[0]))
+
+// Number of registered policies
+size_t cache_policy_count(void) {
+    return POLICY_COUNT;
+}
+
+// Policy at a position in the registry, or NULL
+const CacheOps* cache_policy_at(size_t i) {
+    return i < POLICY_COUNT ? &policies[i] : NULL;
+}
+
+// Policy registered under name, or NULL
+const CacheOps* cache_policy_find(const char* name) {
+    for (size_t i = 0; i < POLICY_COUNT; i++) {
+        if (strcmp(policies[i].name, name) == 0) {
+            return &policies[i];
+        }
+    }
+    return NULL;
+}
+
+// Create a cache of the named policy; returns NULL if the name is unknown
+// or the backend rejects the configuration
+CacheHandle* cache_create(const char* name, const CacheConfig* config) {
+    const CacheOps* ops = name && config ? cache_policy_find(name) : NULL;
+    if (!ops) {
+        return NULL;
+    }
+
+    CacheHandle* handle = (CacheHandle*)calloc(1, sizeof(CacheHandle));
+    if (!handle) {
+        return NULL;
+    }
+
+    handle->cache = ops->create(config->capacity, config->sizing);
+    if (!handle->cache) {
+        free(handle);
+        return NULL;
+    }
+    handle->ops = ops;
+    if (config->seed && ops->seed) {
+        ops->seed(handle->cache, config->seed);
+    }
+
+    return handle;
+}
+
+// Destroy the cache and its handle
+void cache_destroy(CacheHandle* handle) {
+    if (!handle) {
+        return;
+    }
+
+    handle->ops->destroy(handle->cache);
+    free(handle);
+}
+
+// Combine the handle's counters with the backend's size and evictions
+void cache_get_stats(CacheHandle* handle, CacheStats* stats) {
+    *stats = handle->stats;
+    handle->ops->stats(handle->cache, stats);
+}
+
+// Print cache contents
+void cache_print(CacheHandle* handle, const char* message) {
+    handle->ops->print(handle->cache, message);
+}
@@ -0,0 +1,187 @@
+#ifndef CACHE_REGISTRY_H
+#define CACHE_REGISTRY_H
+
+#include "cache_interface.h"
+
+// One handle type for every replacement policy.
+//
+// A CacheHandle pairs a backend's Cache with its operations table, so
+// callers can pick a policy by name at run time and use it through
+// cache_get/cache_put/cache_erase/cache_evict without per-policy code;
+// cache_get_many/cache_put_many take a batch of keys at once (see
+// cache_batch.h), and cache_resize shrinks or regrows a cache in place,
+// segments and ghost lists included. The handle also counts hits,
+// misses, puts and erases; the backend reports its size and evictions
+// through cache_get_stats.
+//
+// Hot loops that know their policy at compile time can use
+// CACHE_DEFINE_STATIC instead, which generates the same calls bound
+// directly to one backend's functions, with no indirect call per access.
+
+// Every registered policy, in menu order:
+//   X(name, create, ops, label, description, read_only_get, min_capacity, seed)
+// name is the registry name, create the prefix of its create_*_cache_sized
+// function, and ops the prefix of its get/put/get_many/put_many/erase/
+// evict/resize/stats functions (W-TinyLFU is a mode of the LRU backend,
+// so it uses the LRU ones).
+// read_only_get is 1 when gets may run concurrently under a shared lock:
+// the get only looks the key up and changes nothing, or (Concurrent LRU)
+// synchronizes its own bookkeeping.
+// min_capacity is the smallest capacity create and resize accept (LIRS
+// needs one LIR and one resident HIR slot).
+// seed reseeds a policy that evicts at random, and is NULL for the rest
+#define CACHE_POLICIES(X) \
+    X(lru, lru, lru, "LRU", "Least Recently Used", 0, 1, NULL) \
+    X(lfu, lfu, lfu, "LFU", "Least Frequently Used", 0, 1, NULL) \
+    X(fifo, fifo, fifo, "FIFO", "First In First Out", 1, 1, NULL) \
+    X(random, random, random, "Random", "Random Replacement", 1, 1, seed_random_cache) \
+    X(clock, clock, clock, "CLOCK", "Second Chance", 0, 1, NULL) \
+    X(arc, arc, arc, "ARC", "Adaptive Replacement Cache", 0, 1, NULL) \
+    X(wtinylfu, wtinylfu, lru, "W-TinyLFU", "LRU with frequency-based admission", 0, 1, NULL) \
+    X(s3fifo, s3fifo, s3fifo, "S3-FIFO", "Small/Main FIFO queues with ghosts", 0, 1, NULL) \
+    X(lirs, lirs, lirs, "LIRS", "Low Inter-reference Recency Set", 0, 2, NULL) \
+    X(lru2, lru2, lru2, "LRU-2", "second-to-last reference", 0, 1, NULL) \
+    X(twoq, twoq, twoq, "2Q", "A1in/A1out/Am queues", 0, 1, NULL) \
+    X(clru, concurrent_lru, concurrent_lru, "C-LRU", "Concurrent LRU, lock-free reads", 1, 1, NULL)
+
+// Operations of one policy
+typedef struct CacheOps {
+    const char* name;           // Registry name, e.g. "lru"
+    const char* label;          // Display name, e.g. "LRU"
+    const char* description;
+    int read_only_get;          // get changes nothing (see CACHE_POLICIES)
+    int min_capacity;           // Smallest capacity the backend accepts
+    Cache* (*create)(int capacity, CacheIndexSizing sizing);
+    void (*destroy)(Cache* cache);
+    int (*get)(Cache* cache, int key);
+    void (*put)(Cache* cache, int key, int value);
+    void (*get_many)(Cache* cache, const int* keys, int* values, int count);
+    void (*put_many)(Cache* cache, const int* keys, const int* values, int count);
+    int (*erase)(Cache* cache, int key);
+    int (*evict)(Cache* cache);
+    int (*resize)(Cache* cache, int capacity);
+    void (*stats)(Cache* cache, CacheStats* stats);
+    void (*print)(Cache* cache, const char* message);
+    void (*seed)(Cache* cache, uint64_t seed);     // NULL if nothing is random
+} CacheOps;
+
+// Settings for cache_create
+typedef struct CacheConfig {
+    int capacity;
+    CacheIndexSizing sizing;
+    uint64_t seed;              // Random eviction seed; 0 keeps CACHE_RNG_DEFAULT_SEED
+} CacheConfig;
+
+// Handle structure
+typedef struct CacheHandle {
+    const CacheOps* ops;
+    Cache* cache;
+    CacheStats stats;           // Only hits, misses, puts and erases are kept here
+} CacheHandle;
+
+size_t cache_policy_count(void);
+const CacheOps* cache_policy_at(size_t i);
+const CacheOps* cache_policy_find(const char* name);
+
+CacheHandle* cache_create(const char* name, const CacheConfig* config);
+void cache_destroy(CacheHandle* handle);
+void cache_get_stats(CacheHandle* handle, CacheStats* stats);
+void cache_print(CacheHandle* handle, const char* message);
+
+// Count the outcome of a get
+static inline int cache_count_get(CacheHandle* handle, int value) {
+    if (value == -1) {
+        handle->stats.misses++;
+    } else {
+        handle->stats.hits++;
+    }
+    return value;
+}
+
+// Count the outcome of an erase
+static inline int cache_count_erase(CacheHandle* handle, int result) {
+    if (result == 0) {
+        handle->stats.erases++;
+    }
+    return result;
+}
+
+// Get value from cache, or -1
+static inline int cache_get(CacheHandle* handle, int key) {
+    return cache_count_get(handle, handle->ops->get(handle->cache, key));
+}
+
+// Put value in cache
+static inline void cache_put(CacheHandle* handle, int key, int value) {
+    handle->stats.puts++;
+    handle->ops->put(handle->cache, key, value);
+}
+
+// Count the outcomes of a batched get
+static inline void cache_count_get_many(CacheHandle* handle, const int* values, int count) {
+    for (int i = 0; i < count; i++) {
+        cache_count_get(handle, values[i]);
+    }
+}
+
+// Get the values of count keys, -1 for each miss; the same as a loop of
+// cache_get, with the keys' cache misses overlapped
+static inline void cache_get_many(CacheHandle* handle, const int* keys, int* values, int count) {
+    handle->ops->get_many(handle->cache, keys, values, count);
+    cache_count_get_many(handle, values, count);
+}
+
+// Put count keys and values, as a loop of cache_put would
+static inline void cache_put_many(CacheHandle* handle, const int* keys, const int* values, int count) {
+    handle->stats.puts += (uint64_t)count;
+    handle->ops->put_many(handle->cache, keys, values, count);
+}
+
+// Remove key from the cache; returns -1 if it was not cached
+static inline int cache_erase(CacheHandle* handle, int key) {
+    return cache_count_erase(handle, handle->ops->erase(handle->cache, key));
+}
+
+// Evict the entry the policy would replace next; returns -1 if empty
+static inline int cache_evict(CacheHandle* handle) {
+    return handle->ops->evict(handle->cache);
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// what no longer fits; returns -1 if capacity is out of range
+static inline int cache_resize(CacheHandle* handle, int capacity) {
+    return handle->ops->resize(handle->cache, capacity);
+}
+
+// Define prefix_get, prefix_put, prefix_get_many, prefix_put_many,
+// prefix_erase and prefix_evict, taking a CacheHandle like the functions
+// above but calling the ops backend's functions directly. The handle must
+// have been created for a policy that uses those functions. Passing
+// CACHE_POLICIES a macro that expands to CACHE_DEFINE_STATIC(name, ops)
+// followed by a loop calling name##_get stamps out one directly
+// dispatched copy of the loop per policy, as benchmarks/bench_dispatch.c
+// does.
+#define CACHE_DEFINE_STATIC(prefix, ops) \
+    static inline int prefix##_get(CacheHandle* handle, int key) { \
+        return cache_count_get(handle, get_##ops(handle->cache, key)); \
+    } \
+    static inline void prefix##_put(CacheHandle* handle, int key, int value) { \
+        handle->stats.puts++; \
+        put_##ops(handle->cache, key, value); \
+    } \
+    static inline void prefix##_get_many(CacheHandle* handle, const int* keys, int* values, int count) { \
+        get_many_##ops(handle->cache, keys, values, count); \
+        cache_count_get_many(handle, values, count); \
+    } \
+    static inline void prefix##_put_many(CacheHandle* handle, const int* keys, const int* values, int count) { \
+        handle->stats.puts += (uint64_t)count; \
+        put_many_##ops(handle->cache, keys, values, count); \
+    } \
+    static inline int prefix##_erase(CacheHandle* handle, int key) { \
+        return cache_count_erase(handle, erase_##ops(handle->cache, key)); \
+    } \
+    static inline int prefix##_evict(CacheHandle* handle) { \
+        return evict_##ops(handle->cache); \
+    }
+
+#endif // CACHE_REGISTRY_H 
\ No newline at end of file
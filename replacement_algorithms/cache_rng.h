@@ -0,0 +1,42 @@
+#ifndef CACHE_RNG_H
+#define CACHE_RNG_H
+
+#include <stdint.h>
+
+// Small per-cache PCG32 generator (O'Neill's pcg32_random_r), so caches
+// don't share glibc's locked rand() state and runs can be reproduced
+// from a seed.
+
+// Generator structure
+typedef struct CacheRng {
+    uint64_t state;
+    uint64_t inc;       // Stream selector, always odd
+} CacheRng;
+
+// Seed every cache starts from, so default runs repeat exactly
+#define CACHE_RNG_DEFAULT_SEED 0x853c49e6748fea9bull
+
+// Next 32 random bits
+static inline uint32_t cache_rng_next(CacheRng* rng) {
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ull + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// Seed the generator; different streams give independent sequences
+static inline void cache_rng_seed(CacheRng* rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1u;
+    cache_rng_next(rng);
+    rng->state += seed;
+    cache_rng_next(rng);
+}
+
+// Uniform value in [0, bound) by multiply-shift, without a division
+static inline uint32_t cache_rng_below(CacheRng* rng, uint32_t bound) {
+    return (uint32_t)(((uint64_t)cache_rng_next(rng) * bound) >> 32);
+}
+
+#endif // CACHE_RNG_H
@@ -0,0 +1,277 @@
+#include "clock_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <string.h>
+
+// Slot structure. Entries stay in the slot they were inserted into; a hit
+// only sets the slot's bit in the reference bitmap, so gets never relink
+// anything.
+typedef struct ClockSlot {
+    int key;
+    int value;
+} ClockSlot;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;
+    NodeArena slots;        // capacity slots, swept in order by the hand
+    uint64_t* ref_bits;     // One reference bit per slot, 64 slots per word
+    uint32_t hand;          // Next slot to consider for eviction
+    uint64_t evictions;
+    int size;
+    int capacity;
+};
+
+// Slot at a position
+static ClockSlot* slot_at(Cache* cache, uint32_t pos) {
+    return (ClockSlot*)node_arena_at(&cache->slots, pos);
+}
+
+// Look up the slot position for key, or CACHE_INDEX_NONE
+static uint32_t find_slot(Cache* cache, int key) {
+    return cache_index_find(&cache->index, key);
+}
+
+static void set_ref(Cache* cache, uint32_t pos) {
+    cache->ref_bits[pos / 64] |= (uint64_t)1 << (pos % 64);
+}
+
+static void clear_ref(Cache* cache, uint32_t pos) {
+    cache->ref_bits[pos / 64] &= ~((uint64_t)1 << (pos % 64));
+}
+
+static int test_ref(const Cache* cache, uint32_t pos) {
+    return (int)((cache->ref_bits[pos / 64] >> (pos % 64)) & 1);
+}
+
+// Move the hand to the first unreferenced slot among the first count and
+// return it, clearing the reference bit of every slot passed on the way.
+// Whole words are handled at once: the victim is the lowest clear bit at or
+// after the hand, and a word with none is cleared in one store before
+// moving to the next.
+static uint32_t sweep_hand(Cache* cache, uint32_t count) {
+    uint32_t last_word = (count - 1) / 64;
+    uint64_t last_mask = count % 64 ? ((uint64_t)1 << (count % 64)) - 1 : ~(uint64_t)0;
+    uint32_t hand = cache->hand < count ? cache->hand : 0;
+
+    for (;;) {
+        uint32_t word = hand / 64;
+        uint64_t ahead = ~(uint64_t)0 << (hand % 64);   // Slots at or after the hand
+        if (word == last_word) {
+            ahead &= last_mask;
+        }
+
+        uint64_t unreferenced = ~cache->ref_bits[word] & ahead;
+        if (unreferenced) {
+            uint32_t bit = (uint32_t)__builtin_ctzll(unreferenced);
+            uint32_t victim = word * 64 + bit;
+
+            // Second chance for the referenced slots the hand skipped
+            cache->ref_bits[word] &= ~(ahead & (((uint64_t)1 << bit) - 1));
+            cache->hand = victim + 1 == count ? 0 : victim + 1;
+            return victim;
+        }
+
+        // Every slot left in this word was referenced
+        cache->ref_bits[word] &= ~ahead;
+        hand = word == last_word ? 0 : (word + 1) * 64;
+    }
+}
+
+// Create a new cache
+Cache* create_clock_cache(int capacity) {
+    return create_clock_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_clock_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->ref_bits = (uint64_t*)calloc(((size_t)capacity + 63) / 64, sizeof(uint64_t));
+    if (!cache->ref_bits) {
+        free(cache);
+        return NULL;
+    }
+
+    if (cache_index_init(&cache->index, capacity, sizing) != 0) {
+        free(cache->ref_bits);
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->slots, sizeof(ClockSlot), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache->ref_bits);
+        free(cache);
+        return NULL;
+    }
+
+    cache->hand = 0;
+    cache->evictions = 0;
+    cache->size = 0;
+    cache->capacity = capacity;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_clock_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    node_arena_destroy(&cache->slots);
+    cache_index_destroy(&cache->index);
+    free(cache->ref_bits);
+    free(cache);
+}
+
+// Get value from cache
+int get_clock(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t pos = find_slot(cache, key);
+    if (pos == CACHE_INDEX_NONE) {
+        return -1;  // Key not found
+    }
+
+    set_ref(cache, pos);
+    return slot_at(cache, pos)->value;
+}
+
+// Put value in cache
+void put_clock(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    // Check if key exists
+    uint32_t pos = find_slot(cache, key);
+    if (pos != CACHE_INDEX_NONE) {
+        slot_at(cache, pos)->value = value;
+        set_ref(cache, pos);
+        return;
+    }
+
+    // If cache is full, the hand picks the victim slot; otherwise slots are
+    // filled in order. New entries start unreferenced.
+    int evict = cache->size >= cache->capacity;
+    pos = evict ? sweep_hand(cache, (uint32_t)cache->capacity) : (uint32_t)cache->size;
+
+    if (cache_index_insert(&cache->index, key, pos) != 0) {
+        return;
+    }
+
+    ClockSlot* slot = slot_at(cache, pos);
+    if (evict) {
+        cache_index_remove(&cache->index, slot->key);
+        cache->evictions++;
+    } else {
+        cache->size++;
+    }
+    slot->key = key;
+    slot->value = value;
+}
+
+// Empty the slot at pos. The last occupied slot moves into it, reference
+// bit and all, so slots [0, size) stay filled
+static void remove_slot(Cache* cache, uint32_t pos) {
+    uint32_t last = (uint32_t)cache->size - 1;
+    ClockSlot* slot = slot_at(cache, pos);
+
+    cache_index_remove(&cache->index, slot->key);
+    if (pos != last) {
+        ClockSlot* moved = slot_at(cache, last);
+        *slot = *moved;
+        if (test_ref(cache, last)) {
+            set_ref(cache, pos);
+        } else {
+            clear_ref(cache, pos);
+        }
+        cache_index_update(&cache->index, slot->key, pos);
+    }
+    clear_ref(cache, last);
+    cache->size--;
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(clock, slots, UINT32_MAX, 0)
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_clock(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t pos = find_slot(cache, key);
+    if (pos == CACHE_INDEX_NONE) {
+        return -1;
+    }
+
+    remove_slot(cache, pos);
+    return 0;
+}
+
+// Evict the slot the hand stops at; returns -1 if the cache is empty
+int evict_clock(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    remove_slot(cache, sweep_hand(cache, (uint32_t)cache->size));
+    cache->evictions++;
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// the slots the hand stops at until the rest fit; returns -1 if it is out
+// of range. Slots stay packed at the front, so they all remain below the
+// new capacity
+int resize_clock(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->slots.capacity) {
+        return -1;
+    }
+
+    cache->capacity = capacity;
+    while (cache->size > capacity) {
+        evict_clock(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_clock_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print cache contents
+void print_clock_cache_contents(Cache* cache, const char* message) {
+    printf("\n%s:\n", message);
+    printf("Cache contents (from the clock hand):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tReferenced\n");
+    printf("------------------------------------------------\n");
+
+    for (int i = 0; i < cache->size; i++) {
+        uint32_t pos = (cache->hand + (uint32_t)i) % (uint32_t)cache->size;
+        ClockSlot* current = slot_at(cache, pos);
+        printf("%d\t%d\t%d\n",
+               current->key,
+               current->value,
+               test_ref(cache, pos));
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d\n", cache->size, cache->capacity);
+}
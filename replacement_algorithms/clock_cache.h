@@ -0,0 +1,21 @@
+#ifndef CLOCK_CACHE_H
+#define CLOCK_CACHE_H
+
+#include "cache_interface.h"
+
+Cache* create_clock_cache(int capacity);
+Cache* create_clock_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_clock_cache(Cache* cache);
+int get_clock(Cache* cache, int key);
+void put_clock(Cache* cache, int key, int value);
+void get_many_clock(Cache* cache, const int* keys, int* values, int count);
+void put_many_clock(Cache* cache, const int* keys, const int* values, int count);
+int erase_clock(Cache* cache, int key);
+int evict_clock(Cache* cache);
+int resize_clock(Cache* cache, int capacity);
+void get_clock_stats(Cache* cache, CacheStats* stats);
+void print_clock_cache_contents(Cache* cache, const char* message);
+
+// CLOCK specific declarations can be added here if needed
+
+#endif // CLOCK_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "concurrent_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SLOT_EMPTY UINT64_MAX                       // Handle CONCURRENT_INDEX_NONE
+#define HANDLE_TOMBSTONE (CONCURRENT_INDEX_NONE - 1)
+#define INDEX_GROWABLE_START 64                     // Initial slots in growable mode
+
+static inline int slot_key(uint64_t slot) {
+    return (int)(uint32_t)slot;
+}
+
+static inline uint32_t slot_handle(uint64_t slot) {
+    return (uint32_t)(slot >> 32);
+}
+
+static inline uint64_t make_slot(int key, uint32_t handle) {
+    return (uint64_t)(uint32_t)key | (uint64_t)handle << 32;
+}
+
+static inline size_t home_slot(const ConcurrentIndexTable* table, int key) {
+    return (size_t)(cache_hash_key(key) >> table->shift);
+}
+
+// Slots for count live keys at a load of at most 1/2
+static size_t slots_for(size_t count) {
+    size_t slots = 16;
+    while (slots < count * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+// Rebuild once live keys and tombstones pass 3/4 of the slots
+static size_t max_filled(const ConcurrentIndexTable* table) {
+    return (table->mask + 1) - (table->mask + 1) / 4;
+}
+
+static ConcurrentIndexTable* table_create(size_t slots) {
+    ConcurrentIndexTable* table =
+        (ConcurrentIndexTable*)malloc(sizeof(ConcurrentIndexTable) + slots * sizeof(uint64_t));
+    if (!table) {
+        return NULL;
+    }
+
+    int bits = 0;
+    while (((size_t)1 << bits) < slots) {
+        bits++;
+    }
+    table->mask = slots - 1;
+    table->shift = 64 - bits;
+    table->used = 0;
+    table->filled = 0;
+    memset(table->slots, 0xff, slots * sizeof(uint64_t));
+    return table;
+}
+
+static void table_release(void* table) {
+    free(table);
+}
+
+// Slot holding key in the published table, or -1. Writer side
+static long table_find(const ConcurrentIndexTable* table, int key) {
+    for (size_t i = home_slot(table, key); ; i = (i + 1) & table->mask) {
+        uint64_t slot = table->slots[i];
+        if (slot == SLOT_EMPTY) {
+            return -1;
+        }
+        if (slot_key(slot) == key && slot_handle(slot) != HANDLE_TOMBSTONE) {
+            return (long)i;
+        }
+    }
+}
+
+// Store a key that is not present in the first free slot of its probe
+// sequence, reusing a tombstone if one comes first
+static void table_insert(ConcurrentIndexTable* table, int key, uint32_t handle) {
+    size_t i = home_slot(table, key);
+    while (table->slots[i] != SLOT_EMPTY && slot_handle(table->slots[i]) != HANDLE_TOMBSTONE) {
+        i = (i + 1) & table->mask;
+    }
+    if (table->slots[i] == SLOT_EMPTY) {
+        table->filled++;
+    }
+    table->used++;
+    __atomic_store_n(&table->slots[i], make_slot(key, handle), __ATOMIC_RELEASE);
+}
+
+// Copy the live keys into a new table and publish it; the old one is
+// freed once no lookup can still be probing it. Returns -1 if the new
+// table can't be allocated
+static int rebuild(ConcurrentIndex* index, size_t live) {
+    ConcurrentIndexTable* old = index->table;
+    size_t slots = slots_for(live);
+    if (slots < index->min_slots) {
+        slots = index->min_slots;
+    }
+
+    ConcurrentIndexTable* table = table_create(slots);
+    if (!table) {
+        return -1;
+    }
+    for (size_t i = 0; i <= old->mask; i++) {
+        uint64_t slot = old->slots[i];
+        if (slot != SLOT_EMPTY && slot_handle(slot) != HANDLE_TOMBSTONE) {
+            table_insert(table, slot_key(slot), slot_handle(slot));
+        }
+    }
+
+    __atomic_store_n(&index->table, table, __ATOMIC_RELEASE);
+    epoch_retire(&index->epoch, old, table_release);
+    return 0;
+}
+
+// Initialize the index for a cache of the given capacity
+int concurrent_index_init(ConcurrentIndex* index, int capacity, CacheIndexSizing sizing) {
+    size_t slots = slots_for((size_t)capacity);
+    if (sizing == CACHE_INDEX_GROWABLE && slots > INDEX_GROWABLE_START) {
+        slots = INDEX_GROWABLE_START;
+    }
+
+    if (epoch_init(&index->epoch) != 0) {
+        return -1;
+    }
+    index->table = table_create(slots);
+    if (!index->table) {
+        epoch_destroy(&index->epoch);
+        return -1;
+    }
+    index->min_slots = slots;
+    return 0;
+}
+
+// Free the index; no lookup may be running
+void concurrent_index_destroy(ConcurrentIndex* index) {
+    epoch_destroy(&index->epoch);
+    free(index->table);
+    index->table = NULL;
+}
+
+// Look up the handle stored for key, or CONCURRENT_INDEX_NONE. Safe on any
+// thread, concurrently with a writer
+uint32_t concurrent_index_find(ConcurrentIndex* index, int key) {
+    uint32_t handle = CONCURRENT_INDEX_NONE;
+
+    epoch_enter(&index->epoch);
+    const ConcurrentIndexTable* table = __atomic_load_n(&index->table, __ATOMIC_ACQUIRE);
+    for (size_t i = home_slot(table, key); ; i = (i + 1) & table->mask) {
+        uint64_t slot = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+        if (slot == SLOT_EMPTY) {
+            break;
+        }
+        if (slot_key(slot) == key && slot_handle(slot) != HANDLE_TOMBSTONE) {
+            handle = slot_handle(slot);
+            break;
+        }
+    }
+    epoch_exit(&index->epoch);
+
+    return handle;
+}
+
+// Start loading the slot a lookup of key probes first. Safe on any
+// thread; a prefetch of a table retired meanwhile is harmless
+void concurrent_index_prefetch(ConcurrentIndex* index, int key) {
+    const ConcurrentIndexTable* table = __atomic_load_n(&index->table, __ATOMIC_ACQUIRE);
+    __builtin_prefetch(&table->slots[home_slot(table, key)]);
+}
+
+// Add a key that is not already present. Writers only
+int concurrent_index_insert(ConcurrentIndex* index, int key, uint32_t handle) {
+    ConcurrentIndexTable* table = index->table;
+
+    if (table->filled >= max_filled(table)) {
+        // A full table of tombstones is rebuilt at the same size
+        if (rebuild(index, table->used + 1) != 0 && table->filled >= table->mask) {
+            return -1;  // Keep one empty slot so probes end
+        }
+        table = index->table;
+    } else {
+        epoch_collect(&index->epoch);
+    }
+
+    table_insert(table, key, handle);
+    return 0;
+}
+
+// Replace the handle stored for key; returns -1 if key is not present.
+// Writers only
+int concurrent_index_update(ConcurrentIndex* index, int key, uint32_t handle) {
+    ConcurrentIndexTable* table = index->table;
+    long slot = table_find(table, key);
+    if (slot < 0) {
+        return -1;
+    }
+
+    __atomic_store_n(&table->slots[slot], make_slot(key, handle), __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Remove key and return its handle, or CONCURRENT_INDEX_NONE if it was not
+// present. Writers only
+uint32_t concurrent_index_remove(ConcurrentIndex* index, int key) {
+    ConcurrentIndexTable* table = index->table;
+    long slot = table_find(table, key);
+    if (slot < 0) {
+        return CONCURRENT_INDEX_NONE;
+    }
+
+    uint32_t handle = slot_handle(table->slots[slot]);
+    table->used--;
+
+    // A slot followed by an empty one ends its run, so no probe for a
+    // present key passes through it: it can go straight back to empty,
+    // along with the tombstones right before it
+    size_t i = (size_t)slot;
+    if (table->slots[(i + 1) & table->mask] != SLOT_EMPTY) {
+        __atomic_store_n(&table->slots[i], make_slot(key, HANDLE_TOMBSTONE), __ATOMIC_RELEASE);
+        return handle;
+    }
+    do {
+        __atomic_store_n(&table->slots[i], SLOT_EMPTY, __ATOMIC_RELEASE);
+        table->filled--;
+        i = (i - 1) & table->mask;
+    } while (slot_handle(table->slots[i]) == HANDLE_TOMBSTONE);
+    return handle;
+}
+
+// Number of keys in the index
+size_t concurrent_index_count(const ConcurrentIndex* index) {
+    return index->table->used;
+}
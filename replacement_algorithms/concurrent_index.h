@@ -0,0 +1,50 @@
+#ifndef CONCURRENT_INDEX_H
+#define CONCURRENT_INDEX_H
+
+#include "cache_index.h"
+#include "epoch.h"
+
+// Key -> node handle index whose lookups take no lock.
+//
+// An open-addressing table of 64-bit slots, each holding a key and its
+// handle so a reader gets both with one atomic load. Lookups may run on
+// any thread at any time; inserts, updates and removals must be
+// serialized by the caller (typically under the cache's own lock). A
+// removed key leaves a tombstone that lookups probe past, so a lookup
+// never misses a key that stays present; only a key at the end of its run
+// frees its slot at once. When live keys and tombstones
+// fill three quarters of the table, the writer copies the live keys into
+// a fresh table (twice the size if the live keys alone need it), publishes
+// it, and retires the old one to the index's epoch domain, which frees it
+// once every lookup that might still be reading it has finished.
+//
+// Handles CONCURRENT_INDEX_NONE and CONCURRENT_INDEX_NONE - 1 are reserved.
+
+#define CONCURRENT_INDEX_NONE UINT32_MAX    // Returned when a key is not present
+
+// One published table
+typedef struct ConcurrentIndexTable {
+    size_t mask;            // Slots - 1
+    int shift;              // Hash bits dropped to pick a home slot
+    size_t used;            // Live keys
+    size_t filled;          // Live keys plus tombstones
+    uint64_t slots[];       // key | handle << 32
+} ConcurrentIndexTable;
+
+// Index structure
+typedef struct ConcurrentIndex {
+    ConcurrentIndexTable* table;
+    size_t min_slots;       // Rebuilds never go below this
+    EpochDomain epoch;
+} ConcurrentIndex;
+
+int concurrent_index_init(ConcurrentIndex* index, int capacity, CacheIndexSizing sizing);
+void concurrent_index_destroy(ConcurrentIndex* index);
+uint32_t concurrent_index_find(ConcurrentIndex* index, int key);
+void concurrent_index_prefetch(ConcurrentIndex* index, int key);
+int concurrent_index_insert(ConcurrentIndex* index, int key, uint32_t handle);
+int concurrent_index_update(ConcurrentIndex* index, int key, uint32_t handle);
+uint32_t concurrent_index_remove(ConcurrentIndex* index, int key);
+size_t concurrent_index_count(const ConcurrentIndex* index);
+
+#endif // CONCURRENT_INDEX_H 
\ No newline at end of file
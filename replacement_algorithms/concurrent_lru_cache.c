@@ -0,0 +1,446 @@
+#include "concurrent_lru_cache.h"
+#include "cache_batch.h"
+#include "concurrent_index.h"
+#include "node_arena.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+// Read path: a get looks the key up in a ConcurrentIndex and then loads
+// the node's packed key/value word. Only the writer (holding the lock)
+// stores to either, with release stores, so a reader sees a node's
+// contents before its index slot. Nodes live in an arena that is never
+// unmapped while the cache exists, so they are reused at once rather than
+// retired: a reader holding a stale handle reads a recycled node at worst,
+// which the key check rejects.
+//
+// Recency: hits go to striped ring buffers of node handles, 16 per stripe.
+// A thread keeps to one stripe, reserves a slot with a compare-and-swap,
+// and drops the hit if the stripe is full or the swap loses a race. When
+// a stripe fills, its reader tries the lock and, if it gets it, moves every
+// buffered entry to the front of the list. If the lock is busy the next
+// put drains instead.
+
+#define READ_BUFFER_SIZE 16
+#define READ_BUFFER_MASK (READ_BUFFER_SIZE - 1)
+#define READ_STRIPES_PER_CPU 4
+#define READ_STRIPES_MAX 128
+#define NODE_FREED (UINT32_MAX - 1)     // next of a node back in the arena
+#define CLRU_ALIGN 64                   // Cache line
+
+// Node structure. The arena's free list overwrites the first four bytes
+// of a freed node, which only the writer reads, so entry comes after them
+typedef struct Node {
+    uint32_t prev;      // Toward the most recently used
+    uint32_t next;      // Toward the least recently used, or NODE_FREED
+    uint64_t entry;     // Key in the low half, value in the high half
+} Node;
+
+// One stripe of recorded hits. Readers advance tail; the drainer, under
+// the lock, advances head and clears the slots it consumed
+typedef struct ReadBuffer {
+    uint64_t tail;
+    uint64_t head;
+    uint32_t slots[READ_BUFFER_SIZE];
+} __attribute__((aligned(CLRU_ALIGN))) ReadBuffer;
+
+// Cache structure
+struct Cache {
+    ConcurrentIndex index;      // Written under the lock
+    NodeArena nodes;
+    ReadBuffer* buffers;
+    uint32_t stripe_mask;
+    int drain_pending;          // A full stripe is waiting for the lock
+    pthread_mutex_t lock;       // Guards the list, the arena and index writes
+    uint32_t head;              // Most recently used
+    uint32_t tail;              // Least recently used
+    uint64_t evictions;
+    int size;
+    int capacity;
+};
+
+// Stripe of the calling thread, assigned round robin on first use
+static __thread uint32_t thread_stripe;
+static uint32_t next_stripe;
+
+static inline uint64_t pack_entry(int key, int value) {
+    return (uint64_t)(uint32_t)key | (uint64_t)(uint32_t)value << 32;
+}
+
+static inline int entry_key(uint64_t entry) {
+    return (int)(uint32_t)entry;
+}
+
+static inline int entry_value(uint64_t entry) {
+    return (int)(uint32_t)(entry >> 32);
+}
+
+static inline Node* node_at(const Cache* cache, uint32_t handle) {
+    return (Node*)node_arena_at(&cache->nodes, handle);
+}
+
+// Unlink a node from the recency list
+static void list_remove(Cache* cache, Node* node) {
+    if (node->prev != NODE_ARENA_NONE) {
+        node_at(cache, node->prev)->next = node->next;
+    } else {
+        cache->head = node->next;
+    }
+    if (node->next != NODE_ARENA_NONE) {
+        node_at(cache, node->next)->prev = node->prev;
+    } else {
+        cache->tail = node->prev;
+    }
+}
+
+// Link a node in as the most recently used
+static void list_push_front(Cache* cache, Node* node, uint32_t handle) {
+    node->prev = NODE_ARENA_NONE;
+    node->next = cache->head;
+    if (cache->head != NODE_ARENA_NONE) {
+        node_at(cache, cache->head)->prev = handle;
+    } else {
+        cache->tail = handle;
+    }
+    cache->head = handle;
+}
+
+static void move_to_front(Cache* cache, uint32_t handle) {
+    if (cache->head != handle) {
+        Node* node = node_at(cache, handle);
+        list_remove(cache, node);
+        list_push_front(cache, node, handle);
+    }
+}
+
+// Replay every buffered hit onto the list; the lock must be held. A
+// handle freed since it was recorded is skipped, and one reused for a new
+// key just promotes that key
+static void drain_reads(Cache* cache) {
+    __atomic_store_n(&cache->drain_pending, 0, __ATOMIC_RELAXED);
+
+    for (uint32_t s = 0; s <= cache->stripe_mask; s++) {
+        ReadBuffer* buffer = &cache->buffers[s];
+        uint64_t head = buffer->head;
+        uint64_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++) {
+            // A reserved slot may not be written yet; stop there and come back
+            uint32_t* slot = &buffer->slots[head & READ_BUFFER_MASK];
+            uint32_t handle = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+            if (handle == NODE_ARENA_NONE) {
+                break;
+            }
+            __atomic_store_n(slot, NODE_ARENA_NONE, __ATOMIC_RELAXED);
+            if (node_at(cache, handle)->next != NODE_FREED) {
+                move_to_front(cache, handle);
+            }
+        }
+        __atomic_store_n(&buffer->head, head, __ATOMIC_RELEASE);
+    }
+}
+
+// Record a hit in the calling thread's stripe, draining if it fills and
+// the lock is free. Never waits
+static void record_read(Cache* cache, uint32_t handle) {
+    if (thread_stripe == 0) {
+        thread_stripe = __atomic_add_fetch(&next_stripe, 1, __ATOMIC_RELAXED);
+    }
+    ReadBuffer* buffer = &cache->buffers[thread_stripe & cache->stripe_mask];
+
+    uint64_t tail = __atomic_load_n(&buffer->tail, __ATOMIC_RELAXED);
+    uint64_t used = tail - __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+    if (used < READ_BUFFER_SIZE &&
+        __atomic_compare_exchange_n(&buffer->tail, &tail, tail + 1, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&buffer->slots[tail & READ_BUFFER_MASK], handle, __ATOMIC_RELEASE);
+        used++;
+    }
+
+    if (used >= READ_BUFFER_SIZE) {
+        if (pthread_mutex_trylock(&cache->lock) == 0) {
+            drain_reads(cache);
+            pthread_mutex_unlock(&cache->lock);
+        } else {
+            __atomic_store_n(&cache->drain_pending, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Take the lock for a write, first applying hits a reader couldn't
+static void lock_for_write(Cache* cache) {
+    pthread_mutex_lock(&cache->lock);
+    if (__atomic_load_n(&cache->drain_pending, __ATOMIC_RELAXED)) {
+        drain_reads(cache);
+    }
+}
+
+// Drop an entry from the list, the index and the arena; the lock must be held
+static void remove_node(Cache* cache, uint32_t handle) {
+    Node* node = node_at(cache, handle);
+    list_remove(cache, node);
+    concurrent_index_remove(&cache->index, entry_key(node->entry));
+    node->next = NODE_FREED;
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+}
+
+// Stripe count for this machine: a few per CPU, as a power of two
+static uint32_t stripe_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t want = cpus > 0 ? (uint32_t)cpus * READ_STRIPES_PER_CPU : READ_STRIPES_PER_CPU;
+    uint32_t count = 1;
+    while (count < want && count < READ_STRIPES_MAX) {
+        count <<= 1;
+    }
+    return count;
+}
+
+// Create a new cache
+Cache* create_concurrent_lru_cache(int capacity) {
+    return create_concurrent_lru_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_concurrent_lru_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0 || (uint32_t)capacity >= NODE_FREED) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    uint32_t stripes = stripe_count();
+    void* buffers;
+    if (posix_memalign(&buffers, CLRU_ALIGN, stripes * sizeof(ReadBuffer)) != 0) {
+        free(cache);
+        return NULL;
+    }
+    cache->buffers = (ReadBuffer*)buffers;
+    cache->stripe_mask = stripes - 1;
+
+    if (concurrent_index_init(&cache->index, capacity, sizing) != 0) {
+        free(cache->buffers);
+        free(cache);
+        return NULL;
+    }
+    if (node_arena_init(&cache->nodes, sizeof(Node), (uint32_t)capacity) != 0) {
+        concurrent_index_destroy(&cache->index);
+        free(cache->buffers);
+        free(cache);
+        return NULL;
+    }
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        node_arena_destroy(&cache->nodes);
+        concurrent_index_destroy(&cache->index);
+        free(cache->buffers);
+        free(cache);
+        return NULL;
+    }
+
+    memset(cache->buffers, 0, stripes * sizeof(ReadBuffer));
+    for (uint32_t s = 0; s < stripes; s++) {
+        memset(cache->buffers[s].slots, 0xff, sizeof(cache->buffers[s].slots));
+    }
+
+    cache->drain_pending = 0;
+    cache->head = NODE_ARENA_NONE;
+    cache->tail = NODE_ARENA_NONE;
+    cache->evictions = 0;
+    cache->size = 0;
+    cache->capacity = capacity;
+
+    return cache;
+}
+
+// Destroy the cache; no other thread may be using it
+void destroy_concurrent_lru_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    pthread_mutex_destroy(&cache->lock);
+    node_arena_destroy(&cache->nodes);
+    concurrent_index_destroy(&cache->index);
+    free(cache->buffers);
+    free(cache);
+}
+
+// Get value from cache without locking
+int get_concurrent_lru(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = concurrent_index_find(&cache->index, key);
+    if (handle == CONCURRENT_INDEX_NONE) {
+        return -1;  // Key not found
+    }
+
+    uint64_t entry = __atomic_load_n(&node_at(cache, handle)->entry, __ATOMIC_ACQUIRE);
+    if (entry_key(entry) != key) {
+        return -1;  // The node was evicted and reused since the lookup
+    }
+
+    record_read(cache, handle);
+    return entry_value(entry);
+}
+
+// Put value in cache
+void put_concurrent_lru(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    lock_for_write(cache);
+
+    // Check if key exists
+    uint32_t handle = concurrent_index_find(&cache->index, key);
+    if (handle != CONCURRENT_INDEX_NONE) {
+        __atomic_store_n(&node_at(cache, handle)->entry, pack_entry(key, value), __ATOMIC_RELEASE);
+        move_to_front(cache, handle);
+        pthread_mutex_unlock(&cache->lock);
+        return;
+    }
+
+    // If cache is full, remove the least recently used entry
+    if (cache->size >= cache->capacity) {
+        remove_node(cache, cache->tail);
+        cache->evictions++;
+    }
+
+    Node* node = (Node*)node_arena_alloc(&cache->nodes);
+    handle = node_arena_handle(&cache->nodes, node);
+    __atomic_store_n(&node->entry, pack_entry(key, value), __ATOMIC_RELEASE);
+    if (concurrent_index_insert(&cache->index, key, handle) != 0) {
+        node->next = NODE_FREED;
+        node_arena_free(&cache->nodes, node);
+        pthread_mutex_unlock(&cache->lock);
+        return;
+    }
+    list_push_front(cache, node, handle);
+    cache->size++;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Prefetch the index slots, then the nodes, of count keys
+static void prefetch_keys(Cache* cache, const int* keys, int count) {
+    for (int i = 0; i < count; i++) {
+        concurrent_index_prefetch(&cache->index, keys[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        uint32_t handle = concurrent_index_find(&cache->index, keys[i]);
+        if (handle != CONCURRENT_INDEX_NONE) {
+            __builtin_prefetch(node_at(cache, handle));
+        }
+    }
+}
+
+// Batched get (see cache_batch.h)
+void get_many_concurrent_lru(Cache* cache, const int* keys, int* values, int count) {
+    for (int base = 0; base < count; base += CACHE_BATCH_CHUNK) {
+        int n = count - base < CACHE_BATCH_CHUNK ? count - base : CACHE_BATCH_CHUNK;
+        if (cache) {
+            prefetch_keys(cache, keys + base, n);
+        }
+        for (int i = base; i < base + n; i++) {
+            values[i] = get_concurrent_lru(cache, keys[i]);
+        }
+    }
+}
+
+// Batched put (see cache_batch.h)
+void put_many_concurrent_lru(Cache* cache, const int* keys, const int* values, int count) {
+    for (int base = 0; base < count; base += CACHE_BATCH_CHUNK) {
+        int n = count - base < CACHE_BATCH_CHUNK ? count - base : CACHE_BATCH_CHUNK;
+        if (cache) {
+            prefetch_keys(cache, keys + base, n);
+        }
+        for (int i = base; i < base + n; i++) {
+            put_concurrent_lru(cache, keys[i], values[i]);
+        }
+    }
+}
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_concurrent_lru(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    lock_for_write(cache);
+    uint32_t handle = concurrent_index_find(&cache->index, key);
+    if (handle != CONCURRENT_INDEX_NONE) {
+        remove_node(cache, handle);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return handle != CONCURRENT_INDEX_NONE ? 0 : -1;
+}
+
+// Evict the least recently used entry; returns -1 if the cache is empty
+int evict_concurrent_lru(Cache* cache) {
+    if (!cache) {
+        return -1;
+    }
+
+    lock_for_write(cache);
+    int evicted = cache->size > 0;
+    if (evicted) {
+        remove_node(cache, cache->tail);
+        cache->evictions++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return evicted ? 0 : -1;
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// the least recently used entries that no longer fit; returns -1 if it is
+// out of range
+int resize_concurrent_lru(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    lock_for_write(cache);
+    cache->capacity = capacity;
+    while (cache->size > capacity) {
+        remove_node(cache, cache->tail);
+        cache->evictions++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_concurrent_lru_stats(Cache* cache, CacheStats* stats) {
+    pthread_mutex_lock(&cache->lock);
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Print cache contents
+void print_concurrent_lru_cache_contents(Cache* cache, const char* message) {
+    lock_for_write(cache);
+
+    printf("\n%s:\n", message);
+    printf("Cache contents (Most Recently Used → Least Recently Used):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\n");
+    printf("------------------------------------------------\n");
+
+    for (uint32_t h = cache->head; h != NODE_ARENA_NONE; h = node_at(cache, h)->next) {
+        uint64_t entry = node_at(cache, h)->entry;
+        printf("%d\t%d\n", entry_key(entry), entry_value(entry));
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d\n", cache->size, cache->capacity);
+
+    pthread_mutex_unlock(&cache->lock);
+}
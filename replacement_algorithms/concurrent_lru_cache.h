@@ -0,0 +1,31 @@
+#ifndef CONCURRENT_LRU_CACHE_H
+#define CONCURRENT_LRU_CACHE_H
+
+#include "cache_interface.h"
+
+// Thread-safe LRU whose gets never take a lock.
+//
+// Keys are found through a ConcurrentIndex (concurrent_index.h), and each
+// entry's key and value share one 64-bit word, so a reader can check that
+// the entry it reached still holds its key. A hit
+// does not touch the LRU list: it appends the entry to one of several
+// small per-thread read buffers, dropping it if that buffer is full. The
+// buffers are replayed onto the list under the cache's lock by whichever
+// thread next takes it, readers only with a try-lock, so recency is
+// approximate but reads scale with the thread count. Puts, erases and
+// evictions lock.
+
+Cache* create_concurrent_lru_cache(int capacity);
+Cache* create_concurrent_lru_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_concurrent_lru_cache(Cache* cache);
+int get_concurrent_lru(Cache* cache, int key);
+void put_concurrent_lru(Cache* cache, int key, int value);
+void get_many_concurrent_lru(Cache* cache, const int* keys, int* values, int count);
+void put_many_concurrent_lru(Cache* cache, const int* keys, const int* values, int count);
+int erase_concurrent_lru(Cache* cache, int key);
+int evict_concurrent_lru(Cache* cache);
+int resize_concurrent_lru(Cache* cache, int capacity);
+void get_concurrent_lru_stats(Cache* cache, CacheStats* stats);
+void print_concurrent_lru_cache_contents(Cache* cache, const char* message);
+
+#endif // CONCURRENT_LRU_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "epoch.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(SYS_membarrier)
+#define EPOCH_MEMBARRIER 1
+#endif
+
+__thread int epoch_thread_slot = -1;
+int epoch_reader_fence = 1;
+
+static pthread_once_t barrier_once = PTHREAD_ONCE_INIT;
+
+// Thread slots are shared by every domain
+static pthread_mutex_t slot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t slot_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slot_key;
+static uint8_t slot_used[EPOCH_MAX_THREADS];
+static uint32_t slot_high;      // Slots at or past this were never handed out
+
+// Thread exit: give the slot back. The thread is outside every section,
+// so its record in each domain already reads as quiescent
+static void release_slot(void* value) {
+    pthread_mutex_lock(&slot_lock);
+    slot_used[(uintptr_t)value - 1] = 0;
+    pthread_mutex_unlock(&slot_lock);
+}
+
+static void create_slot_key(void) {
+    pthread_key_create(&slot_key, release_slot);
+}
+
+// Claim a slot for the calling thread, waiting for one to come free if
+// EPOCH_MAX_THREADS threads already hold one
+int epoch_register_thread(void) {
+    pthread_once(&slot_once, create_slot_key);
+
+    for (;;) {
+        pthread_mutex_lock(&slot_lock);
+        for (int slot = 0; slot < EPOCH_MAX_THREADS; slot++) {
+            if (!slot_used[slot]) {
+                slot_used[slot] = 1;
+                if ((uint32_t)slot >= slot_high) {
+                    __atomic_store_n(&slot_high, (uint32_t)slot + 1, __ATOMIC_RELEASE);
+                }
+                pthread_mutex_unlock(&slot_lock);
+
+                pthread_setspecific(slot_key, (void*)(uintptr_t)(slot + 1));
+                epoch_thread_slot = slot;
+                return slot;
+            }
+        }
+        pthread_mutex_unlock(&slot_lock);
+        sched_yield();
+    }
+}
+
+// Let readers skip their fence if the process can use membarrier
+static void setup_barrier(void) {
+#if defined(EPOCH_MEMBARRIER)
+    if (syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0) {
+        epoch_reader_fence = 0;
+    }
+#endif
+}
+
+// Full barrier on this thread and, when readers don't fence, on every
+// thread of the process
+static void barrier_all(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#if defined(EPOCH_MEMBARRIER)
+    if (!epoch_reader_fence) {
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+    }
+#endif
+}
+
+// Release every object in a list and empty it
+static void release_list(EpochList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        list->items[i].release(list->items[i].object);
+    }
+    list->count = 0;
+}
+
+// Move to the next epoch if every reader inside a section has announced
+// the current one, then release what was retired two epochs ago. The
+// domain lock must be held
+static int try_advance(EpochDomain* domain) {
+    // Order the writer's unlinking stores, and every reader's announcement,
+    // before the scan
+    barrier_all();
+
+    uint64_t epoch = domain->epoch;
+    uint64_t current = (epoch << 1) | 1;
+    uint32_t high = __atomic_load_n(&slot_high, __ATOMIC_ACQUIRE);
+
+    for (uint32_t slot = 0; slot < high; slot++) {
+        uint64_t state = __atomic_load_n(&domain->records[slot].state, __ATOMIC_ACQUIRE);
+        if (state != 0 && state != current) {
+            return 0;   // A reader may still hold pointers from an older epoch
+        }
+    }
+
+    __atomic_store_n(&domain->epoch, epoch + 1, __ATOMIC_RELEASE);
+
+    EpochList* expired = &domain->limbo[(epoch + 2) % 3];   // Retired in epoch - 1
+    __atomic_store_n(&domain->pending, domain->pending - expired->count, __ATOMIC_RELAXED);
+    release_list(expired);
+    return 1;
+}
+
+// Initialize a domain
+int epoch_init(EpochDomain* domain) {
+    pthread_once(&barrier_once, setup_barrier);
+
+    void* records;
+    if (posix_memalign(&records, EPOCH_ALIGN, EPOCH_MAX_THREADS * sizeof(EpochRecord)) != 0) {
+        return -1;
+    }
+    if (pthread_mutex_init(&domain->lock, NULL) != 0) {
+        free(records);
+        return -1;
+    }
+
+    memset(records, 0, EPOCH_MAX_THREADS * sizeof(EpochRecord));
+    memset(domain->limbo, 0, sizeof(domain->limbo));
+    domain->records = (EpochRecord*)records;
+    domain->epoch = 1;
+    domain->pending = 0;
+    return 0;
+}
+
+// Release everything still retired and free the domain; no thread may be
+// inside one of its sections
+void epoch_destroy(EpochDomain* domain) {
+    for (int i = 0; i < 3; i++) {
+        release_list(&domain->limbo[i]);
+        free(domain->limbo[i].items);
+    }
+    pthread_mutex_destroy(&domain->lock);
+    free(domain->records);
+    domain->records = NULL;
+}
+
+// Hand over an object that readers can no longer reach; it is released
+// once they have all left the sections that might have reached it. If the
+// list can't grow, wait for the grace period here instead
+void epoch_retire(EpochDomain* domain, void* object, void (*release)(void* object)) {
+    pthread_mutex_lock(&domain->lock);
+
+    EpochList* list = &domain->limbo[domain->epoch % 3];
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        EpochRetired* items = (EpochRetired*)realloc(list->items, capacity * sizeof(EpochRetired));
+        if (!items) {
+            // Two advances end every section that could have seen the object
+            uint64_t target = domain->epoch + 2;
+            while (domain->epoch < target) {
+                if (!try_advance(domain)) {
+                    pthread_mutex_unlock(&domain->lock);
+                    sched_yield();
+                    pthread_mutex_lock(&domain->lock);
+                }
+            }
+            pthread_mutex_unlock(&domain->lock);
+            release(object);
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count].object = object;
+    list->items[list->count].release = release;
+    list->count++;
+    __atomic_store_n(&domain->pending, domain->pending + 1, __ATOMIC_RELAXED);
+
+    try_advance(domain);
+    pthread_mutex_unlock(&domain->lock);
+}
+
+// Try to advance the epoch and release expired objects; cheap when
+// nothing is waiting
+void epoch_collect(EpochDomain* domain) {
+    if (__atomic_load_n(&domain->pending, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&domain->lock);
+    try_advance(domain);
+    pthread_mutex_unlock(&domain->lock);
+}
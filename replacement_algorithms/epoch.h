@@ -0,0 +1,95 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// Epoch-based reclamation for structures read without locks.
+//
+// Readers bracket every access with epoch_enter/epoch_exit, which only
+// publish the domain's current epoch in the calling thread's own record
+// (one cache line per thread, so readers never share a written line).
+// Writers unlink an object first and then hand it to epoch_retire instead
+// of freeing it. The domain's epoch moves on only once every reader inside
+// a section has seen the current one, so an object retired in epoch e is
+// released once the epoch reaches e + 2: by then every reader that could
+// still have held a pointer to it has left its section.
+//
+// Each thread takes one of EPOCH_MAX_THREADS slots the first time it
+// enters any domain and gives it back when it exits. Sections nest.
+//
+// On Linux the memory barrier that orders a reader's announcement before
+// its loads is paid by the writer instead: before scanning the records it
+// issues membarrier(2), which runs a full barrier on every CPU running one
+// of the process's threads. A fence per read section would also stall it
+// until the previous section's cache misses had been served. Where
+// membarrier is unavailable each reader fences.
+
+#define EPOCH_MAX_THREADS 256
+#define EPOCH_ALIGN 64              // Cache line
+
+// One thread's announcement in a domain
+typedef struct EpochRecord {
+    uint64_t state;         // (epoch << 1) | 1 inside a section, 0 outside
+    uint32_t depth;         // Nesting, only touched by the owning thread
+} __attribute__((aligned(EPOCH_ALIGN))) EpochRecord;
+
+// Retired object waiting for its grace period
+typedef struct EpochRetired {
+    void* object;
+    void (*release)(void* object);
+} EpochRetired;
+
+// Objects retired in one epoch
+typedef struct EpochList {
+    EpochRetired* items;
+    size_t count;
+    size_t capacity;
+} EpochList;
+
+// Domain structure
+typedef struct EpochDomain {
+    uint64_t epoch;
+    EpochRecord* records;       // EPOCH_MAX_THREADS, indexed by thread slot
+    pthread_mutex_t lock;       // Guards the lists and advancing the epoch
+    EpochList limbo[3];         // By retirement epoch, modulo 3
+    size_t pending;             // Objects in limbo
+} EpochDomain;
+
+extern __thread int epoch_thread_slot;  // Calling thread's slot, or -1
+extern int epoch_reader_fence;          // Readers fence; set up by epoch_init
+
+int epoch_init(EpochDomain* domain);
+void epoch_destroy(EpochDomain* domain);
+int epoch_register_thread(void);
+void epoch_retire(EpochDomain* domain, void* object, void (*release)(void* object));
+void epoch_collect(EpochDomain* domain);
+
+// Start a read section: objects reachable now stay valid until epoch_exit
+static inline void epoch_enter(EpochDomain* domain) {
+    int slot = epoch_thread_slot >= 0 ? epoch_thread_slot : epoch_register_thread();
+    EpochRecord* record = &domain->records[slot];
+
+    if (record->depth++ == 0) {
+        uint64_t epoch = __atomic_load_n(&domain->epoch, __ATOMIC_RELAXED);
+        __atomic_store_n(&record->state, (epoch << 1) | 1, __ATOMIC_RELAXED);
+        // Order the announcement before every load of the section
+        if (epoch_reader_fence) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        } else {
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        }
+    }
+}
+
+// End a read section
+static inline void epoch_exit(EpochDomain* domain) {
+    EpochRecord* record = &domain->records[epoch_thread_slot];
+
+    if (--record->depth == 0) {
+        __atomic_store_n(&record->state, 0, __ATOMIC_RELEASE);
+    }
+}
+
+#endif // EPOCH_H 
\ No newline at end of file
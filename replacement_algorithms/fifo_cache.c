@@ -1,122 +1,68 @@
 #include "fifo_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
 #include <string.h>
 
-#define HASH_SIZE 1000
-
-// Node structure for queue
-typedef struct FIFONode {
+// Slot structure. FIFO order never changes on a hit, so entries live in a
+// fixed circular array in insertion order and the index maps each key to
+// its 32-bit slot number; no links or timestamps are needed.
+//
+// An erased entry leaves a hole: its slot stays in the ring, but the index
+// no longer maps its key there, which is how evictions recognize and skip
+// it. The ring has a quarter of the capacity in spare slots, so it only
+// fills up (and is compacted) after that many erases, keeping erase
+// amortized O(1).
+typedef struct FIFOSlot {
     int key;
     int value;
-    int time_added;
-    struct FIFONode* prev;
-    struct FIFONode* next;
-} FIFONode;
-
-// Hash entry structure
-typedef struct HashEntry {
-    int key;
-    FIFONode* node;
-    struct HashEntry* next;
-} HashEntry;
+} FIFOSlot;
 
 // Cache structure
 struct Cache {
-    FIFONode* head;    // First in (oldest)
-    FIFONode* tail;    // Last in (newest)
-    HashEntry** hash_table;
+    CacheIndex index;
+    NodeArena slots;    // ring_size slots, used as a ring
+    uint32_t ring_size;
+    uint32_t head;      // First in (oldest)
+    uint32_t used;      // Slots from head on, including holes
+    uint32_t holes;
+    uint64_t evictions;
     int size;
     int capacity;
-    int current_time;
 };
 
-// Hash function
-static unsigned int hash(int key) {
-    return (unsigned int)key % HASH_SIZE;
-}
-
-// Create a new FIFO node
-static FIFONode* create_node(int key, int value, Cache* cache) {
-    FIFONode* node = (FIFONode*)malloc(sizeof(FIFONode));
-    if (node) {
-        node->key = key;
-        node->value = value;
-        node->time_added = cache->current_time++;
-        node->prev = NULL;
-        node->next = NULL;
-    }
-    return node;
+// Slot at a ring position
+static FIFOSlot* slot_at(Cache* cache, uint32_t pos) {
+    return (FIFOSlot*)node_arena_at(&cache->slots, pos);
 }
 
-// Create a new hash entry
-static HashEntry* create_hash_entry(int key, FIFONode* node) {
-    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
-    if (entry) {
-        entry->key = key;
-        entry->node = node;
-        entry->next = NULL;
-    }
-    return entry;
+// Ring position offset slots after pos
+static uint32_t ring_pos(const Cache* cache, uint32_t pos, uint32_t offset) {
+    return (pos + offset) % cache->ring_size;
 }
 
-// Add node to end of queue (newest)
-static void add_to_queue(Cache* cache, FIFONode* node) {
-    if (!cache->tail) {
-        cache->head = node;
-        cache->tail = node;
-    } else {
-        node->prev = cache->tail;
-        cache->tail->next = node;
-        cache->tail = node;
-    }
+// Whether the slot at a ring position holds a live entry rather than a hole
+static int slot_live(Cache* cache, uint32_t pos) {
+    return cache->holes == 0 || cache_index_find(&cache->index, slot_at(cache, pos)->key) == pos;
 }
 
-// Remove node from queue
-static void remove_node(Cache* cache, FIFONode* node) {
-    if (node->prev) {
-        node->prev->next = node->next;
-    } else {
-        cache->head = node->next;
-    }
-    
-    if (node->next) {
-        node->next->prev = node->prev;
-    } else {
-        cache->tail = node->prev;
-    }
-}
-
-// Remove entry from hash table
-static void remove_from_hash(Cache* cache, int key) {
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    HashEntry* prev = NULL;
-
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                cache->hash_table[h] = entry->next;
-            }
-            free(entry);
-            return;
-        }
-        prev = entry;
-        entry = entry->next;
+// Look up the slot for key, or NULL
+static FIFOSlot* find_slot(Cache* cache, int key) {
+    uint32_t pos = cache_index_find(&cache->index, key);
+    if (pos == CACHE_INDEX_NONE) {
+        return NULL;
     }
-}
-
-// Add entry to hash table
-static void add_to_hash(Cache* cache, int key, FIFONode* node) {
-    unsigned int h = hash(key);
-    HashEntry* entry = create_hash_entry(key, node);
-    entry->next = cache->hash_table[h];
-    cache->hash_table[h] = entry;
+    return slot_at(cache, pos);
 }
 
 // Create a new cache
 Cache* create_fifo_cache(int capacity) {
-    if (capacity <= 0 || capacity > MAX_CACHE_SIZE) {
+    return create_fifo_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_fifo_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0) {
         return NULL;
     }
 
@@ -125,17 +71,25 @@ Cache* create_fifo_cache(int capacity) {
         return NULL;
     }
 
-    cache->hash_table = (HashEntry**)calloc(HASH_SIZE, sizeof(HashEntry*));
-    if (!cache->hash_table) {
+    if (cache_index_init(&cache->index, capacity, sizing) != 0) {
         free(cache);
         return NULL;
     }
 
-    cache->head = NULL;
-    cache->tail = NULL;
+    uint32_t ring_size = (uint32_t)capacity + (uint32_t)capacity / 4 + 1;
+    if (node_arena_init(&cache->slots, sizeof(FIFOSlot), ring_size) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    cache->ring_size = ring_size;
+    cache->head = 0;
+    cache->used = 0;
+    cache->holes = 0;
+    cache->evictions = 0;
     cache->size = 0;
     cache->capacity = capacity;
-    cache->current_time = 0;
 
     return cache;
 }
@@ -146,25 +100,8 @@ void destroy_fifo_cache(Cache* cache) {
         return;
     }
 
-    // Free all nodes in the queue
-    FIFONode* current = cache->head;
-    while (current) {
-        FIFONode* next = current->next;
-        free(current);
-        current = next;
-    }
-
-    // Free all hash entries
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashEntry* entry = cache->hash_table[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
-    }
-
-    free(cache->hash_table);
+    node_arena_destroy(&cache->slots);
+    cache_index_destroy(&cache->index);
     free(cache);
 }
 
@@ -174,17 +111,31 @@ int get_fifo(Cache* cache, int key) {
         return -1;
     }
 
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            return entry->node->value;
+    FIFOSlot* slot = find_slot(cache, key);
+    if (!slot) {
+        return -1;  // Key not found
+    }
+
+    return slot->value;
+}
+
+// Close up the holes, keeping insertion order
+static void compact(Cache* cache) {
+    uint32_t live = 0;
+
+    for (uint32_t i = 0; i < cache->used; i++) {
+        uint32_t from = ring_pos(cache, cache->head, i);
+        if (slot_live(cache, from)) {
+            uint32_t to = ring_pos(cache, cache->head, live++);
+            if (to != from) {
+                FIFOSlot* slot = slot_at(cache, to);
+                *slot = *slot_at(cache, from);
+                cache_index_update(&cache->index, slot->key, to);
+            }
         }
-        entry = entry->next;
     }
-    
-    return -1;  // Key not found
+    cache->used = live;
+    cache->holes = 0;
 }
 
 // Put value in cache
@@ -194,54 +145,117 @@ void put_fifo(Cache* cache, int key, int value) {
     }
 
     // Check if key exists
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->value = value;
-            return;
-        }
-        entry = entry->next;
-    }
-
-    // Create new node
-    FIFONode* new_node = create_node(key, value, cache);
-    if (!new_node) {
+    FIFOSlot* slot = find_slot(cache, key);
+    if (slot) {
+        slot->value = value;
         return;
     }
 
-    // If cache is full, remove oldest entry (from head)
     if (cache->size >= cache->capacity) {
-        FIFONode* oldest = cache->head;
-        remove_node(cache, oldest);
-        remove_from_hash(cache, oldest->key);
-        free(oldest);
-        cache->size--;
+        evict_fifo(cache);
+    }
+    if (cache->used == cache->ring_size) {
+        compact(cache);
+    }
+
+    uint32_t pos = ring_pos(cache, cache->head, cache->used);
+    if (cache_index_insert(&cache->index, key, pos) != 0) {
+        return;
     }
 
-    // Add new node to end of queue
-    add_to_queue(cache, new_node);
-    add_to_hash(cache, key, new_node);
+    slot = slot_at(cache, pos);
+    slot->key = key;
+    slot->value = value;
+    cache->used++;
     cache->size++;
 }
 
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(fifo, slots, UINT32_MAX, 0)
+
+// Remove key from the cache, leaving a hole in the ring; returns -1 if it
+// was not cached
+int erase_fifo(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t pos = cache_index_remove(&cache->index, key);
+    if (pos == CACHE_INDEX_NONE) {
+        return -1;
+    }
+
+    if (pos == ring_pos(cache, cache->head, cache->used - 1)) {
+        cache->used--;      // The newest entry: just give its slot back
+    } else {
+        cache->holes++;
+    }
+    cache->size--;
+    return 0;
+}
+
+// Evict the oldest entry, skipping holes; returns -1 if the cache is empty
+int evict_fifo(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    while (!slot_live(cache, cache->head)) {
+        cache->head = ring_pos(cache, cache->head, 1);
+        cache->used--;
+        cache->holes--;
+    }
+
+    cache_index_remove(&cache->index, slot_at(cache, cache->head)->key);
+    cache->head = ring_pos(cache, cache->head, 1);
+    cache->used--;
+    cache->size--;
+    cache->evictions++;
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// the oldest entries that no longer fit; returns -1 if it is out of range.
+// The ring keeps its size, so a smaller capacity only adds spare slots
+int resize_fifo(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 ||
+        (uint32_t)capacity + (uint32_t)capacity / 4 + 1 > cache->ring_size) {
+        return -1;
+    }
+
+    cache->capacity = capacity;
+    while (cache->size > capacity) {
+        evict_fifo(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_fifo_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
 // Print cache contents
 void print_fifo_cache_contents(Cache* cache, const char* message) {
     printf("\n%s:\n", message);
     printf("Cache contents (First In → Last In):\n");
     printf("------------------------------------------------\n");
-    printf("Key\tValue\tTime Added\n");
+    printf("Key\tValue\tSlot\n");
     printf("------------------------------------------------\n");
-    
-    FIFONode* current = cache->head;
-    while (current) {
-        printf("%d\t%d\t%d\n", 
-               current->key, 
-               current->value, 
-               current->time_added);
-        current = current->next;
+
+    for (uint32_t i = 0; i < cache->used; i++) {
+        uint32_t pos = ring_pos(cache, cache->head, i);
+        if (!slot_live(cache, pos)) {
+            continue;
+        }
+        FIFOSlot* current = slot_at(cache, pos);
+        printf("%d\t%d\t%u\n",
+               current->key,
+               current->value,
+               pos);
     }
     printf("------------------------------------------------\n");
     printf("Cache size: %d/%d\n", cache->size, cache->capacity);
-} 
\ No newline at end of file
+}
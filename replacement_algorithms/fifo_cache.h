@@ -4,9 +4,16 @@
 #include "cache_interface.h"
 
 Cache* create_fifo_cache(int capacity);
+Cache* create_fifo_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_fifo_cache(Cache* cache);
 int get_fifo(Cache* cache, int key);
 void put_fifo(Cache* cache, int key, int value);
+void get_many_fifo(Cache* cache, const int* keys, int* values, int count);
+void put_many_fifo(Cache* cache, const int* keys, const int* values, int count);
+int erase_fifo(Cache* cache, int key);
+int evict_fifo(Cache* cache);
+int resize_fifo(Cache* cache, int capacity);
+void get_fifo_stats(Cache* cache, CacheStats* stats);
 void print_fifo_cache_contents(Cache* cache, const char* message);
 
 // FIFO specific declarations can be added here if needed
@@ -0,0 +1,223 @@
+#include "frequency_sketch.h"
+#include "cache_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SKETCH_BLOCK_WORDS 8        // 64 bytes
+#define SKETCH_BLOCK_COUNTERS 128   // 4-bit counters per block
+#define SKETCH_DEPTH 4              // Counters per key
+#define SKETCH_COUNTER_MAX 15
+#define SKETCH_ENTRIES_PER_BLOCK 128    // Cached entries per block (0.5 byte each)
+#define SKETCH_SAMPLE_FACTOR 10     // Halve after 10 accesses per cached entry
+
+// Largest power of two not above n (n >= 1)
+static size_t floor_pow2(size_t n) {
+    size_t p = 1;
+    while (p <= n / 2) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Second hash for picking counters and doorkeeper bits, independent of the
+// bits the index and the block choice use
+static uint64_t rehash(uint64_t h) {
+    h *= 0xbf58476d1ce4e5b9ull;
+    return h ^ (h >> 31);
+}
+
+// Block count for a cache of the given capacity
+static size_t blocks_for(size_t entries) {
+    return floor_pow2(entries / SKETCH_ENTRIES_PER_BLOCK > 0
+                      ? entries / SKETCH_ENTRIES_PER_BLOCK : 1);
+}
+
+// Doorkeeper bits for a cache of the given capacity: one per cached entry,
+// rounded down to a power of two (and never less than one word)
+static size_t door_bits_for(size_t entries) {
+    return floor_pow2(entries) < 64 ? 64 : floor_pow2(entries);
+}
+
+static uint32_t sample_size_for(size_t entries) {
+    return entries * SKETCH_SAMPLE_FACTOR < UINT32_MAX
+           ? (uint32_t)(entries * SKETCH_SAMPLE_FACTOR) : UINT32_MAX;
+}
+
+// Size the sketch for a cache of the given capacity
+int frequency_sketch_init(FrequencySketch* sketch, int capacity) {
+    size_t entries = capacity > 0 ? (size_t)capacity : 1;
+    size_t blocks = blocks_for(entries);
+    size_t block_bytes = blocks * SKETCH_BLOCK_WORDS * sizeof(uint64_t);
+    size_t door_bits = door_bits_for(entries);
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, 64, block_bytes) != 0) {
+        return -1;
+    }
+    sketch->blocks = (uint64_t*)memory;
+    sketch->doorkeeper = (uint64_t*)calloc(door_bits / 64, sizeof(uint64_t));
+    if (!sketch->doorkeeper) {
+        free(sketch->blocks);
+        return -1;
+    }
+
+    memset(sketch->blocks, 0, block_bytes);
+    sketch->block_mask = blocks - 1;
+    sketch->door_mask = door_bits - 1;
+    sketch->additions = 0;
+    sketch->sample_size = sample_size_for(entries);
+    return 0;
+}
+
+// Add every counter of block from into block to, saturating at the maximum
+static void merge_block(uint64_t* to, const uint64_t* from) {
+    for (unsigned i = 0; i < SKETCH_BLOCK_COUNTERS; i++) {
+        unsigned shift = (i % 16) * 4;
+        uint64_t sum = ((to[i / 16] >> shift) & 0xf) + ((from[i / 16] >> shift) & 0xf);
+        sum = sum > SKETCH_COUNTER_MAX ? SKETCH_COUNTER_MAX : sum;
+        to[i / 16] = (to[i / 16] & ~((uint64_t)0xf << shift)) | sum << shift;
+    }
+}
+
+// Resize the sketch for a new cache capacity, no larger than the one it
+// was created for. A key's block and doorkeeper bits are low bits of its
+// hashes, so shrinking folds the upper half of the blocks and bits onto
+// the lower half (adding counters, as a smaller sketch would have counted
+// both keys together) and growing copies the lower half upward; either way
+// every key keeps its estimate
+void frequency_sketch_resize(FrequencySketch* sketch, int capacity) {
+    size_t entries = capacity > 0 ? (size_t)capacity : 1;
+    size_t blocks = blocks_for(entries);
+    size_t door_words = door_bits_for(entries) / 64;
+    size_t old_blocks = sketch->block_mask + 1;
+    size_t old_door_words = (sketch->door_mask + 1) / 64;
+
+    for (; old_blocks > blocks; old_blocks /= 2) {
+        for (size_t i = 0; i < old_blocks / 2; i++) {
+            merge_block(sketch->blocks + i * SKETCH_BLOCK_WORDS,
+                        sketch->blocks + (i + old_blocks / 2) * SKETCH_BLOCK_WORDS);
+        }
+    }
+    for (; old_blocks < blocks; old_blocks *= 2) {
+        memcpy(sketch->blocks + old_blocks * SKETCH_BLOCK_WORDS, sketch->blocks,
+               old_blocks * SKETCH_BLOCK_WORDS * sizeof(uint64_t));
+    }
+    for (; old_door_words > door_words; old_door_words /= 2) {
+        for (size_t i = 0; i < old_door_words / 2; i++) {
+            sketch->doorkeeper[i] |= sketch->doorkeeper[i + old_door_words / 2];
+        }
+    }
+    for (; old_door_words < door_words; old_door_words *= 2) {
+        memcpy(sketch->doorkeeper + old_door_words, sketch->doorkeeper,
+               old_door_words * sizeof(uint64_t));
+    }
+
+    sketch->block_mask = blocks - 1;
+    sketch->door_mask = door_words * 64 - 1;
+    sketch->sample_size = sample_size_for(entries);
+}
+
+// Free the sketch
+void frequency_sketch_destroy(FrequencySketch* sketch) {
+    free(sketch->blocks);
+    free(sketch->doorkeeper);
+    sketch->blocks = NULL;
+    sketch->doorkeeper = NULL;
+}
+
+// Block for a key: the top bits of its hash
+static uint64_t* block_for(const FrequencySketch* sketch, uint64_t h) {
+    size_t block = (size_t)(h >> 40) & sketch->block_mask;
+    return sketch->blocks + block * SKETCH_BLOCK_WORDS;
+}
+
+// Read counter i (0-127) of a block
+static int counter_get(const uint64_t* block, unsigned i) {
+    return (int)((block[i / 16] >> ((i % 16) * 4)) & 0xf);
+}
+
+// Doorkeeper bit positions for a key (two bits, k = 2)
+static size_t door_bit(const FrequencySketch* sketch, uint64_t r, int which) {
+    return (size_t)(which ? r >> 32 : r) & sketch->door_mask;
+}
+
+static int door_test(const FrequencySketch* sketch, size_t bit) {
+    return (int)((sketch->doorkeeper[bit / 64] >> (bit % 64)) & 1);
+}
+
+// Halve every counter and clear the doorkeeper
+static void halve(FrequencySketch* sketch) {
+    size_t words = (sketch->block_mask + 1) * SKETCH_BLOCK_WORDS;
+
+    for (size_t i = 0; i < words; i++) {
+        sketch->blocks[i] = (sketch->blocks[i] >> 1) & 0x7777777777777777ull;
+    }
+    memset(sketch->doorkeeper, 0, (sketch->door_mask + 1) / 8);
+    sketch->additions /= 2;
+}
+
+// Record one access to key
+void frequency_sketch_increment(FrequencySketch* sketch, int key) {
+    uint64_t h = cache_hash_key(key);
+    uint64_t r = rehash(h);
+    size_t bit0 = door_bit(sketch, r, 0);
+    size_t bit1 = door_bit(sketch, r, 1);
+
+    if (!door_test(sketch, bit0) || !door_test(sketch, bit1)) {
+        // First sighting since the last halving: only remember the key
+        sketch->doorkeeper[bit0 / 64] |= (uint64_t)1 << (bit0 % 64);
+        sketch->doorkeeper[bit1 / 64] |= (uint64_t)1 << (bit1 % 64);
+    } else {
+        // Conservative update: only the counters at the current minimum
+        // grow, which keeps collisions from inflating the estimate
+        uint64_t* block = block_for(sketch, h);
+        unsigned idx[SKETCH_DEPTH];
+        int min = SKETCH_COUNTER_MAX;
+
+        for (int d = 0; d < SKETCH_DEPTH; d++) {
+            idx[d] = (unsigned)(r >> (d * 7)) & (SKETCH_BLOCK_COUNTERS - 1);
+            int count = counter_get(block, idx[d]);
+            if (count < min) {
+                min = count;
+            }
+        }
+        if (min < SKETCH_COUNTER_MAX) {
+            for (int d = 0; d < SKETCH_DEPTH; d++) {
+                if (counter_get(block, idx[d]) == min) {
+                    block[idx[d] / 16] += (uint64_t)1 << ((idx[d] % 16) * 4);
+                }
+            }
+        }
+    }
+
+    if (++sketch->additions >= sketch->sample_size) {
+        halve(sketch);
+    }
+}
+
+// Estimated accesses to key since it was last aged
+int frequency_sketch_estimate(const FrequencySketch* sketch, int key) {
+    uint64_t h = cache_hash_key(key);
+    uint64_t r = rehash(h);
+
+    if (!door_test(sketch, door_bit(sketch, r, 0)) ||
+        !door_test(sketch, door_bit(sketch, r, 1))) {
+        return 0;
+    }
+
+    const uint64_t* block = block_for(sketch, h);
+    int min = SKETCH_COUNTER_MAX;
+    for (int d = 0; d < SKETCH_DEPTH; d++) {
+        int count = counter_get(block, (unsigned)(r >> (d * 7)) & (SKETCH_BLOCK_COUNTERS - 1));
+        if (count < min) {
+            min = count;
+        }
+    }
+    return min + 1;     // The doorkeeper holds the first access
+}
+
+// Memory used by the counters and the doorkeeper
+size_t frequency_sketch_bytes(const FrequencySketch* sketch) {
+    return (sketch->block_mask + 1) * SKETCH_BLOCK_WORDS * sizeof(uint64_t) +
+           (sketch->door_mask + 1) / 8;
+}
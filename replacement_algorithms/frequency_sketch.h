@@ -0,0 +1,34 @@
+#ifndef FREQUENCY_SKETCH_H
+#define FREQUENCY_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Approximate access counts for TinyLFU admission.
+//
+// A count-min sketch of 4-bit counters, organised as 64-byte blocks of 128
+// counters. A key hashes to one block and picks its four counters inside
+// it, so recording or estimating a key touches a single cache line. In
+// front of it sits a doorkeeper bloom filter: a key's first access only
+// sets its doorkeeper bits, so keys seen once never reach the counters.
+// After a sample of accesses proportional to the cache size every counter
+// is halved and the doorkeeper is cleared, so old popularity fades.
+
+// Sketch structure
+typedef struct FrequencySketch {
+    uint64_t* blocks;       // 8 words (one cache line) per block
+    uint64_t* doorkeeper;   // Bloom filter bits
+    size_t block_mask;      // Block count - 1
+    size_t door_mask;       // Doorkeeper bit count - 1
+    uint32_t additions;     // Accesses recorded since the last halving
+    uint32_t sample_size;   // Accesses between halvings
+} FrequencySketch;
+
+int frequency_sketch_init(FrequencySketch* sketch, int capacity);
+void frequency_sketch_destroy(FrequencySketch* sketch);
+void frequency_sketch_resize(FrequencySketch* sketch, int capacity);
+void frequency_sketch_increment(FrequencySketch* sketch, int key);
+int frequency_sketch_estimate(const FrequencySketch* sketch, int key);
+size_t frequency_sketch_bytes(const FrequencySketch* sketch);
+
+#endif // FREQUENCY_SKETCH_H
@@ -1,142 +1,190 @@
 #include "lfu_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
 #include <string.h>
 
-#define HASH_SIZE 1000
+typedef struct FreqBucket FreqBucket;
 
 // Node structure for doubly linked list with frequency
 typedef struct LFUNode {
     int key;
     int value;
     int frequency;
+    FreqBucket* bucket;     // Bucket holding every node with this frequency
     struct LFUNode* prev;
     struct LFUNode* next;
 } LFUNode;
 
-// Hash entry structure
-typedef struct HashEntry {
-    int key;
-    LFUNode* node;
-    struct HashEntry* next;
-} HashEntry;
+// All nodes sharing one access frequency, most recently used first
+struct FreqBucket {
+    int frequency;
+    LFUNode* head;          // Most recently used
+    LFUNode* tail;          // Least recently used
+    struct FreqBucket* prev;
+    struct FreqBucket* next;
+};
 
 // Cache structure
 struct Cache {
-    LFUNode* head;
-    LFUNode* tail;
-    HashEntry** hash_table;
+    FreqBucket* min_bucket;     // Lowest frequency, head of the bucket list
+    CacheIndex index;
+    NodeArena nodes;
+    NodeArena buckets;          // At most capacity + 1 buckets are ever live
+    uint64_t evictions;
     int size;
     int capacity;
 };
 
-// Hash function
-static unsigned int hash(int key) {
-    return (unsigned int)key % HASH_SIZE;
-}
-
 // Create a new LFU node
-static LFUNode* create_node(int key, int value) {
-    LFUNode* node = (LFUNode*)malloc(sizeof(LFUNode));
+static LFUNode* create_node(int key, int value, Cache* cache) {
+    LFUNode* node = (LFUNode*)node_arena_alloc(&cache->nodes);
     if (node) {
         node->key = key;
         node->value = value;
         node->frequency = 1;
+        node->bucket = NULL;
         node->prev = NULL;
         node->next = NULL;
     }
     return node;
 }
 
-// Create a new hash entry
-static HashEntry* create_hash_entry(int key, LFUNode* node) {
-    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
-    if (entry) {
-        entry->key = key;
-        entry->node = node;
-        entry->next = NULL;
+// Look up the node for key, or NULL
+static LFUNode* find_node(Cache* cache, int key) {
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE) {
+        return NULL;
     }
-    return entry;
+    return (LFUNode*)node_arena_at(&cache->nodes, handle);
 }
 
-// Add node to list
-static void add_node(Cache* cache, LFUNode* node) {
-    if (!cache->head) {
-        cache->head = node;
-        cache->tail = node;
-        return;
+// Create an empty bucket and link it after prev (or at the head if prev is NULL)
+static FreqBucket* insert_bucket_after(Cache* cache, FreqBucket* prev, int frequency) {
+    FreqBucket* bucket = (FreqBucket*)node_arena_alloc(&cache->buckets);
+    if (!bucket) {
+        return NULL;
+    }
+
+    bucket->frequency = frequency;
+    bucket->head = NULL;
+    bucket->tail = NULL;
+    bucket->prev = prev;
+    bucket->next = prev ? prev->next : cache->min_bucket;
+
+    if (bucket->next) {
+        bucket->next->prev = bucket;
+    }
+    if (prev) {
+        prev->next = bucket;
+    } else {
+        cache->min_bucket = bucket;
+    }
+    return bucket;
+}
+
+// Unlink and free a bucket that no longer holds any node
+static void remove_bucket(Cache* cache, FreqBucket* bucket) {
+    if (bucket->prev) {
+        bucket->prev->next = bucket->next;
+    } else {
+        cache->min_bucket = bucket->next;
+    }
+
+    if (bucket->next) {
+        bucket->next->prev = bucket->prev;
     }
-    
-    // Add to end of list
-    node->prev = cache->tail;
-    cache->tail->next = node;
-    cache->tail = node;
+    node_arena_free(&cache->buckets, bucket);
 }
 
-// Remove node from list
-static void remove_node(Cache* cache, LFUNode* node) {
+// Add node to the front of its bucket (most recently used)
+static void add_node(FreqBucket* bucket, LFUNode* node) {
+    node->bucket = bucket;
+    node->prev = NULL;
+    node->next = bucket->head;
+
+    if (bucket->head) {
+        bucket->head->prev = node;
+    }
+    bucket->head = node;
+
+    if (!bucket->tail) {
+        bucket->tail = node;
+    }
+}
+
+// Remove node from its bucket
+static void remove_node(LFUNode* node) {
+    FreqBucket* bucket = node->bucket;
+
     if (node->prev) {
         node->prev->next = node->next;
     } else {
-        cache->head = node->next;
+        bucket->head = node->next;
     }
-    
+
     if (node->next) {
         node->next->prev = node->prev;
     } else {
-        cache->tail = node->prev;
+        bucket->tail = node->prev;
     }
 }
 
-// Remove entry from hash table
-static void remove_from_hash(Cache* cache, int key) {
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    HashEntry* prev = NULL;
-
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                cache->hash_table[h] = entry->next;
-            }
-            free(entry);
-            return;
+// Bump a node's frequency, moving it into the next bucket
+static void touch_node(Cache* cache, LFUNode* node) {
+    FreqBucket* bucket = node->bucket;
+    FreqBucket* next = bucket->next;
+    int frequency = node->frequency + 1;
+
+    if (!next || next->frequency != frequency) {
+        next = insert_bucket_after(cache, bucket, frequency);
+        if (!next) {
+            return;     // Out of memory: keep the node where it is
         }
-        prev = entry;
-        entry = entry->next;
     }
-}
 
-// Add entry to hash table
-static void add_to_hash(Cache* cache, int key, LFUNode* node) {
-    unsigned int h = hash(key);
-    HashEntry* entry = create_hash_entry(key, node);
-    entry->next = cache->hash_table[h];
-    cache->hash_table[h] = entry;
-}
+    remove_node(node);
+    node->frequency = frequency;
+    add_node(next, node);
 
-// Find least frequently used node
-static LFUNode* find_lfu_node(Cache* cache) {
-    if (!cache->head) {
-        return NULL;
+    if (!bucket->head) {
+        remove_bucket(cache, bucket);
     }
+}
 
-    LFUNode* lfu = cache->head;
-    LFUNode* current = cache->head->next;
+// Drop a node from the cache entirely
+static void drop_node(Cache* cache, LFUNode* node) {
+    FreqBucket* bucket = node->bucket;
 
-    while (current) {
-        if (current->frequency < lfu->frequency) {
-            lfu = current;
-        }
-        current = current->next;
+    remove_node(node);
+    cache_index_remove(&cache->index, node->key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+
+    if (!bucket->head) {
+        remove_bucket(cache, bucket);
     }
+}
 
-    return lfu;
+// Evict the least recently used node of the lowest frequency
+static void evict_lfu_node(Cache* cache) {
+    FreqBucket* bucket = cache->min_bucket;
+    if (!bucket) {
+        return;
+    }
+
+    drop_node(cache, bucket->tail);
+    cache->evictions++;
 }
 
 // Create a new cache
 Cache* create_lfu_cache(int capacity) {
-    if (capacity <= 0 || capacity > MAX_CACHE_SIZE) {
+    return create_lfu_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_lfu_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0) {
         return NULL;
     }
 
@@ -145,14 +193,26 @@ Cache* create_lfu_cache(int capacity) {
         return NULL;
     }
 
-    cache->hash_table = (HashEntry**)calloc(HASH_SIZE, sizeof(HashEntry*));
-    if (!cache->hash_table) {
+    if (cache_index_init(&cache->index, capacity, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(LFUNode), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->buckets, sizeof(FreqBucket), (uint32_t)capacity + 1) != 0) {
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
         free(cache);
         return NULL;
     }
 
-    cache->head = NULL;
-    cache->tail = NULL;
+    cache->min_bucket = NULL;
+    cache->evictions = 0;
     cache->size = 0;
     cache->capacity = capacity;
 
@@ -165,25 +225,9 @@ void destroy_lfu_cache(Cache* cache) {
         return;
     }
 
-    // Free all nodes in the linked list
-    LFUNode* current = cache->head;
-    while (current) {
-        LFUNode* next = current->next;
-        free(current);
-        current = next;
-    }
-
-    // Free all hash entries
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashEntry* entry = cache->hash_table[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
-    }
-
-    free(cache->hash_table);
+    node_arena_destroy(&cache->buckets);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
     free(cache);
 }
 
@@ -193,18 +237,13 @@ int get_lfu(Cache* cache, int key) {
         return -1;
     }
 
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->frequency++;
-            return entry->node->value;
-        }
-        entry = entry->next;
+    LFUNode* node = find_node(cache, key);
+    if (!node) {
+        return -1;  // Key not found
     }
-    
-    return -1;  // Key not found
+
+    touch_node(cache, node);
+    return node->value;
 }
 
 // Put value in cache
@@ -214,57 +253,109 @@ void put_lfu(Cache* cache, int key, int value) {
     }
 
     // Check if key exists
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->value = value;
-            entry->node->frequency++;
-            return;
-        }
-        entry = entry->next;
+    LFUNode* node = find_node(cache, key);
+    if (node) {
+        node->value = value;
+        touch_node(cache, node);
+        return;
+    }
+
+    // If cache is full, remove least frequently used
+    if (cache->size >= cache->capacity) {
+        evict_lfu_node(cache);
     }
 
     // Create new node
-    LFUNode* new_node = create_node(key, value);
+    LFUNode* new_node = create_node(key, value, cache);
     if (!new_node) {
         return;
     }
 
-    // If cache is full, remove least frequently used
-    if (cache->size >= cache->capacity) {
-        LFUNode* lfu = find_lfu_node(cache);
-        if (lfu) {
-            remove_node(cache, lfu);
-            remove_from_hash(cache, lfu->key);
-            free(lfu);
-            cache->size--;
+    // New nodes always start in the frequency-1 bucket
+    FreqBucket* bucket = cache->min_bucket;
+    if (!bucket || bucket->frequency != 1) {
+        bucket = insert_bucket_after(cache, NULL, 1);
+    }
+    if (!bucket || cache_index_insert(&cache->index, key, node_arena_handle(&cache->nodes, new_node)) != 0) {
+        if (bucket && !bucket->head) {
+            remove_bucket(cache, bucket);
         }
+        node_arena_free(&cache->nodes, new_node);
+        return;
     }
 
-    // Add new node
-    add_node(cache, new_node);
-    add_to_hash(cache, key, new_node);
+    add_node(bucket, new_node);
     cache->size++;
 }
 
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(lfu, nodes, UINT32_MAX, 0)
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_lfu(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    LFUNode* node = find_node(cache, key);
+    if (!node) {
+        return -1;
+    }
+
+    drop_node(cache, node);
+    return 0;
+}
+
+// Evict the entry the cache would replace next; returns -1 if it is empty
+int evict_lfu(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    evict_lfu_node(cache);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// the least frequently used entries that no longer fit; returns -1 if it is
+// out of range
+int resize_lfu(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    cache->capacity = capacity;
+    while (cache->size > capacity) {
+        evict_lfu_node(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_lfu_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
 // Print cache contents
 void print_lfu_cache_contents(Cache* cache, const char* message) {
     printf("\n%s:\n", message);
-    printf("Cache contents (Ordered by Insertion):\n");
+    printf("Cache contents (Least → Most Frequent, Recent first):\n");
     printf("------------------------------------------------\n");
     printf("Key\tValue\tFrequency\n");
     printf("------------------------------------------------\n");
-    
-    LFUNode* current = cache->head;
-    while (current) {
-        printf("%d\t%d\t%d\n", 
-               current->key, 
-               current->value, 
-               current->frequency);
-        current = current->next;
+
+    for (FreqBucket* bucket = cache->min_bucket; bucket; bucket = bucket->next) {
+        LFUNode* current = bucket->head;
+        while (current) {
+            printf("%d\t%d\t%d\n",
+                   current->key,
+                   current->value,
+                   current->frequency);
+            current = current->next;
+        }
     }
     printf("------------------------------------------------\n");
     printf("Cache size: %d/%d\n", cache->size, cache->capacity);
-} 
\ No newline at end of file
+}
@@ -4,9 +4,16 @@
 #include "cache_interface.h"
 
 Cache* create_lfu_cache(int capacity);
+Cache* create_lfu_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_lfu_cache(Cache* cache);
 int get_lfu(Cache* cache, int key);
 void put_lfu(Cache* cache, int key, int value);
+void get_many_lfu(Cache* cache, const int* keys, int* values, int count);
+void put_many_lfu(Cache* cache, const int* keys, const int* values, int count);
+int erase_lfu(Cache* cache, int key);
+int evict_lfu(Cache* cache);
+int resize_lfu(Cache* cache, int capacity);
+void get_lfu_stats(Cache* cache, CacheStats* stats);
 void print_lfu_cache_contents(Cache* cache, const char* message);
 
 // LFU specific declarations can be added here if needed
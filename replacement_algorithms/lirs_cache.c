@@ -0,0 +1,492 @@
+#include "lirs_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <limits.h>
+#include <string.h>
+
+// LIRS (Jiang & Zhang, SIGMETRICS '02). Entries are ranked by reuse
+// distance rather than recency: LIR entries (low inter-reference recency)
+// hold most of the capacity and are never evicted directly, while a small
+// share holds resident HIR entries, which are evicted first. The stack S
+// orders LIR entries and recently seen HIR entries (resident or not) by
+// recency; a HIR entry hit again while still in S has a shorter reuse
+// distance than the oldest LIR entry, so the two swap status. The queue Q
+// orders resident HIR entries for eviction.
+//
+// Non-resident HIR entries only carry metadata, and their number is
+// bounded: past LIRS_NONRESIDENT_FACTOR per cached entry the oldest is
+// dropped, so a long scan can't grow S without limit.
+
+#define LIRS_HIR_PERCENT 1              // Resident HIR share of the capacity
+#define LIRS_NONRESIDENT_FACTOR 2       // Non-resident entries per cached entry
+
+enum { LIRS_LIR, LIRS_HIR, LIRS_NONRESIDENT };
+enum { LIRS_STACK, LIRS_QUEUE };        // Which links of a node
+enum { LIRS_PREV, LIRS_NEXT };
+
+// Node structure. Every node can be on S and on one of Q (resident HIR)
+// or the non-resident list, so it carries two pairs of links
+typedef struct LIRSNode {
+    int key;
+    int value;
+    uint32_t link[2][2];    // [LIRS_STACK or LIRS_QUEUE][LIRS_PREV or LIRS_NEXT]
+    uint8_t state;
+    uint8_t in_stack;
+} LIRSNode;
+
+// List of node handles; first is the top of S, or the oldest of a queue
+typedef struct LIRSList {
+    uint32_t first;
+    uint32_t last;
+    int size;
+} LIRSList;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;           // Resident and non-resident keys
+    NodeArena nodes;
+    LIRSList stack;             // S: top is most recent, bottom always LIR
+    LIRSList queue;             // Q: resident HIR, first is the next victim
+    LIRSList nonresident;       // Non-resident HIR, oldest first (queue links)
+    int lir_count;
+    int lir_capacity;
+    int nonresident_limit;
+    uint64_t evictions;
+    int size;                   // Resident entries
+    int capacity;
+};
+
+static LIRSNode* node_at(Cache* cache, uint32_t handle) {
+    return (LIRSNode*)node_arena_at(&cache->nodes, handle);
+}
+
+static void list_init(LIRSList* list) {
+    list->first = NODE_ARENA_NONE;
+    list->last = NODE_ARENA_NONE;
+    list->size = 0;
+}
+
+// Add a node at the front of a list, using the given pair of links
+static void list_push_first(Cache* cache, LIRSList* list, int which, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    node->link[which][LIRS_PREV] = NODE_ARENA_NONE;
+    node->link[which][LIRS_NEXT] = list->first;
+    if (list->first != NODE_ARENA_NONE) {
+        node_at(cache, list->first)->link[which][LIRS_PREV] = handle;
+    } else {
+        list->last = handle;
+    }
+    list->first = handle;
+    list->size++;
+}
+
+// Add a node at the back of a list
+static void list_push_last(Cache* cache, LIRSList* list, int which, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    node->link[which][LIRS_NEXT] = NODE_ARENA_NONE;
+    node->link[which][LIRS_PREV] = list->last;
+    if (list->last != NODE_ARENA_NONE) {
+        node_at(cache, list->last)->link[which][LIRS_NEXT] = handle;
+    } else {
+        list->first = handle;
+    }
+    list->last = handle;
+    list->size++;
+}
+
+// Remove a node from a list
+static void list_unlink(Cache* cache, LIRSList* list, int which, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+    uint32_t prev = node->link[which][LIRS_PREV];
+    uint32_t next = node->link[which][LIRS_NEXT];
+
+    if (prev != NODE_ARENA_NONE) {
+        node_at(cache, prev)->link[which][LIRS_NEXT] = next;
+    } else {
+        list->first = next;
+    }
+
+    if (next != NODE_ARENA_NONE) {
+        node_at(cache, next)->link[which][LIRS_PREV] = prev;
+    } else {
+        list->last = prev;
+    }
+    list->size--;
+}
+
+// Move a node to the top of S, adding it if it isn't there
+static void stack_push_top(Cache* cache, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    if (node->in_stack) {
+        list_unlink(cache, &cache->stack, LIRS_STACK, handle);
+    }
+    list_push_first(cache, &cache->stack, LIRS_STACK, handle);
+    node->in_stack = 1;
+}
+
+// Forget a non-resident entry entirely
+static void drop_nonresident(Cache* cache, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    if (node->in_stack) {
+        list_unlink(cache, &cache->stack, LIRS_STACK, handle);
+    }
+    list_unlink(cache, &cache->nonresident, LIRS_QUEUE, handle);
+    cache_index_remove(&cache->index, node->key);
+    node_arena_free(&cache->nodes, node);
+}
+
+// Remove HIR entries from the bottom of S until an LIR entry is there.
+// Non-resident entries leaving S are forgotten
+static void prune_stack(Cache* cache) {
+    while (cache->stack.last != NODE_ARENA_NONE) {
+        uint32_t handle = cache->stack.last;
+        LIRSNode* node = node_at(cache, handle);
+
+        if (node->state == LIRS_LIR) {
+            return;
+        }
+        if (node->state == LIRS_NONRESIDENT) {
+            drop_nonresident(cache, handle);
+        } else {
+            list_unlink(cache, &cache->stack, LIRS_STACK, handle);
+            node->in_stack = 0;
+        }
+    }
+}
+
+// Turn the LIR entry at the bottom of S into a resident HIR entry at the
+// end of Q, then prune
+static void demote_bottom_lir(Cache* cache) {
+    uint32_t handle = cache->stack.last;
+    LIRSNode* node = node_at(cache, handle);
+
+    list_unlink(cache, &cache->stack, LIRS_STACK, handle);
+    node->in_stack = 0;
+    node->state = LIRS_HIR;
+    cache->lir_count--;
+    list_push_last(cache, &cache->queue, LIRS_QUEUE, handle);
+    prune_stack(cache);
+}
+
+// Turn an entry that was hit while still in S into an LIR entry
+static void promote_to_lir(Cache* cache, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    node->state = LIRS_LIR;
+    cache->lir_count++;
+    stack_push_top(cache, handle);
+    if (cache->lir_count > cache->lir_capacity) {
+        demote_bottom_lir(cache);
+    }
+}
+
+// Record a hit on a resident entry
+static void access_resident(Cache* cache, uint32_t handle) {
+    LIRSNode* node = node_at(cache, handle);
+
+    if (node->state == LIRS_LIR) {
+        int was_bottom = handle == cache->stack.last;
+        stack_push_top(cache, handle);
+        if (was_bottom) {
+            prune_stack(cache);
+        }
+        return;
+    }
+
+    // Resident HIR: a hit inside S means its reuse distance beats the
+    // oldest LIR entry's. While erases have left the LIR set short, any hit
+    // joins it, as new keys do; pushing a HIR entry onto an S that holds no
+    // LIR entry would leave a non-LIR entry at its bottom
+    if (node->in_stack || cache->lir_count < cache->lir_capacity) {
+        list_unlink(cache, &cache->queue, LIRS_QUEUE, handle);
+        promote_to_lir(cache, handle);
+    } else {
+        stack_push_top(cache, handle);
+        list_unlink(cache, &cache->queue, LIRS_QUEUE, handle);
+        list_push_last(cache, &cache->queue, LIRS_QUEUE, handle);
+    }
+}
+
+// Evict the resident HIR entry at the front of Q. If it is still in S it
+// stays there as a non-resident entry
+static void evict_hir(Cache* cache) {
+    uint32_t handle = cache->queue.first;
+    LIRSNode* node = node_at(cache, handle);
+
+    list_unlink(cache, &cache->queue, LIRS_QUEUE, handle);
+    cache->size--;
+    cache->evictions++;
+
+    if (!node->in_stack) {
+        cache_index_remove(&cache->index, node->key);
+        node_arena_free(&cache->nodes, node);
+        return;
+    }
+
+    node->state = LIRS_NONRESIDENT;
+    list_push_last(cache, &cache->nonresident, LIRS_QUEUE, handle);
+    if (cache->nonresident.size > cache->nonresident_limit) {
+        drop_nonresident(cache, cache->nonresident.first);
+    }
+}
+
+// Set the capacity, its LIR share and the non-resident limit
+static void size_sets(Cache* cache, int capacity) {
+    int hir_capacity = (int)((long long)capacity * LIRS_HIR_PERCENT / 100);
+
+    hir_capacity = hir_capacity > 0 ? hir_capacity : 1;
+    cache->lir_capacity = capacity - hir_capacity;
+    cache->nonresident_limit = capacity * LIRS_NONRESIDENT_FACTOR;
+    cache->capacity = capacity;
+}
+
+// Create a new cache
+Cache* create_lirs_cache(int capacity) {
+    return create_lirs_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_lirs_cache_sized(int capacity, CacheIndexSizing sizing) {
+    // At least one LIR and one resident HIR slot are needed
+    if (capacity < 2 || capacity > INT_MAX / (LIRS_NONRESIDENT_FACTOR + 1)) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    size_sets(cache, capacity);
+
+    // One node and one index entry per resident or non-resident key. The
+    // one extra node covers the moment before an over-limit entry is dropped
+    int nodes = capacity + cache->nonresident_limit + 1;
+    if (cache_index_init(&cache->index, nodes, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(LIRSNode), (uint32_t)nodes) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    list_init(&cache->stack);
+    list_init(&cache->queue);
+    list_init(&cache->nonresident);
+    cache->lir_count = 0;
+    cache->evictions = 0;
+    cache->size = 0;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_lirs_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
+    free(cache);
+}
+
+// Get value from cache
+int get_lirs(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || node_at(cache, handle)->state == LIRS_NONRESIDENT) {
+        return -1;  // Key not found
+    }
+
+    access_resident(cache, handle);
+    return node_at(cache, handle)->value;
+}
+
+// Put value in cache
+void put_lirs(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    // Check if key exists
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle != CACHE_INDEX_NONE && node_at(cache, handle)->state != LIRS_NONRESIDENT) {
+        node_at(cache, handle)->value = value;
+        access_resident(cache, handle);
+        return;
+    }
+
+    // If cache is full, evict the oldest resident HIR entry. Evicting can
+    // drop the oldest non-resident entry, which may be this key
+    if (cache->size >= cache->capacity) {
+        evict_hir(cache);
+        if (handle != CACHE_INDEX_NONE) {
+            handle = cache_index_find(&cache->index, key);
+        }
+    }
+
+    if (handle != CACHE_INDEX_NONE) {
+        // Non-resident entry still in S: it comes back as LIR
+        LIRSNode* node = node_at(cache, handle);
+        list_unlink(cache, &cache->nonresident, LIRS_QUEUE, handle);
+        node->value = value;
+        cache->size++;
+        promote_to_lir(cache, handle);
+        return;
+    }
+
+    LIRSNode* node = (LIRSNode*)node_arena_alloc(&cache->nodes);
+    if (!node) {
+        return;
+    }
+    handle = node_arena_handle(&cache->nodes, node);
+    if (cache_index_insert(&cache->index, key, handle) != 0) {
+        node_arena_free(&cache->nodes, node);
+        return;
+    }
+    node->key = key;
+    node->value = value;
+    node->in_stack = 0;
+    cache->size++;
+
+    // Until the LIR set is full every new key joins it
+    if (cache->lir_count < cache->lir_capacity) {
+        node->state = LIRS_LIR;
+        cache->lir_count++;
+        stack_push_top(cache, handle);
+    } else {
+        node->state = LIRS_HIR;
+        stack_push_top(cache, handle);
+        list_push_last(cache, &cache->queue, LIRS_QUEUE, handle);
+    }
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(lirs, nodes, UINT32_MAX, 0)
+
+// Remove key from the cache; returns -1 if it was not cached. An erased
+// LIR entry frees its LIR slot for the next new key
+int erase_lirs(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE) {
+        return -1;
+    }
+
+    LIRSNode* node = node_at(cache, handle);
+    if (node->state == LIRS_NONRESIDENT) {
+        return -1;
+    }
+
+    int was_bottom = handle == cache->stack.last;
+    if (node->in_stack) {
+        list_unlink(cache, &cache->stack, LIRS_STACK, handle);
+    }
+    if (node->state == LIRS_LIR) {
+        cache->lir_count--;
+    } else {
+        list_unlink(cache, &cache->queue, LIRS_QUEUE, handle);
+    }
+    cache_index_remove(&cache->index, key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+
+    if (was_bottom) {
+        prune_stack(cache);
+    }
+    return 0;
+}
+
+// Evict the oldest resident HIR entry; returns -1 if the cache is empty.
+// With no resident HIR entry, the oldest LIR entry is demoted first
+int evict_lirs(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    if (cache->queue.first == NODE_ARENA_NONE) {
+        demote_bottom_lir(cache);
+    }
+    evict_hir(cache);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. The oldest LIR entries are demoted until the
+// LIR set fits its new share, resident HIR entries are evicted until the
+// cache fits, and the oldest non-resident entries are forgotten until
+// they fit their new limit
+int resize_lirs(Cache* cache, int capacity) {
+    if (!cache || capacity < 2 ||
+        (long long)capacity * (LIRS_NONRESIDENT_FACTOR + 1) + 1 > (long long)cache->nodes.capacity) {
+        return -1;
+    }
+
+    size_sets(cache, capacity);
+    while (cache->lir_count > cache->lir_capacity) {
+        demote_bottom_lir(cache);
+    }
+    while (cache->size > capacity) {
+        evict_hir(cache);
+    }
+    while (cache->nonresident.size > cache->nonresident_limit) {
+        drop_nonresident(cache, cache->nonresident.first);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_lirs_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print cache contents
+void print_lirs_cache_contents(Cache* cache, const char* message) {
+    static const char* names[] = { "LIR", "HIR", "non-resident" };
+
+    printf("\n%s:\n", message);
+    printf("Cache contents (stack S from the top, then HIR entries not in S):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tStatus\n");
+    printf("------------------------------------------------\n");
+
+    for (uint32_t handle = cache->stack.first; handle != NODE_ARENA_NONE;
+         handle = node_at(cache, handle)->link[LIRS_STACK][LIRS_NEXT]) {
+        LIRSNode* current = node_at(cache, handle);
+        if (current->state == LIRS_NONRESIDENT) {
+            printf("%d\t-\t%s\n", current->key, names[current->state]);
+        } else {
+            printf("%d\t%d\t%s\n", current->key, current->value, names[current->state]);
+        }
+    }
+    for (uint32_t handle = cache->queue.first; handle != NODE_ARENA_NONE;
+         handle = node_at(cache, handle)->link[LIRS_QUEUE][LIRS_NEXT]) {
+        LIRSNode* current = node_at(cache, handle);
+        if (!current->in_stack) {
+            printf("%d\t%d\t%s\n", current->key, current->value, names[current->state]);
+        }
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d (LIR %d/%d)\n",
+           cache->size, cache->capacity, cache->lir_count, cache->lir_capacity);
+    printf("Non-resident metadata: %d/%d entries, %zu bytes\n",
+           cache->nonresident.size, cache->nonresident_limit,
+           (size_t)cache->nonresident.size * cache->nodes.node_size);
+}
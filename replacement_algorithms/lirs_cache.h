@@ -0,0 +1,21 @@
+#ifndef LIRS_CACHE_H
+#define LIRS_CACHE_H
+
+#include "cache_interface.h"
+
+Cache* create_lirs_cache(int capacity);
+Cache* create_lirs_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_lirs_cache(Cache* cache);
+int get_lirs(Cache* cache, int key);
+void put_lirs(Cache* cache, int key, int value);
+void get_many_lirs(Cache* cache, const int* keys, int* values, int count);
+void put_many_lirs(Cache* cache, const int* keys, const int* values, int count);
+int erase_lirs(Cache* cache, int key);
+int evict_lirs(Cache* cache);
+int resize_lirs(Cache* cache, int capacity);
+void get_lirs_stats(Cache* cache, CacheStats* stats);
+void print_lirs_cache_contents(Cache* cache, const char* message);
+
+// LIRS specific declarations can be added here if needed
+
+#endif // LIRS_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,569 @@
+#include "lru2_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <limits.h>
+#include <string.h>
+
+// LRU-2 (O'Neil, O'Neil & Weikum, SIGMOD '93). Each entry remembers the
+// times of its last two uncorrelated references, and the victim is the
+// entry whose second-to-last reference is oldest; entries referenced only
+// once count as infinitely old and go first, oldest first.
+//
+// Entries referenced once are therefore ordered by their only reference,
+// which is insertion order: they sit in a FIFO list and are evicted in
+// O(1). An entry's second reference moves it into a binary min-heap keyed
+// by its second-to-last reference, so the victim among those is found in
+// O(log n). The heap stores the reference times inline so sifting doesn't
+// touch the nodes.
+//
+// References closer together than the correlated-reference window (in
+// accesses) are treated as one: they refresh the entry's last access but
+// don't shift its history. An entry referenced within the window is also
+// not evicted while any other entry can be. Evicted entries leave their
+// last reference behind in a bounded ghost ring, so a key that returns
+// soon resumes with its old reference instead of starting from scratch.
+//
+// Such an entry keeps its old history, so it would stay at the head of
+// the once list or the top of the heap and be passed over again on every
+// eviction. Instead it moves to a recent list, ordered by last access,
+// when a correlated reference finds it on the once list or an eviction
+// finds it on top of the heap; its head then shows whether anything on it
+// can be evicted. An uncorrelated reference puts the entry back in the
+// heap. Among the eligible entries on the recent list the least recently
+// used is the candidate, rather than the one with the oldest history.
+
+#define LRU2_CORRELATED_PERCENT 10      // Correlated window, % of the capacity
+#define LRU2_GHOST ((uint32_t)1 << 31)  // Index handle flag for ghost history
+#define LRU2_ONCE UINT32_MAX            // heap_pos of entries on the once list
+#define LRU2_RECENT (UINT32_MAX - 1)    // heap_pos of entries on the recent list
+
+// Node structure
+typedef struct LRU2Node {
+    int key;
+    int value;
+    uint64_t last;          // Last access of any kind
+    uint64_t hist1;         // Last uncorrelated reference, while on a list
+    uint64_t hist2;         // The one before, or 0 if none, while on a list
+    uint32_t prev;          // List links
+    uint32_t next;
+    uint32_t heap_pos;      // Position in the heap, LRU2_ONCE or LRU2_RECENT
+} LRU2Node;
+
+// Once or recent list
+typedef struct LRU2List {
+    uint32_t head;          // Next victim
+    uint32_t tail;
+} LRU2List;
+
+// Heap entry for an entry referenced at least twice
+typedef struct LRU2HeapEntry {
+    uint64_t hist2;         // Second-to-last uncorrelated reference
+    uint64_t hist1;         // Last uncorrelated reference
+    uint32_t handle;
+} LRU2HeapEntry;
+
+// History left behind by an evicted entry
+typedef struct LRU2Ghost {
+    int key;
+    uint64_t hist1;
+} LRU2Ghost;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;           // Resident keys, and ghost keys flagged LRU2_GHOST
+    NodeArena nodes;
+    LRU2List once;              // Referenced once, oldest first
+    LRU2List recent;            // Passed over inside the window, least recent first
+    LRU2HeapEntry* heap;        // Referenced twice or more, next victim first
+    uint32_t heap_size;
+    LRU2Ghost* ghosts;          // Ring of evicted histories
+    uint32_t ghost_head;
+    uint32_t ghost_count;
+    uint64_t clock;             // Accesses so far
+    int correlated_window;
+    uint64_t evictions;
+    int size;
+    int capacity;
+};
+
+static LRU2Node* node_at(Cache* cache, uint32_t handle) {
+    return (LRU2Node*)node_arena_at(&cache->nodes, handle);
+}
+
+// List a node on the once or recent list is on
+static LRU2List* list_of(Cache* cache, const LRU2Node* node) {
+    return node->heap_pos == LRU2_ONCE ? &cache->once : &cache->recent;
+}
+
+// Append a node to a list, marking it with that list's heap_pos
+static void list_push(Cache* cache, LRU2List* list, LRU2Node* node, uint32_t handle) {
+    node->heap_pos = list == &cache->once ? LRU2_ONCE : LRU2_RECENT;
+    node->prev = list->tail;
+    node->next = NODE_ARENA_NONE;
+
+    if (list->tail != NODE_ARENA_NONE) {
+        node_at(cache, list->tail)->next = handle;
+    } else {
+        list->head = handle;
+    }
+    list->tail = handle;
+}
+
+// Remove a node from the list it is on
+static void list_unlink(Cache* cache, LRU2Node* node) {
+    LRU2List* list = list_of(cache, node);
+
+    if (node->prev != NODE_ARENA_NONE) {
+        node_at(cache, node->prev)->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+
+    if (node->next != NODE_ARENA_NONE) {
+        node_at(cache, node->next)->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+}
+
+// Eviction order: oldest second-to-last reference, then oldest last one
+static int history_before(uint64_t hist2_a, uint64_t hist1_a, uint64_t hist2_b, uint64_t hist1_b) {
+    return hist2_a < hist2_b || (hist2_a == hist2_b && hist1_a < hist1_b);
+}
+
+static int evicts_before(const LRU2HeapEntry* a, const LRU2HeapEntry* b) {
+    return history_before(a->hist2, a->hist1, b->hist2, b->hist1);
+}
+
+static void heap_set(Cache* cache, uint32_t pos, const LRU2HeapEntry* entry) {
+    cache->heap[pos] = *entry;
+    node_at(cache, entry->handle)->heap_pos = pos;
+}
+
+static void sift_up(Cache* cache, uint32_t pos) {
+    LRU2HeapEntry entry = cache->heap[pos];
+
+    while (pos > 0) {
+        uint32_t parent = (pos - 1) / 2;
+        if (!evicts_before(&entry, &cache->heap[parent])) {
+            break;
+        }
+        heap_set(cache, pos, &cache->heap[parent]);
+        pos = parent;
+    }
+    heap_set(cache, pos, &entry);
+}
+
+static void sift_down(Cache* cache, uint32_t pos) {
+    uint32_t size = cache->heap_size;
+    LRU2HeapEntry entry = cache->heap[pos];
+
+    for (;;) {
+        uint32_t child = 2 * pos + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && evicts_before(&cache->heap[child + 1], &cache->heap[child])) {
+            child++;
+        }
+        if (!evicts_before(&cache->heap[child], &entry)) {
+            break;
+        }
+        heap_set(cache, pos, &cache->heap[child]);
+        pos = child;
+    }
+    heap_set(cache, pos, &entry);
+}
+
+static void heap_push(Cache* cache, uint64_t hist2, uint64_t hist1, uint32_t handle) {
+    LRU2HeapEntry* entry = &cache->heap[cache->heap_size++];
+    entry->hist2 = hist2;
+    entry->hist1 = hist1;
+    entry->handle = handle;
+    sift_up(cache, cache->heap_size - 1);
+}
+
+static LRU2HeapEntry heap_pop(Cache* cache) {
+    LRU2HeapEntry top = cache->heap[0];
+
+    cache->heap_size--;
+    if (cache->heap_size > 0) {
+        cache->heap[0] = cache->heap[cache->heap_size];
+        sift_down(cache, 0);
+    }
+    return top;
+}
+
+// Remove the entry at pos; the last entry takes its place and moves
+// whichever way it needs to
+static void heap_remove(Cache* cache, uint32_t pos) {
+    cache->heap_size--;
+    if (pos == cache->heap_size) {
+        return;
+    }
+
+    cache->heap[pos] = cache->heap[cache->heap_size];
+    if (pos > 0 && evicts_before(&cache->heap[pos], &cache->heap[(pos - 1) / 2])) {
+        sift_up(cache, pos);
+    } else {
+        sift_down(cache, pos);
+    }
+}
+
+// Record a reference to a resident entry
+static void reference(Cache* cache, LRU2Node* node, uint32_t handle) {
+    uint64_t now = ++cache->clock;
+
+    if (now - node->last > (uint64_t)cache->correlated_window) {
+        if (node->heap_pos >= LRU2_RECENT) {
+            list_unlink(cache, node);
+            heap_push(cache, node->hist1, now, handle);
+        } else {
+            LRU2HeapEntry* entry = &cache->heap[node->heap_pos];
+            entry->hist2 = entry->hist1;
+            entry->hist1 = now;
+            sift_down(cache, node->heap_pos);   // Only ever moves later in the order
+        }
+    } else if (node->heap_pos >= LRU2_RECENT) {
+        list_unlink(cache, node);
+        list_push(cache, &cache->recent, node, handle);
+    }
+    node->last = now;
+}
+
+// Forget the oldest ghost. Only a still-current ghost is dropped from the
+// index
+static void drop_ghost(Cache* cache) {
+    uint32_t pos = cache->ghost_head;
+    int old = cache->ghosts[pos].key;
+
+    if (cache_index_find(&cache->index, old) == (LRU2_GHOST | pos)) {
+        cache_index_remove(&cache->index, old);
+    }
+    cache->ghost_head = (pos + 1) % cache->nodes.capacity;
+    cache->ghost_count--;
+}
+
+// Remember an evicted entry's history, forgetting the oldest ghost if there
+// are already as many as the capacity. The ring has a slot per node, so it
+// keeps its size when the capacity changes
+static void add_ghost(Cache* cache, int key, uint64_t hist1) {
+    while (cache->ghost_count >= (uint32_t)cache->capacity) {
+        drop_ghost(cache);
+    }
+
+    uint32_t pos = (cache->ghost_head + cache->ghost_count) % cache->nodes.capacity;
+    cache->ghosts[pos].key = key;
+    cache->ghosts[pos].hist1 = hist1;
+    cache->ghost_count++;
+    cache_index_update(&cache->index, key, LRU2_GHOST | pos);
+}
+
+// Turn a resident entry into a ghost
+static void evict_node(Cache* cache, LRU2Node* node, uint64_t hist1) {
+    add_ghost(cache, node->key, hist1);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+    cache->evictions++;
+}
+
+// Whether an entry was last accessed outside the correlated window
+static int eligible(const Cache* cache, const LRU2Node* node) {
+    return cache->clock - node->last > (uint64_t)cache->correlated_window;
+}
+
+// Head of a list if it can be evicted, else NULL
+static LRU2Node* eligible_head(Cache* cache, const LRU2List* list) {
+    if (list->head == NODE_ARENA_NONE) {
+        return NULL;
+    }
+    LRU2Node* node = node_at(cache, list->head);
+    return eligible(cache, node) ? node : NULL;
+}
+
+// Evict a node from the once or recent list
+static void evict_listed(Cache* cache, LRU2Node* node) {
+    list_unlink(cache, node);
+    evict_node(cache, node, node->hist1);
+}
+
+// Evict the entry with the oldest second-to-last reference, passing over
+// entries referenced within the correlated window unless nothing else is
+// left. Entries passed over on top of the heap move to the recent list,
+// so each is popped once rather than on every eviction
+static void evict(Cache* cache) {
+    LRU2Node* victim = eligible_head(cache, &cache->once);
+    LRU2Node* recent = eligible_head(cache, &cache->recent);
+
+    if (recent && (!victim || history_before(recent->hist2, recent->hist1,
+                                             victim->hist2, victim->hist1))) {
+        victim = recent;
+    }
+    if (victim && victim->hist2 == 0) {
+        evict_listed(cache, victim);    // Referenced once: nothing in the heap is older
+        return;
+    }
+
+    while (cache->heap_size > 0) {
+        LRU2HeapEntry* top = &cache->heap[0];
+        LRU2Node* node = node_at(cache, top->handle);
+        if (eligible(cache, node)) {
+            if (!victim || history_before(top->hist2, top->hist1, victim->hist2, victim->hist1)) {
+                LRU2HeapEntry entry = heap_pop(cache);
+                evict_node(cache, node, entry.hist1);
+                return;
+            }
+            break;
+        }
+
+        LRU2HeapEntry entry = heap_pop(cache);
+        node->hist1 = entry.hist1;
+        node->hist2 = entry.hist2;
+        list_push(cache, &cache->recent, node, entry.handle);
+    }
+
+    // Everything is inside the window: take the oldest entry referenced
+    // once, else the least recently used
+    if (!victim) {
+        uint32_t head = cache->once.head != NODE_ARENA_NONE ? cache->once.head : cache->recent.head;
+        victim = node_at(cache, head);
+    }
+    evict_listed(cache, victim);
+}
+
+// Set the capacity and the correlated-reference window that scales with it
+static void size_window(Cache* cache, int capacity) {
+    int window = (int)((long long)capacity * LRU2_CORRELATED_PERCENT / 100);
+
+    cache->correlated_window = window > 0 ? window : 1;
+    cache->capacity = capacity;
+}
+
+// Create a new cache
+Cache* create_lru2_cache(int capacity) {
+    return create_lru2_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_lru2_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0 || capacity > INT_MAX / 2) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    size_window(cache, capacity);
+
+    // The index holds resident keys plus one ghost per cached entry
+    if (cache_index_init(&cache->index, 2 * capacity, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(LRU2Node), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    cache->heap = (LRU2HeapEntry*)malloc((size_t)capacity * sizeof(LRU2HeapEntry));
+    cache->ghosts = (LRU2Ghost*)malloc((size_t)capacity * sizeof(LRU2Ghost));
+    if (!cache->heap || !cache->ghosts) {
+        free(cache->heap);
+        free(cache->ghosts);
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    cache->once.head = NODE_ARENA_NONE;
+    cache->once.tail = NODE_ARENA_NONE;
+    cache->recent.head = NODE_ARENA_NONE;
+    cache->recent.tail = NODE_ARENA_NONE;
+    cache->heap_size = 0;
+    cache->ghost_head = 0;
+    cache->ghost_count = 0;
+    cache->clock = 0;
+    cache->evictions = 0;
+    cache->size = 0;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_lru2_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    free(cache->ghosts);
+    free(cache->heap);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
+    free(cache);
+}
+
+// Get value from cache
+int get_lru2(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & LRU2_GHOST)) {
+        return -1;  // Key not found
+    }
+
+    LRU2Node* node = node_at(cache, handle);
+    reference(cache, node, handle);
+    return node->value;
+}
+
+// Put value in cache
+void put_lru2(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    // Check if key exists
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle != CACHE_INDEX_NONE && !(handle & LRU2_GHOST)) {
+        LRU2Node* node = node_at(cache, handle);
+        node->value = value;
+        reference(cache, node, handle);
+        return;
+    }
+
+    // A returning key picks up the reference its ghost remembered
+    uint64_t previous = handle != CACHE_INDEX_NONE ? cache->ghosts[handle & ~LRU2_GHOST].hist1 : 0;
+    uint64_t now = ++cache->clock;
+
+    if (cache->size >= cache->capacity) {
+        evict(cache);
+    }
+
+    LRU2Node* node = (LRU2Node*)node_arena_alloc(&cache->nodes);
+    if (!node) {
+        return;
+    }
+    handle = node_arena_handle(&cache->nodes, node);
+
+    // Evicting may have pushed the key's own ghost out of the ring
+    if ((previous == 0 || cache_index_update(&cache->index, key, handle) != 0) &&
+        cache_index_insert(&cache->index, key, handle) != 0) {
+        node_arena_free(&cache->nodes, node);
+        return;
+    }
+
+    node->key = key;
+    node->value = value;
+    node->last = now;
+    node->hist1 = now;
+    node->hist2 = 0;
+    if (previous) {
+        heap_push(cache, previous, now, handle);
+    } else {
+        list_push(cache, &cache->once, node, handle);
+    }
+    cache->size++;
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(lru2, nodes, ~LRU2_GHOST, LRU2_GHOST)
+
+// Remove key from the cache without leaving a ghost; returns -1 if it
+// was not cached
+int erase_lru2(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & LRU2_GHOST)) {
+        return -1;
+    }
+
+    LRU2Node* node = node_at(cache, handle);
+    if (node->heap_pos >= LRU2_RECENT) {
+        list_unlink(cache, node);
+    } else {
+        heap_remove(cache, node->heap_pos);
+    }
+    cache_index_remove(&cache->index, key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+    return 0;
+}
+
+// Evict the entry a new key would displace; returns -1 if the cache is empty
+int evict_lru2(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    evict(cache);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. The correlated window scales with it, entries
+// are evicted as a put would evict them until the cache fits, and the
+// oldest ghosts are forgotten until there are no more than the capacity
+int resize_lru2(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    size_window(cache, capacity);
+    while (cache->size > capacity) {
+        evict(cache);
+    }
+    while (cache->ghost_count > (uint32_t)capacity) {
+        drop_ghost(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_lru2_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print cache contents
+void print_lru2_cache_contents(Cache* cache, const char* message) {
+    printf("\n%s:\n", message);
+    printf("Cache contents (referenced once oldest first, recent list, then heap order):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tLast Ref\tPrevious Ref\n");
+    printf("------------------------------------------------\n");
+
+    const LRU2List* lists[] = { &cache->once, &cache->recent };
+    for (int i = 0; i < 2; i++) {
+        for (uint32_t h = lists[i]->head; h != NODE_ARENA_NONE; h = node_at(cache, h)->next) {
+            LRU2Node* current = node_at(cache, h);
+            if (current->hist2) {
+                printf("%d\t%d\t%llu\t\t%llu\n", current->key, current->value,
+                       (unsigned long long)current->hist1, (unsigned long long)current->hist2);
+            } else {
+                printf("%d\t%d\t%llu\t\t-\n", current->key, current->value,
+                       (unsigned long long)current->hist1);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < cache->heap_size; i++) {
+        const LRU2HeapEntry* entry = &cache->heap[i];
+        LRU2Node* current = node_at(cache, entry->handle);
+        printf("%d\t%d\t%llu\t\t%llu\n", current->key, current->value,
+               (unsigned long long)entry->hist1, (unsigned long long)entry->hist2);
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d (ghost histories %u)\n",
+           cache->size, cache->capacity, cache->ghost_count);
+}
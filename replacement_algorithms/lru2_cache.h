@@ -0,0 +1,21 @@
+#ifndef LRU2_CACHE_H
+#define LRU2_CACHE_H
+
+#include "cache_interface.h"
+
+Cache* create_lru2_cache(int capacity);
+Cache* create_lru2_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_lru2_cache(Cache* cache);
+int get_lru2(Cache* cache, int key);
+void put_lru2(Cache* cache, int key, int value);
+void get_many_lru2(Cache* cache, const int* keys, int* values, int count);
+void put_many_lru2(Cache* cache, const int* keys, const int* values, int count);
+int erase_lru2(Cache* cache, int key);
+int evict_lru2(Cache* cache);
+int resize_lru2(Cache* cache, int capacity);
+void get_lru2_stats(Cache* cache, CacheStats* stats);
+void print_lru2_cache_contents(Cache* cache, const char* message);
+
+// LRU-2 specific declarations can be added here if needed
+
+#endif // LRU2_CACHE_H 
\ No newline at end of file
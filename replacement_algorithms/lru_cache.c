@@ -1,8 +1,10 @@
 #include "lru_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "frequency_sketch.h"
+#include "node_arena.h"
 #include <string.h>
 
-#define HASH_SIZE 1000
-
 // Node structure for doubly linked list
 typedef struct LRUNode {
     int key;
@@ -11,30 +13,41 @@ typedef struct LRUNode {
     struct LRUNode* next;
 } LRUNode;
 
-// Hash entry structure
-typedef struct HashEntry {
-    int key;
-    LRUNode* node;
-    struct HashEntry* next;
-} HashEntry;
+// LRU-ordered list of nodes. A plain LRU cache has a single segment; in
+// W-TinyLFU mode new keys enter a small window segment, and the main
+// region is split into probation and protected segments (segmented LRU)
+typedef struct LRUSegment {
+    LRUNode* head;      // Most recently used
+    LRUNode* tail;      // Least recently used
+    int size;
+    int capacity;
+} LRUSegment;
+
+enum { LRU_WINDOW, LRU_PROBATION, LRU_PROTECTED, LRU_SEGMENTS };
+
+// In W-TinyLFU mode the top bits of a node's index handle say which
+// segment it is on
+#define LRU_SEGMENT_SHIFT 30
+#define LRU_HANDLE_MASK ((1u << LRU_SEGMENT_SHIFT) - 1)
+
+#define TINYLFU_WINDOW_PERCENT 1        // Window share of the capacity
+#define TINYLFU_PROTECTED_PERCENT 80    // Protected share of the main region
 
 // Cache structure
 struct Cache {
-    LRUNode* head;      // Most recently used
-    LRUNode* tail;      // Least recently used
-    HashEntry** hash_table;
+    LRUSegment segments[LRU_SEGMENTS];  // Plain LRU only uses the window
+    CacheIndex index;
+    NodeArena nodes;
+    FrequencySketch sketch;
+    int tinylfu;        // Admission through the sketch is enabled
+    uint64_t evictions;
     int size;
     int capacity;
 };
 
-// Hash function
-static unsigned int hash(int key) {
-    return (unsigned int)key % HASH_SIZE;
-}
-
 // Create a new LRU node
-static LRUNode* create_node(int key, int value) {
-    LRUNode* node = (LRUNode*)malloc(sizeof(LRUNode));
+static LRUNode* create_node(int key, int value, Cache* cache) {
+    LRUNode* node = (LRUNode*)node_arena_alloc(&cache->nodes);
     if (node) {
         node->key = key;
         node->value = value;
@@ -44,85 +57,153 @@ static LRUNode* create_node(int key, int value) {
     return node;
 }
 
-// Create a new hash entry
-static HashEntry* create_hash_entry(int key, LRUNode* node) {
-    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
-    if (entry) {
-        entry->key = key;
-        entry->node = node;
-        entry->next = NULL;
+// Index handle for a node on the given segment
+static uint32_t tag_handle(Cache* cache, int segment, LRUNode* node) {
+    return (uint32_t)segment << LRU_SEGMENT_SHIFT | node_arena_handle(&cache->nodes, node);
+}
+
+// Look up the node for key, or NULL; its segment is stored in *segment
+static LRUNode* find_node(Cache* cache, int key, int* segment) {
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE) {
+        return NULL;
     }
-    return entry;
+    if (!cache->tinylfu) {
+        *segment = LRU_WINDOW;
+        return (LRUNode*)node_arena_at(&cache->nodes, handle);
+    }
+    *segment = (int)(handle >> LRU_SEGMENT_SHIFT);
+    return (LRUNode*)node_arena_at(&cache->nodes, handle & LRU_HANDLE_MASK);
 }
 
-// Add node to front of list (most recently used)
-static void add_to_front(Cache* cache, LRUNode* node) {
-    node->next = cache->head;
+// Add node to front of a segment (most recently used)
+static void add_to_front(LRUSegment* segment, LRUNode* node) {
+    node->next = segment->head;
     node->prev = NULL;
     
-    if (cache->head) {
-        cache->head->prev = node;
+    if (segment->head) {
+        segment->head->prev = node;
     }
-    cache->head = node;
+    segment->head = node;
     
-    if (!cache->tail) {
-        cache->tail = node;
+    if (!segment->tail) {
+        segment->tail = node;
     }
+    segment->size++;
 }
 
-// Remove node from list
-static void remove_node(Cache* cache, LRUNode* node) {
+// Remove node from a segment
+static void remove_node(LRUSegment* segment, LRUNode* node) {
     if (node->prev) {
         node->prev->next = node->next;
     } else {
-        cache->head = node->next;
+        segment->head = node->next;
     }
     
     if (node->next) {
         node->next->prev = node->prev;
     } else {
-        cache->tail = node->prev;
+        segment->tail = node->prev;
     }
+    segment->size--;
 }
 
 // Move node to front (most recently used)
-static void move_to_front(Cache* cache, LRUNode* node) {
-    remove_node(cache, node);
-    add_to_front(cache, node);
+static void move_to_front(LRUSegment* segment, LRUNode* node) {
+    remove_node(segment, node);
+    add_to_front(segment, node);
 }
 
-// Remove entry from hash table
-static void remove_from_hash(Cache* cache, int key) {
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    HashEntry* prev = NULL;
+// Move node from one segment to the front of another
+static void move_to_segment(Cache* cache, LRUNode* node, int from, int to) {
+    remove_node(&cache->segments[from], node);
+    add_to_front(&cache->segments[to], node);
+    cache_index_update(&cache->index, node->key, tag_handle(cache, to, node));
+}
 
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                cache->hash_table[h] = entry->next;
-            }
-            free(entry);
-            return;
-        }
-        prev = entry;
-        entry = entry->next;
+// Drop a node from the cache entirely
+static void drop_node(Cache* cache, int segment, LRUNode* node) {
+    remove_node(&cache->segments[segment], node);
+    cache_index_remove(&cache->index, node->key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+}
+
+// Drop a node to make room
+static void evict_node(Cache* cache, int segment, LRUNode* node) {
+    drop_node(cache, segment, node);
+    cache->evictions++;
+}
+
+// Record a hit on a node. A second hit while on probation promotes it to
+// the protected segment, whose least recently used node drops back to
+// probation if the segment is over its share
+static void touch_node(Cache* cache, LRUNode* node, int segment) {
+    if (segment != LRU_PROBATION) {
+        move_to_front(&cache->segments[segment], node);
+        return;
+    }
+
+    move_to_segment(cache, node, LRU_PROBATION, LRU_PROTECTED);
+
+    LRUSegment* protected_segment = &cache->segments[LRU_PROTECTED];
+    if (protected_segment->size > protected_segment->capacity) {
+        move_to_segment(cache, protected_segment->tail, LRU_PROTECTED, LRU_PROBATION);
     }
 }
 
-// Add entry to hash table
-static void add_to_hash(Cache* cache, int key, LRUNode* node) {
-    unsigned int h = hash(key);
-    HashEntry* entry = create_hash_entry(key, node);
-    entry->next = cache->hash_table[h];
-    cache->hash_table[h] = entry;
+// Make room in the window for one new key. The window's least recently used
+// node moves to probation while the main region has room; once it is full
+// the node only gets in if the sketch says it is accessed more often than
+// the main region's eviction candidate, and whichever loses is evicted
+static void admit_from_window(Cache* cache) {
+    LRUSegment* window = &cache->segments[LRU_WINDOW];
+    LRUSegment* probation = &cache->segments[LRU_PROBATION];
+    LRUSegment* protected_segment = &cache->segments[LRU_PROTECTED];
+
+    if (window->size < window->capacity) {
+        return;
+    }
+
+    LRUNode* candidate = window->tail;
+    if (probation->size + protected_segment->size < probation->capacity + protected_segment->capacity) {
+        move_to_segment(cache, candidate, LRU_WINDOW, LRU_PROBATION);
+        return;
+    }
+
+    int victim_segment = probation->tail ? LRU_PROBATION : LRU_PROTECTED;
+    LRUNode* victim = cache->segments[victim_segment].tail;
+    if (victim &&
+        frequency_sketch_estimate(&cache->sketch, candidate->key) >
+        frequency_sketch_estimate(&cache->sketch, victim->key)) {
+        evict_node(cache, victim_segment, victim);
+        move_to_segment(cache, candidate, LRU_WINDOW, LRU_PROBATION);
+    } else {
+        evict_node(cache, LRU_WINDOW, candidate);
+    }
 }
 
-// Create a new cache
-Cache* create_lru_cache(int capacity) {
-    if (capacity <= 0 || capacity > MAX_CACHE_SIZE) {
+// Set the capacity; in W-TinyLFU mode also split it among the segments
+static void size_segments(Cache* cache, int capacity) {
+    if (cache->tinylfu) {
+        int window = capacity * TINYLFU_WINDOW_PERCENT / 100;
+        int main_region;
+
+        window = window > 0 ? window : 1;
+        main_region = capacity - window;
+        cache->segments[LRU_WINDOW].capacity = window;
+        cache->segments[LRU_PROTECTED].capacity = main_region * TINYLFU_PROTECTED_PERCENT / 100;
+        cache->segments[LRU_PROBATION].capacity =
+            main_region - cache->segments[LRU_PROTECTED].capacity;
+    } else {
+        cache->segments[LRU_WINDOW].capacity = capacity;
+    }
+    cache->capacity = capacity;
+}
+
+// Set up a cache; W-TinyLFU mode also sizes the regions and the sketch
+static Cache* create_cache(int capacity, CacheIndexSizing sizing, int tinylfu) {
+    if (capacity <= 0 || (tinylfu && capacity > (int)LRU_HANDLE_MASK)) {
         return NULL;
     }
 
@@ -131,45 +212,64 @@ Cache* create_lru_cache(int capacity) {
         return NULL;
     }
 
-    cache->hash_table = (HashEntry**)calloc(HASH_SIZE, sizeof(HashEntry*));
-    if (!cache->hash_table) {
+    if (cache_index_init(&cache->index, capacity, sizing) != 0) {
         free(cache);
         return NULL;
     }
 
-    cache->head = NULL;
-    cache->tail = NULL;
+    if (node_arena_init(&cache->nodes, sizeof(LRUNode), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    if (tinylfu && frequency_sketch_init(&cache->sketch, capacity) != 0) {
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    memset(cache->segments, 0, sizeof(cache->segments));
+    cache->tinylfu = tinylfu;
+    cache->evictions = 0;
     cache->size = 0;
-    cache->capacity = capacity;
+    size_segments(cache, capacity);
 
     return cache;
 }
 
+// Create a new cache
+Cache* create_lru_cache(int capacity) {
+    return create_lru_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_lru_cache_sized(int capacity, CacheIndexSizing sizing) {
+    return create_cache(capacity, sizing, 0);
+}
+
+// Create a new cache in W-TinyLFU mode
+Cache* create_wtinylfu_cache(int capacity) {
+    return create_wtinylfu_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new W-TinyLFU cache with the given index sizing mode
+Cache* create_wtinylfu_cache_sized(int capacity, CacheIndexSizing sizing) {
+    return create_cache(capacity, sizing, 1);
+}
+
 // Destroy the cache
 void destroy_lru_cache(Cache* cache) {
     if (!cache) {
         return;
     }
 
-    // Free all nodes in the linked list
-    LRUNode* current = cache->head;
-    while (current) {
-        LRUNode* next = current->next;
-        free(current);
-        current = next;
+    if (cache->tinylfu) {
+        frequency_sketch_destroy(&cache->sketch);
     }
-
-    // Free all hash entries
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashEntry* entry = cache->hash_table[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
-    }
-
-    free(cache->hash_table);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
     free(cache);
 }
 
@@ -179,18 +279,20 @@ int get_lru(Cache* cache, int key) {
         return -1;
     }
 
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            move_to_front(cache, entry->node);
-            return entry->node->value;
-        }
-        entry = entry->next;
+    // Gets are where a caller sees every access, hit or miss, so they
+    // are what the sketch counts
+    if (cache->tinylfu) {
+        frequency_sketch_increment(&cache->sketch, key);
     }
-    
-    return -1;  // Key not found
+
+    int segment;
+    LRUNode* node = find_node(cache, key, &segment);
+    if (!node) {
+        return -1;  // Key not found
+    }
+
+    touch_node(cache, node, segment);
+    return node->value;
 }
 
 // Put value in cache
@@ -200,52 +302,139 @@ void put_lru(Cache* cache, int key, int value) {
     }
 
     // Check if key exists
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->value = value;
-            move_to_front(cache, entry->node);
-            return;
-        }
-        entry = entry->next;
+    int segment;
+    LRUNode* node = find_node(cache, key, &segment);
+    if (node) {
+        node->value = value;
+        touch_node(cache, node, segment);
+        return;
+    }
+
+    if (cache->tinylfu) {
+        admit_from_window(cache);
+    } else if (cache->size >= cache->capacity) {
+        // If cache is full, remove least recently used
+        evict_node(cache, LRU_WINDOW, cache->segments[LRU_WINDOW].tail);
     }
 
     // Create new node
-    LRUNode* new_node = create_node(key, value);
+    LRUNode* new_node = create_node(key, value, cache);
     if (!new_node) {
         return;
     }
 
-    // If cache is full, remove least recently used
-    if (cache->size >= cache->capacity) {
-        LRUNode* lru = cache->tail;
-        remove_node(cache, lru);
-        remove_from_hash(cache, lru->key);
-        free(lru);
-        cache->size--;
-    }
-
     // Add new node
-    add_to_front(cache, new_node);
-    add_to_hash(cache, key, new_node);
+    if (cache_index_insert(&cache->index, key, tag_handle(cache, LRU_WINDOW, new_node)) != 0) {
+        node_arena_free(&cache->nodes, new_node);
+        return;
+    }
+    add_to_front(&cache->segments[LRU_WINDOW], new_node);
     cache->size++;
 }
 
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(lru, nodes, LRU_HANDLE_MASK, 0)
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_lru(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    int segment;
+    LRUNode* node = find_node(cache, key, &segment);
+    if (!node) {
+        return -1;
+    }
+
+    drop_node(cache, segment, node);
+    return 0;
+}
+
+// Evict the entry the cache would replace next; returns -1 if it is empty.
+// In W-TinyLFU mode that is the main region's candidate, or the window's
+// least recently used entry while the main region is empty
+int evict_lru(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    int segment = LRU_WINDOW;
+    if (cache->segments[LRU_PROBATION].tail) {
+        segment = LRU_PROBATION;
+    } else if (cache->segments[LRU_PROTECTED].tail) {
+        segment = LRU_PROTECTED;
+    }
+    evict_node(cache, segment, cache->segments[segment].tail);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. In W-TinyLFU mode the segments and the sketch
+// shrink or grow with it: the window's and protected segment's oldest
+// entries move to probation until each fits its share, then entries are
+// evicted from the main region until it fits its own share, since
+// admit_from_window only makes room once the window is full and relies
+// on the main region never being over
+int resize_lru(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    size_segments(cache, capacity);
+    if (cache->tinylfu) {
+        LRUSegment* window = &cache->segments[LRU_WINDOW];
+        LRUSegment* probation = &cache->segments[LRU_PROBATION];
+        LRUSegment* protected_segment = &cache->segments[LRU_PROTECTED];
+
+        frequency_sketch_resize(&cache->sketch, capacity);
+        while (window->size > window->capacity) {
+            move_to_segment(cache, window->tail, LRU_WINDOW, LRU_PROBATION);
+        }
+        while (protected_segment->size > protected_segment->capacity) {
+            move_to_segment(cache, protected_segment->tail, LRU_PROTECTED, LRU_PROBATION);
+        }
+        while (probation->size + protected_segment->size > probation->capacity + protected_segment->capacity) {
+            evict_lru(cache);
+        }
+    }
+    while (cache->size > capacity) {
+        evict_lru(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_lru_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
 // Print cache contents
 void print_lru_cache_contents(Cache* cache, const char* message) {
+    static const char* names[] = { "Window", "Probation", "Protected" };
+
     printf("\n%s:\n", message);
     printf("Cache contents (Most Recent → Least Recent):\n");
     printf("------------------------------------------------\n");
-    printf("Key\tValue\n");
+    printf(cache->tinylfu ? "Key\tValue\tSegment\n" : "Key\tValue\n");
     printf("------------------------------------------------\n");
     
-    LRUNode* current = cache->head;
-    while (current) {
-        printf("%d\t%d\n", current->key, current->value);
-        current = current->next;
+    for (int segment = 0; segment < LRU_SEGMENTS; segment++) {
+        LRUNode* current = cache->segments[segment].head;
+        while (current) {
+            if (cache->tinylfu) {
+                printf("%d\t%d\t%s\n", current->key, current->value, names[segment]);
+            } else {
+                printf("%d\t%d\n", current->key, current->value);
+            }
+            current = current->next;
+        }
     }
     printf("------------------------------------------------\n");
     printf("Cache size: %d/%d\n", cache->size, cache->capacity);
-} 
\ No newline at end of file
+    if (cache->tinylfu) {
+        printf("Sketch: %zu bytes\n", frequency_sketch_bytes(&cache->sketch));
+    }
+}
@@ -4,11 +4,22 @@
 #include "cache_interface.h"
 
 Cache* create_lru_cache(int capacity);
+Cache* create_lru_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_lru_cache(Cache* cache);
 int get_lru(Cache* cache, int key);
 void put_lru(Cache* cache, int key, int value);
+void get_many_lru(Cache* cache, const int* keys, int* values, int count);
+void put_many_lru(Cache* cache, const int* keys, const int* values, int count);
+int erase_lru(Cache* cache, int key);
+int evict_lru(Cache* cache);
+int resize_lru(Cache* cache, int capacity);
+void get_lru_stats(Cache* cache, CacheStats* stats);
 void print_lru_cache_contents(Cache* cache, const char* message);
 
-// LRU specific declarations can be added here if needed
+// W-TinyLFU mode: an admission window plus a segmented LRU main region,
+// with admission decided by a frequency sketch. Use the LRU functions below
+// to get, put, print and destroy it.
+Cache* create_wtinylfu_cache(int capacity);
+Cache* create_wtinylfu_cache_sized(int capacity, CacheIndexSizing sizing);
 
 #endif // LRU_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "node_arena.h"
+#include <string.h>
+#include <sys/mman.h>
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// Reserve room for capacity nodes of node_size bytes each
+int node_arena_init(NodeArena* arena, size_t node_size, uint32_t capacity) {
+    // Nodes must be able to hold the free-list link. sizeof already pads a
+    // struct to its own alignment, so only the link's alignment is added
+    if (node_size < sizeof(uint32_t)) {
+        node_size = sizeof(uint32_t);
+    }
+    node_size = (node_size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+
+    size_t bytes = node_size * (size_t)capacity;
+    if (bytes >= HUGE_PAGE_SIZE) {
+        bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    }
+
+    void* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+#if defined(MADV_HUGEPAGE)
+    if (bytes >= HUGE_PAGE_SIZE) {
+        madvise(base, bytes, MADV_HUGEPAGE);    // Advisory: fine if refused
+    }
+#endif
+
+    arena->base = (char*)base;
+    arena->node_size = node_size;
+    arena->mapped_bytes = bytes;
+    arena->capacity = capacity;
+    arena->next_unused = 0;
+    arena->free_head = NODE_ARENA_NONE;
+    return 0;
+}
+
+// Release the whole arena at once
+void node_arena_destroy(NodeArena* arena) {
+    if (arena->base) {
+        munmap(arena->base, arena->mapped_bytes);
+        arena->base = NULL;
+    }
+}
+
+// Take a node off the free list, or the next never-used one; NULL when full
+void* node_arena_alloc(NodeArena* arena) {
+    if (arena->free_head != NODE_ARENA_NONE) {
+        void* node = node_arena_at(arena, arena->free_head);
+        memcpy(&arena->free_head, node, sizeof(uint32_t));
+        return node;
+    }
+
+    if (arena->next_unused < arena->capacity) {
+        return node_arena_at(arena, arena->next_unused++);
+    }
+    return NULL;
+}
+
+// Return a node to the free list
+void node_arena_free(NodeArena* arena, void* node) {
+    memcpy(node, &arena->free_head, sizeof(uint32_t));
+    arena->free_head = node_arena_handle(arena, node);
+}
@@ -0,0 +1,43 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-size node storage for one cache.
+//
+// All nodes are reserved up front in a single mapping sized for the cache's
+// capacity, and handed out by 32-bit handle (the node's position in the
+// arena). Freed nodes go on an intrusive free list threaded through their
+// first four bytes, so get/put never call malloc or free. Pages are only
+// touched as nodes are first used, and mappings of 2MB or more ask the
+// kernel for transparent huge pages where that is supported.
+
+#define NODE_ARENA_NONE UINT32_MAX
+
+// Arena structure
+typedef struct NodeArena {
+    char* base;
+    size_t node_size;
+    size_t mapped_bytes;
+    uint32_t capacity;
+    uint32_t next_unused;   // Nodes at or past this index were never handed out
+    uint32_t free_head;     // Most recently freed node, or NODE_ARENA_NONE
+} NodeArena;
+
+int node_arena_init(NodeArena* arena, size_t node_size, uint32_t capacity);
+void node_arena_destroy(NodeArena* arena);
+void* node_arena_alloc(NodeArena* arena);
+void node_arena_free(NodeArena* arena, void* node);
+
+// Node for a handle
+static inline void* node_arena_at(const NodeArena* arena, uint32_t handle) {
+    return arena->base + (size_t)handle * arena->node_size;
+}
+
+// Handle for a node
+static inline uint32_t node_arena_handle(const NodeArena* arena, const void* node) {
+    return (uint32_t)(((const char*)node - arena->base) / arena->node_size);
+}
+
+#endif // NODE_ARENA_H
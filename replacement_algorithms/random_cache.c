@@ -1,137 +1,51 @@
 #include "random_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "cache_rng.h"
+#include "node_arena.h"
 #include <string.h>
-#include <time.h>
 
-#define HASH_SIZE 1000
-
-// Node structure for linked list
+// Entry structure. Entries are packed into positions [0, size) of the
+// arena (used as plain preallocated storage), and the index maps each key
+// to its position, so picking a victim is a single random position rather
+// than a list walk.
 typedef struct Node {
     int key;
     int value;
-    struct Node* prev;
-    struct Node* next;
 } Node;
 
-// Hash entry structure
-typedef struct HashEntry {
-    int key;
-    Node* node;
-    struct HashEntry* next;
-} HashEntry;
-
 // Cache structure
 struct Cache {
-    Node* head;
-    Node* tail;
-    HashEntry** hash_table;
+    CacheIndex index;
+    NodeArena nodes;
+    CacheRng rng;
+    uint64_t evictions;
     int size;
     int capacity;
 };
 
-// Hash function
-static unsigned int hash(int key) {
-    return (unsigned int)key % HASH_SIZE;
-}
-
-// Create a new node
-static Node* create_node(int key, int value) {
-    Node* node = (Node*)malloc(sizeof(Node));
-    if (node) {
-        node->key = key;
-        node->value = value;
-        node->prev = NULL;
-        node->next = NULL;
-    }
-    return node;
-}
-
-// Create a new hash entry
-static HashEntry* create_hash_entry(int key, Node* node) {
-    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
-    if (entry) {
-        entry->key = key;
-        entry->node = node;
-        entry->next = NULL;
-    }
-    return entry;
-}
-
-// Add node to list
-static void add_node(Cache* cache, Node* node) {
-    if (!cache->tail) {
-        cache->head = node;
-        cache->tail = node;
-    } else {
-        node->prev = cache->tail;
-        cache->tail->next = node;
-        cache->tail = node;
-    }
+// Entry at a position
+static Node* entry_at(Cache* cache, uint32_t pos) {
+    return (Node*)node_arena_at(&cache->nodes, pos);
 }
 
-// Remove node from list
-static void remove_node(Cache* cache, Node* node) {
-    if (node->prev) {
-        node->prev->next = node->next;
-    } else {
-        cache->head = node->next;
-    }
-    
-    if (node->next) {
-        node->next->prev = node->prev;
-    } else {
-        cache->tail = node->prev;
-    }
-}
-
-// Remove entry from hash table
-static void remove_from_hash(Cache* cache, int key) {
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    HashEntry* prev = NULL;
-
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                cache->hash_table[h] = entry->next;
-            }
-            free(entry);
-            return;
-        }
-        prev = entry;
-        entry = entry->next;
-    }
-}
-
-// Add entry to hash table
-static void add_to_hash(Cache* cache, int key, Node* node) {
-    unsigned int h = hash(key);
-    HashEntry* entry = create_hash_entry(key, node);
-    entry->next = cache->hash_table[h];
-    cache->hash_table[h] = entry;
-}
-
-// Get random node from cache
-static Node* get_random_node(Cache* cache) {
-    if (!cache->head) {
+// Look up the entry for key, or NULL
+static Node* find_node(Cache* cache, int key) {
+    uint32_t pos = cache_index_find(&cache->index, key);
+    if (pos == CACHE_INDEX_NONE) {
         return NULL;
     }
-
-    int random_pos = rand() % cache->size;
-    Node* current = cache->head;
-    
-    while (random_pos > 0 && current) {
-        current = current->next;
-        random_pos--;
-    }
-
-    return current;
+    return entry_at(cache, pos);
 }
 
 // Create a new cache
 Cache* create_random_cache(int capacity) {
-    if (capacity <= 0 || capacity > MAX_CACHE_SIZE) {
+    return create_random_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_random_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0) {
         return NULL;
     }
 
@@ -140,48 +54,42 @@ Cache* create_random_cache(int capacity) {
         return NULL;
     }
 
-    cache->hash_table = (HashEntry**)calloc(HASH_SIZE, sizeof(HashEntry*));
-    if (!cache->hash_table) {
+    if (cache_index_init(&cache->index, capacity, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(Node), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
         free(cache);
         return NULL;
     }
 
-    cache->head = NULL;
-    cache->tail = NULL;
+    cache->evictions = 0;
     cache->size = 0;
     cache->capacity = capacity;
 
-    // Initialize random seed
-    srand(time(NULL));
+    // Every cache starts from the same seed; seed_random_cache picks another
+    cache_rng_seed(&cache->rng, CACHE_RNG_DEFAULT_SEED, 0);
 
     return cache;
 }
 
+// Reseed the cache's eviction generator
+void seed_random_cache(Cache* cache, uint64_t seed) {
+    if (cache) {
+        cache_rng_seed(&cache->rng, seed, 0);
+    }
+}
+
 // Destroy the cache
 void destroy_random_cache(Cache* cache) {
     if (!cache) {
         return;
     }
 
-    // Free all nodes in the list
-    Node* current = cache->head;
-    while (current) {
-        Node* next = current->next;
-        free(current);
-        current = next;
-    }
-
-    // Free all hash entries
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashEntry* entry = cache->hash_table[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
-    }
-
-    free(cache->hash_table);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
     free(cache);
 }
 
@@ -191,17 +99,12 @@ int get_random(Cache* cache, int key) {
         return -1;
     }
 
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            return entry->node->value;
-        }
-        entry = entry->next;
+    Node* node = find_node(cache, key);
+    if (!node) {
+        return -1;  // Key not found
     }
-    
-    return -1;  // Key not found
+
+    return node->value;
 }
 
 // Put value in cache
@@ -211,38 +114,95 @@ void put_random(Cache* cache, int key, int value) {
     }
 
     // Check if key exists
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->value = value;
-            return;
-        }
-        entry = entry->next;
+    Node* node = find_node(cache, key);
+    if (node) {
+        node->value = value;
+        return;
     }
 
-    // Create new node
-    Node* new_node = create_node(key, value);
-    if (!new_node) {
+    // If cache is full, the new entry takes a random victim's position;
+    // otherwise it is appended after the last entry
+    int evict = cache->size >= cache->capacity;
+    uint32_t pos = evict ? cache_rng_below(&cache->rng, (uint32_t)cache->size)
+                         : (uint32_t)cache->size;
+
+    if (cache_index_insert(&cache->index, key, pos) != 0) {
         return;
     }
 
-    // If cache is full, remove random entry
-    if (cache->size >= cache->capacity) {
-        Node* random_node = get_random_node(cache);
-        if (random_node) {
-            remove_node(cache, random_node);
-            remove_from_hash(cache, random_node->key);
-            free(random_node);
-            cache->size--;
-        }
+    node = entry_at(cache, pos);
+    if (evict) {
+        cache_index_remove(&cache->index, node->key);
+        cache->evictions++;
+    } else {
+        cache->size++;
+    }
+    node->key = key;
+    node->value = value;
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(random, nodes, UINT32_MAX, 0)
+
+// Empty the entry at pos; the last entry moves into it so positions
+// [0, size) stay packed
+static void remove_entry(Cache* cache, uint32_t pos) {
+    uint32_t last = (uint32_t)cache->size - 1;
+    Node* node = entry_at(cache, pos);
+
+    cache_index_remove(&cache->index, node->key);
+    if (pos != last) {
+        *node = *entry_at(cache, last);
+        cache_index_update(&cache->index, node->key, pos);
+    }
+    cache->size--;
+}
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_random(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t pos = cache_index_find(&cache->index, key);
+    if (pos == CACHE_INDEX_NONE) {
+        return -1;
+    }
+
+    remove_entry(cache, pos);
+    return 0;
+}
+
+// Evict a random entry; returns -1 if the cache is empty
+int evict_random(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
     }
 
-    // Add new node
-    add_node(cache, new_node);
-    add_to_hash(cache, key, new_node);
-    cache->size++;
+    remove_entry(cache, cache_rng_below(&cache->rng, (uint32_t)cache->size));
+    cache->evictions++;
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with, evicting
+// random entries that no longer fit; returns -1 if it is out of range
+int resize_random(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    cache->capacity = capacity;
+    while (cache->size > capacity) {
+        evict_random(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_random_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
 }
 
 // Print cache contents
@@ -252,12 +212,11 @@ void print_random_cache_contents(Cache* cache, const char* message) {
     printf("------------------------------------------------\n");
     printf("Key\tValue\n");
     printf("------------------------------------------------\n");
-    
-    Node* current = cache->head;
-    while (current) {
+
+    for (int i = 0; i < cache->size; i++) {
+        Node* current = entry_at(cache, (uint32_t)i);
         printf("%d\t%d\n", current->key, current->value);
-        current = current->next;
     }
     printf("------------------------------------------------\n");
     printf("Cache size: %d/%d\n", cache->size, cache->capacity);
-} 
\ No newline at end of file
+}
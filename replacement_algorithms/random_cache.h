@@ -4,10 +4,18 @@
 #include "cache_interface.h"
 
 Cache* create_random_cache(int capacity);
+Cache* create_random_cache_sized(int capacity, CacheIndexSizing sizing);
 void destroy_random_cache(Cache* cache);
 int get_random(Cache* cache, int key);
 void put_random(Cache* cache, int key, int value);
+void get_many_random(Cache* cache, const int* keys, int* values, int count);
+void put_many_random(Cache* cache, const int* keys, const int* values, int count);
+int erase_random(Cache* cache, int key);
+int evict_random(Cache* cache);
+int resize_random(Cache* cache, int capacity);
+void get_random_stats(Cache* cache, CacheStats* stats);
 void print_random_cache_contents(Cache* cache, const char* message);
+void seed_random_cache(Cache* cache, uint64_t seed);
 
 // Random specific declarations can be added here if needed
 
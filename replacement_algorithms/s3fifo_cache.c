@@ -0,0 +1,451 @@
+#include "s3fifo_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <limits.h>
+#include <string.h>
+
+// S3-FIFO (Yang et al., SOSP '23). New keys enter a small FIFO queue S;
+// keys evicted from S without having been hit there are remembered in a
+// ghost FIFO G, and everything else lives in the main FIFO queue M. A hit
+// only bumps the entry's 2-bit frequency, so gets never reorder anything:
+// - evicting from S moves entries hit while in S to M, and sends the
+//   first one that wasn't to G
+// - evicting from M reinserts entries with a nonzero frequency at the tail
+//   (decrementing it), and drops the first one with frequency 0
+// - a put of a key still in G goes straight to M
+//
+// Like fifo_cache.c, every queue is a fixed ring buffer. S and M hold
+// 32-bit node handles; G holds bare keys. Each node knows its position in
+// S or M, so an erased entry just leaves a hole that evictions skip. S and
+// M have a quarter of the capacity in spare slots, so a ring only fills up
+// with holes, and is compacted before the next push, after that many
+// erases; erase stays amortized O(1).
+
+#define S3FIFO_FREQ_MAX 3               // 2-bit counter
+#define S3FIFO_GHOST ((uint32_t)1 << 31)    // Index handle flag for ghost keys
+#define S3FIFO_HOLE UINT32_MAX              // Ring slot of an erased entry
+
+// Entry structure
+typedef struct S3Node {
+    int key;
+    int value;
+    uint32_t pos;       // Ring position in S or M
+    uint8_t freq;
+    uint8_t in_main;
+} S3Node;
+
+// Ring buffer of 32-bit handles or keys
+typedef struct S3Queue {
+    uint32_t* slots;
+    uint32_t head;      // Oldest
+    uint32_t size;      // Including holes
+    uint32_t holes;
+    uint32_t capacity;
+} S3Queue;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;       // Resident keys, and ghost keys flagged S3FIFO_GHOST
+    NodeArena nodes;
+    S3Queue small;
+    S3Queue main;
+    S3Queue ghost;
+    int small_percent;      // S's share of the capacity
+    int small_target;       // Size S is allowed before evictions come from it
+    uint32_t ghost_limit;   // Ghosts kept in G, at most its ring size
+    uint64_t evictions;
+    int size;
+    int capacity;
+};
+
+static int queue_init(S3Queue* queue, uint32_t capacity) {
+    queue->slots = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    queue->head = 0;
+    queue->size = 0;
+    queue->holes = 0;
+    queue->capacity = capacity;
+    return queue->slots ? 0 : -1;
+}
+
+// Append at the tail; returns the ring position used
+static uint32_t queue_push(S3Queue* queue, uint32_t item) {
+    uint32_t pos = (queue->head + queue->size) % queue->capacity;
+    queue->slots[pos] = item;
+    queue->size++;
+    return pos;
+}
+
+// Remove and return the oldest item
+static uint32_t queue_pop(S3Queue* queue) {
+    uint32_t item = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->size--;
+    return item;
+}
+
+// Entries in a queue, not counting holes
+static uint32_t queue_live(const S3Queue* queue) {
+    return queue->size - queue->holes;
+}
+
+static S3Node* node_at(Cache* cache, uint32_t handle) {
+    return (S3Node*)node_arena_at(&cache->nodes, handle);
+}
+
+// Close up the holes in S or M, keeping the order
+static void compact(Cache* cache, S3Queue* queue) {
+    uint32_t live = 0;
+
+    for (uint32_t i = 0; i < queue->size; i++) {
+        uint32_t handle = queue->slots[(queue->head + i) % queue->capacity];
+        if (handle != S3FIFO_HOLE) {
+            uint32_t pos = (queue->head + live++) % queue->capacity;
+            queue->slots[pos] = handle;
+            node_at(cache, handle)->pos = pos;
+        }
+    }
+    queue->size = live;
+    queue->holes = 0;
+}
+
+// Append a node to S or M
+static void push_node(Cache* cache, S3Queue* queue, uint32_t handle) {
+    if (queue->size == queue->capacity) {
+        compact(cache, queue);
+    }
+
+    S3Node* node = node_at(cache, handle);
+    node->pos = queue_push(queue, handle);
+    node->in_main = queue == &cache->main;
+}
+
+// Forget the oldest ghost in G. A key that was readmitted or ghosted again
+// since then has a different index handle, so only a still-current ghost
+// is dropped from the index
+static void drop_ghost(Cache* cache) {
+    S3Queue* ghost = &cache->ghost;
+    uint32_t pos = ghost->head;
+    int old = (int)queue_pop(ghost);
+
+    if (cache_index_find(&cache->index, old) == (S3FIFO_GHOST | pos)) {
+        cache_index_remove(&cache->index, old);
+    }
+}
+
+// Remember an evicted key in G, forgetting the oldest ghost if G is full
+static void add_ghost(Cache* cache, int key) {
+    S3Queue* ghost = &cache->ghost;
+
+    while (ghost->size >= cache->ghost_limit) {
+        drop_ghost(cache);
+    }
+
+    uint32_t pos = queue_push(ghost, (uint32_t)key);
+    cache_index_update(&cache->index, key, S3FIFO_GHOST | pos);
+}
+
+// Evict one entry from M: entries with a nonzero frequency go round again
+static void evict_main(Cache* cache) {
+    while (cache->main.size > 0) {
+        uint32_t handle = queue_pop(&cache->main);
+        if (handle == S3FIFO_HOLE) {
+            cache->main.holes--;
+            continue;
+        }
+        S3Node* node = node_at(cache, handle);
+
+        if (node->freq > 0) {
+            node->freq--;
+            push_node(cache, &cache->main, handle);
+        } else {
+            cache_index_remove(&cache->index, node->key);
+            node_arena_free(&cache->nodes, node);
+            cache->size--;
+            cache->evictions++;
+            return;
+        }
+    }
+}
+
+// Evict from S: entries hit while in S move to M (which may evict from M),
+// and the first one that wasn't becomes a ghost
+static void evict_small(Cache* cache) {
+    int main_target = cache->capacity - cache->small_target;
+
+    while (cache->small.size > 0) {
+        uint32_t handle = queue_pop(&cache->small);
+        if (handle == S3FIFO_HOLE) {
+            cache->small.holes--;
+            continue;
+        }
+        S3Node* node = node_at(cache, handle);
+
+        if (node->freq > 0) {
+            node->freq = 0;
+            push_node(cache, &cache->main, handle);
+            if ((int)queue_live(&cache->main) > main_target) {
+                evict_main(cache);
+            }
+        } else {
+            int key = node->key;
+            node_arena_free(&cache->nodes, node);
+            cache->size--;
+            cache->evictions++;
+            add_ghost(cache, key);
+            return;
+        }
+    }
+}
+
+// Make room for one entry
+static void evict(Cache* cache) {
+    if ((int)queue_live(&cache->small) >= cache->small_target || queue_live(&cache->main) == 0) {
+        evict_small(cache);
+    } else {
+        evict_main(cache);
+    }
+}
+
+// Set the capacity and split it between S and M; G remembers as many keys
+// as M holds
+static void size_queues(Cache* cache, int capacity) {
+    int small_target = (int)((long long)capacity * cache->small_percent / 100);
+    int main_target;
+
+    small_target = small_target > 0 ? small_target : 1;
+    main_target = capacity - small_target;
+    cache->small_target = small_target;
+    cache->ghost_limit = main_target > 0 ? (uint32_t)main_target : 1;
+    cache->capacity = capacity;
+}
+
+// Create a new cache
+Cache* create_s3fifo_cache(int capacity) {
+    return create_s3fifo_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_s3fifo_cache_sized(int capacity, CacheIndexSizing sizing) {
+    return create_s3fifo_cache_split(capacity, S3FIFO_SMALL_PERCENT, sizing);
+}
+
+// Create a new cache whose small queue gets small_percent of the capacity
+Cache* create_s3fifo_cache_split(int capacity, int small_percent, CacheIndexSizing sizing) {
+    if (capacity <= 0 || capacity > INT_MAX / 2 ||
+        small_percent <= 0 || small_percent > 100) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->small_percent = small_percent;
+    size_queues(cache, capacity);
+    int main_target = capacity - cache->small_target;
+
+    // The index holds resident keys plus up to one ghost per main slot
+    if (cache_index_init(&cache->index, capacity + main_target, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(S3Node), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    // S can briefly hold every entry (before M has any), and M can too,
+    // plus the spare slots for holes
+    uint32_t ring_size = (uint32_t)capacity + (uint32_t)capacity / 4 + 1;
+    if (queue_init(&cache->small, ring_size) != 0 ||
+        queue_init(&cache->main, ring_size) != 0 ||
+        queue_init(&cache->ghost, cache->ghost_limit) != 0) {
+        free(cache->small.slots);
+        free(cache->main.slots);
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    cache->evictions = 0;
+    cache->size = 0;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_s3fifo_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    free(cache->ghost.slots);
+    free(cache->main.slots);
+    free(cache->small.slots);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
+    free(cache);
+}
+
+// Get value from cache
+int get_s3fifo(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & S3FIFO_GHOST)) {
+        return -1;  // Key not found (ghosts hold no value)
+    }
+
+    S3Node* node = node_at(cache, handle);
+    if (node->freq < S3FIFO_FREQ_MAX) {
+        node->freq++;
+    }
+    return node->value;
+}
+
+// Put value in cache
+void put_s3fifo(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    // Check if key exists
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle != CACHE_INDEX_NONE && !(handle & S3FIFO_GHOST)) {
+        S3Node* node = node_at(cache, handle);
+        node->value = value;
+        if (node->freq < S3FIFO_FREQ_MAX) {
+            node->freq++;
+        }
+        return;
+    }
+    int was_ghost = handle != CACHE_INDEX_NONE;
+
+    while (cache->size >= cache->capacity) {
+        evict(cache);
+    }
+
+    S3Node* node = (S3Node*)node_arena_alloc(&cache->nodes);
+    if (!node) {
+        return;
+    }
+    node->key = key;
+    node->value = value;
+    node->freq = 0;
+    handle = node_arena_handle(&cache->nodes, node);
+
+    // Evicting may have pushed the key's own ghost out of G
+    if ((!was_ghost || cache_index_update(&cache->index, key, handle) != 0) &&
+        cache_index_insert(&cache->index, key, handle) != 0) {
+        node_arena_free(&cache->nodes, node);
+        return;
+    }
+
+    push_node(cache, was_ghost ? &cache->main : &cache->small, handle);
+    cache->size++;
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(s3fifo, nodes, ~S3FIFO_GHOST, S3FIFO_GHOST)
+
+// Remove key from the cache, leaving a hole in its queue; returns -1 if
+// it was not cached
+int erase_s3fifo(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & S3FIFO_GHOST)) {
+        return -1;
+    }
+
+    S3Node* node = node_at(cache, handle);
+    S3Queue* queue = node->in_main ? &cache->main : &cache->small;
+    queue->slots[node->pos] = S3FIFO_HOLE;
+    queue->holes++;
+    cache_index_remove(&cache->index, key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+    return 0;
+}
+
+// Evict the entry a new key would displace; returns -1 if the cache is
+// empty. Entries S passes on to M don't count, so this runs until one
+// entry has actually left; as on a put, an entry moved into a full M can
+// push one out of M as well
+int evict_s3fifo(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    int size = cache->size;
+    while (cache->size >= size) {
+        evict(cache);
+    }
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. S and M get their shares of the new capacity,
+// entries are evicted as a put would evict them until the cache fits, and
+// the oldest ghosts are forgotten until G fits its new limit
+int resize_s3fifo(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    size_queues(cache, capacity);
+    while (cache->size > capacity) {
+        evict(cache);
+    }
+    while (cache->ghost.size > cache->ghost_limit) {
+        drop_ghost(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_s3fifo_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print one queue's resident entries, oldest first
+static void print_queue(Cache* cache, const S3Queue* queue, const char* name) {
+    for (uint32_t i = 0; i < queue->size; i++) {
+        uint32_t handle = queue->slots[(queue->head + i) % queue->capacity];
+        if (handle == S3FIFO_HOLE) {
+            continue;
+        }
+        S3Node* current = node_at(cache, handle);
+        printf("%d\t%d\t%d\t%s\n",
+               current->key,
+               current->value,
+               current->freq,
+               name);
+    }
+}
+
+// Print cache contents
+void print_s3fifo_cache_contents(Cache* cache, const char* message) {
+    printf("\n%s:\n", message);
+    printf("Cache contents (Small then Main, oldest first):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tFreq\tQueue\n");
+    printf("------------------------------------------------\n");
+
+    print_queue(cache, &cache->small, "Small");
+    print_queue(cache, &cache->main, "Main");
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d (small target %d, ghosts %u)\n",
+           cache->size, cache->capacity, cache->small_target, cache->ghost.size);
+}
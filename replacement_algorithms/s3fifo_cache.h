@@ -0,0 +1,24 @@
+#ifndef S3FIFO_CACHE_H
+#define S3FIFO_CACHE_H
+
+#include "cache_interface.h"
+
+#define S3FIFO_SMALL_PERCENT 10     // Default small queue share of the capacity
+
+Cache* create_s3fifo_cache(int capacity);
+Cache* create_s3fifo_cache_sized(int capacity, CacheIndexSizing sizing);
+Cache* create_s3fifo_cache_split(int capacity, int small_percent, CacheIndexSizing sizing);
+void destroy_s3fifo_cache(Cache* cache);
+int get_s3fifo(Cache* cache, int key);
+void put_s3fifo(Cache* cache, int key, int value);
+void get_many_s3fifo(Cache* cache, const int* keys, int* values, int count);
+void put_many_s3fifo(Cache* cache, const int* keys, const int* values, int count);
+int erase_s3fifo(Cache* cache, int key);
+int evict_s3fifo(Cache* cache);
+int resize_s3fifo(Cache* cache, int capacity);
+void get_s3fifo_stats(Cache* cache, CacheStats* stats);
+void print_s3fifo_cache_contents(Cache* cache, const char* message);
+
+// S3-FIFO specific declarations can be added here if needed
+
+#endif // S3FIFO_CACHE_H 
\ No newline at end of file
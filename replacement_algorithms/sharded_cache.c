@@ -0,0 +1,265 @@
+#include "sharded_cache.h"
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define SHARD_ALIGN 64              // Cache line
+#define SPIN_BEFORE_YIELD 128       // Pauses before a waiting thread yields its CPU
+
+// One partition of the key space
+typedef struct CacheShard {
+    union {
+        int spin;
+        pthread_mutex_t mutex;
+        pthread_rwlock_t rwlock;
+    } lock;
+    CacheHandle* cache;
+} __attribute__((aligned(SHARD_ALIGN))) CacheShard;
+
+// Cache structure
+struct ShardedCache {
+    CacheShard* shards;
+    uint32_t shard_mask;
+    ShardLockKind lock;
+    int shared_gets;            // Gets may take the rwlock in shared mode
+};
+
+static inline void cpu_relax(void) {
+#if defined(__SSE2__)
+    _mm_pause();
+#endif
+}
+
+// Take a spinlock, re-checking with plain loads so waiters don't keep
+// stealing the line from the owner
+static void spin_lock(int* lock) {
+    for (;;) {
+        if (!__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        int spins = 0;
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+            if (++spins < SPIN_BEFORE_YIELD) {
+                cpu_relax();
+            } else {
+                sched_yield();      // The owner may be waiting for this CPU
+                spins = 0;
+            }
+        }
+    }
+}
+
+static void spin_unlock(int* lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+// Take a shard's lock for exclusive use
+static void lock_exclusive(const ShardedCache* cache, CacheShard* shard) {
+    switch (cache->lock) {
+        case SHARD_LOCK_SPIN:
+            spin_lock(&shard->lock.spin);
+            break;
+        case SHARD_LOCK_MUTEX:
+            pthread_mutex_lock(&shard->lock.mutex);
+            break;
+        case SHARD_LOCK_RWLOCK:
+            pthread_rwlock_wrlock(&shard->lock.rwlock);
+            break;
+    }
+}
+
+static void unlock(const ShardedCache* cache, CacheShard* shard) {
+    switch (cache->lock) {
+        case SHARD_LOCK_SPIN:
+            spin_unlock(&shard->lock.spin);
+            break;
+        case SHARD_LOCK_MUTEX:
+            pthread_mutex_unlock(&shard->lock.mutex);
+            break;
+        case SHARD_LOCK_RWLOCK:
+            pthread_rwlock_unlock(&shard->lock.rwlock);
+            break;
+    }
+}
+
+// Shard owning key. The index picks groups from the top hash bits and
+// tags from bits 25-31, so the low bits are free to pick the shard
+static CacheShard* shard_for(const ShardedCache* cache, int key) {
+    return &cache->shards[(uint32_t)cache_hash_key(key) & cache->shard_mask];
+}
+
+static int init_lock(CacheShard* shard, ShardLockKind lock) {
+    switch (lock) {
+        case SHARD_LOCK_SPIN:
+            shard->lock.spin = 0;
+            return 0;
+        case SHARD_LOCK_MUTEX:
+            return pthread_mutex_init(&shard->lock.mutex, NULL) == 0 ? 0 : -1;
+        case SHARD_LOCK_RWLOCK:
+            return pthread_rwlock_init(&shard->lock.rwlock, NULL) == 0 ? 0 : -1;
+    }
+    return -1;
+}
+
+static void destroy_lock(CacheShard* shard, ShardLockKind lock) {
+    if (lock == SHARD_LOCK_MUTEX) {
+        pthread_mutex_destroy(&shard->lock.mutex);
+    } else if (lock == SHARD_LOCK_RWLOCK) {
+        pthread_rwlock_destroy(&shard->lock.rwlock);
+    }
+}
+
+// Free the first count shards
+static void destroy_shards(ShardedCache* cache, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        cache_destroy(cache->shards[i].cache);
+        destroy_lock(&cache->shards[i], cache->lock);
+    }
+    free(cache->shards);
+}
+
+// Create a sharded cache of the named policy; returns NULL if the name is
+// unknown or the configuration is invalid
+ShardedCache* sharded_cache_create(const char* policy, const ShardedCacheConfig* config) {
+    const CacheOps* ops = policy && config ? cache_policy_find(policy) : NULL;
+    if (!ops || config->shards <= 0 || config->capacity < config->shards ||
+        config->lock < SHARD_LOCK_SPIN || config->lock > SHARD_LOCK_RWLOCK) {
+        return NULL;
+    }
+
+    uint32_t count = 1;
+    while (count < (uint32_t)config->shards) {
+        count <<= 1;
+    }
+    if (count > (uint32_t)config->capacity) {
+        count >>= 1;    // Keep at least one entry per shard
+    }
+
+    ShardedCache* cache = (ShardedCache*)malloc(sizeof(ShardedCache));
+    if (!cache) {
+        return NULL;
+    }
+
+    void* memory;
+    if (posix_memalign(&memory, SHARD_ALIGN, count * sizeof(CacheShard)) != 0) {
+        free(cache);
+        return NULL;
+    }
+    cache->shards = (CacheShard*)memory;
+    cache->shard_mask = count - 1;
+    cache->lock = config->lock;
+    cache->shared_gets = config->lock == SHARD_LOCK_RWLOCK && ops->read_only_get;
+
+    // Split the capacity evenly, the first shards taking the remainder
+    for (uint32_t i = 0; i < count; i++) {
+        CacheShard* shard = &cache->shards[i];
+        CacheConfig shard_config = {
+            config->capacity / (int)count + ((int)i < config->capacity % (int)count),
+            config->sizing,
+            0
+        };
+
+        shard->cache = cache_create(policy, &shard_config);
+        if (!shard->cache || init_lock(shard, config->lock) != 0) {
+            cache_destroy(shard->cache);
+            destroy_shards(cache, i);
+            free(cache);
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+// Destroy the cache; no other thread may still be using it
+void sharded_cache_destroy(ShardedCache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    destroy_shards(cache, cache->shard_mask + 1);
+    free(cache);
+}
+
+// Get value from cache
+int sharded_cache_get(ShardedCache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    CacheShard* shard = shard_for(cache, key);
+    CacheHandle* handle = shard->cache;
+    int value;
+
+    if (cache->shared_gets) {
+        // Readers share the handle, so its counters are bumped atomically
+        pthread_rwlock_rdlock(&shard->lock.rwlock);
+        value = handle->ops->get(handle->cache, key);
+        __atomic_fetch_add(value == -1 ? &handle->stats.misses : &handle->stats.hits, 1,
+                           __ATOMIC_RELAXED);
+        pthread_rwlock_unlock(&shard->lock.rwlock);
+        return value;
+    }
+
+    lock_exclusive(cache, shard);
+    value = cache_get(handle, key);
+    unlock(cache, shard);
+    return value;
+}
+
+// Put value in cache
+void sharded_cache_put(ShardedCache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    CacheShard* shard = shard_for(cache, key);
+    lock_exclusive(cache, shard);
+    cache_put(shard->cache, key, value);
+    unlock(cache, shard);
+}
+
+// Remove key from the cache; returns -1 if it was not cached
+int sharded_cache_erase(ShardedCache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    CacheShard* shard = shard_for(cache, key);
+    lock_exclusive(cache, shard);
+    int result = cache_erase(shard->cache, key);
+    unlock(cache, shard);
+    return result;
+}
+
+// Sum every shard's counters. Each shard is read under its lock, but the
+// total is not a snapshot of one instant while other threads are running
+void sharded_cache_get_stats(ShardedCache* cache, CacheStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    for (uint32_t i = 0; i <= cache->shard_mask; i++) {
+        CacheShard* shard = &cache->shards[i];
+        CacheStats part;
+
+        lock_exclusive(cache, shard);
+        cache_get_stats(shard->cache, &part);
+        unlock(cache, shard);
+
+        stats->hits += part.hits;
+        stats->misses += part.misses;
+        stats->puts += part.puts;
+        stats->erases += part.erases;
+        stats->evictions += part.evictions;
+        stats->size += part.size;
+        stats->capacity += part.capacity;
+    }
+}
+
+// Number of shards actually created
+int sharded_cache_shard_count(const ShardedCache* cache) {
+    return (int)cache->shard_mask + 1;
+}
@@ -0,0 +1,40 @@
+#ifndef SHARDED_CACHE_H
+#define SHARDED_CACHE_H
+
+#include "cache_registry.h"
+
+// Thread-safe front end for any registered policy.
+//
+// Keys are hash-partitioned across a power-of-two number of shards, each
+// holding its own instance of the backend and its own lock, so threads
+// working on different shards never contend. Every shard starts on its
+// own cache line. Gets take a reader-writer lock in shared mode only for
+// policies whose get changes nothing (see CACHE_POLICIES); for the rest a
+// get reorders the policy's state and takes the lock exclusively.
+
+// Lock protecting each shard
+typedef enum {
+    SHARD_LOCK_SPIN,        // Test-and-test-and-set, yielding after a while
+    SHARD_LOCK_MUTEX,
+    SHARD_LOCK_RWLOCK
+} ShardLockKind;
+
+// Settings for sharded_cache_create
+typedef struct ShardedCacheConfig {
+    int capacity;           // Total, split evenly across the shards
+    int shards;             // Rounded up to a power of two, at most the capacity
+    ShardLockKind lock;
+    CacheIndexSizing sizing;
+} ShardedCacheConfig;
+
+typedef struct ShardedCache ShardedCache;
+
+ShardedCache* sharded_cache_create(const char* policy, const ShardedCacheConfig* config);
+void sharded_cache_destroy(ShardedCache* cache);
+int sharded_cache_get(ShardedCache* cache, int key);
+void sharded_cache_put(ShardedCache* cache, int key, int value);
+int sharded_cache_erase(ShardedCache* cache, int key);
+void sharded_cache_get_stats(ShardedCache* cache, CacheStats* stats);
+int sharded_cache_shard_count(const ShardedCache* cache);
+
+#endif // SHARDED_CACHE_H 
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "twoq_cache.h"
+#include "cache_batch.h"
+#include "cache_index.h"
+#include "node_arena.h"
+#include <limits.h>
+#include <string.h>
+
+// 2Q, full version (Johnson & Shasha, VLDB '94). New keys enter A1in, a
+// FIFO that absorbs correlated references: a hit there changes nothing.
+// Keys pushed out of A1in are remembered in A1out, a FIFO of bare keys,
+// and only a key seen again while in A1out is admitted to Am, an LRU list.
+// Room is made from A1in while it is over its share of the capacity, and
+// from the LRU end of Am otherwise; Am evictions leave no ghost.
+//
+// As in s3fifo_cache.c, A1in and A1out are ring buffers (of node handles
+// and of keys). Am links its nodes by handle. A key readmitted from A1out
+// keeps its ring slot until the ring wraps over it. An entry erased from
+// A1in leaves a hole that evictions skip. A1in has a quarter of the
+// capacity in spare slots, so it only fills up with holes, and is
+// compacted before the next push, after that many erases; erase stays
+// amortized O(1).
+
+#define TWOQ_IN_PERCENT 25                  // Kin, % of the capacity
+#define TWOQ_OUT_PERCENT 50                 // Kout, % of the capacity
+#define TWOQ_GHOST ((uint32_t)1 << 31)      // Index handle flag for A1out keys
+#define TWOQ_MAIN ((uint32_t)1 << 30)       // Index handle flag for Am entries
+#define TWOQ_HANDLE_MASK (TWOQ_MAIN - 1)
+#define TWOQ_HOLE UINT32_MAX                // A1in slot of an erased entry
+
+// Node structure
+typedef struct TwoQNode {
+    int key;
+    int value;
+    uint32_t prev;      // Am link, or the ring position while in A1in
+    uint32_t next;
+} TwoQNode;
+
+// Ring buffer of 32-bit handles or keys
+typedef struct TwoQQueue {
+    uint32_t* slots;
+    uint32_t head;      // Oldest
+    uint32_t size;      // Including holes
+    uint32_t holes;
+    uint32_t capacity;
+} TwoQQueue;
+
+// Cache structure
+struct Cache {
+    CacheIndex index;       // Resident keys, and A1out keys flagged TWOQ_GHOST
+    NodeArena nodes;
+    TwoQQueue in;           // A1in
+    TwoQQueue out;          // A1out
+    uint32_t main_head;     // Am, most recently used
+    uint32_t main_tail;     // Am, least recently used
+    int in_target;          // Kin
+    uint32_t out_limit;     // Kout, at most A1out's ring size
+    uint64_t evictions;
+    int size;
+    int capacity;
+};
+
+static int queue_init(TwoQQueue* queue, uint32_t capacity) {
+    queue->slots = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    queue->head = 0;
+    queue->size = 0;
+    queue->holes = 0;
+    queue->capacity = capacity;
+    return queue->slots ? 0 : -1;
+}
+
+// Append at the tail; returns the ring position used
+static uint32_t queue_push(TwoQQueue* queue, uint32_t item) {
+    uint32_t pos = (queue->head + queue->size) % queue->capacity;
+    queue->slots[pos] = item;
+    queue->size++;
+    return pos;
+}
+
+// Remove and return the oldest item
+static uint32_t queue_pop(TwoQQueue* queue) {
+    uint32_t item = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->size--;
+    return item;
+}
+
+static TwoQNode* node_at(Cache* cache, uint32_t handle) {
+    return (TwoQNode*)node_arena_at(&cache->nodes, handle);
+}
+
+// Append a node to A1in, first closing up any holes if the ring is full
+static void in_push(Cache* cache, uint32_t handle) {
+    TwoQQueue* in = &cache->in;
+
+    if (in->size == in->capacity) {
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < in->size; i++) {
+            uint32_t h = in->slots[(in->head + i) % in->capacity];
+            if (h != TWOQ_HOLE) {
+                uint32_t pos = (in->head + live++) % in->capacity;
+                in->slots[pos] = h;
+                node_at(cache, h)->prev = pos;
+            }
+        }
+        in->size = live;
+        in->holes = 0;
+    }
+    node_at(cache, handle)->prev = queue_push(in, handle);
+}
+
+// Remove and return the oldest entry of A1in, skipping holes
+static uint32_t in_pop(Cache* cache) {
+    for (;;) {
+        uint32_t handle = queue_pop(&cache->in);
+        if (handle != TWOQ_HOLE) {
+            return handle;
+        }
+        cache->in.holes--;
+    }
+}
+
+// Add node to the front of Am
+static void main_push_front(Cache* cache, TwoQNode* node, uint32_t handle) {
+    node->prev = NODE_ARENA_NONE;
+    node->next = cache->main_head;
+
+    if (cache->main_head != NODE_ARENA_NONE) {
+        node_at(cache, cache->main_head)->prev = handle;
+    } else {
+        cache->main_tail = handle;
+    }
+    cache->main_head = handle;
+}
+
+// Remove node from Am
+static void main_unlink(Cache* cache, TwoQNode* node) {
+    if (node->prev != NODE_ARENA_NONE) {
+        node_at(cache, node->prev)->next = node->next;
+    } else {
+        cache->main_head = node->next;
+    }
+
+    if (node->next != NODE_ARENA_NONE) {
+        node_at(cache, node->next)->prev = node->prev;
+    } else {
+        cache->main_tail = node->prev;
+    }
+}
+
+// Forget the oldest key in A1out. Only a still-current ghost is dropped
+// from the index
+static void drop_ghost(Cache* cache) {
+    TwoQQueue* out = &cache->out;
+    uint32_t pos = out->head;
+    int old = (int)queue_pop(out);
+
+    if (cache_index_find(&cache->index, old) == (TWOQ_GHOST | pos)) {
+        cache_index_remove(&cache->index, old);
+    }
+}
+
+// Remember a key pushed out of A1in, forgetting the oldest if A1out is full
+static void add_ghost(Cache* cache, int key) {
+    TwoQQueue* out = &cache->out;
+
+    while (out->size >= cache->out_limit) {
+        drop_ghost(cache);
+    }
+
+    uint32_t pos = queue_push(out, (uint32_t)key);
+    cache_index_update(&cache->index, key, TWOQ_GHOST | pos);
+}
+
+// Make room for one entry: from A1in while it is over Kin (or Am is
+// empty), otherwise from the LRU end of Am
+static void evict(Cache* cache) {
+    if ((int)(cache->in.size - cache->in.holes) > cache->in_target ||
+        cache->main_tail == NODE_ARENA_NONE) {
+        TwoQNode* node = node_at(cache, in_pop(cache));
+        int key = node->key;
+        node_arena_free(&cache->nodes, node);
+        add_ghost(cache, key);
+    } else {
+        TwoQNode* node = node_at(cache, cache->main_tail);
+        main_unlink(cache, node);
+        cache_index_remove(&cache->index, node->key);
+        node_arena_free(&cache->nodes, node);
+    }
+    cache->size--;
+    cache->evictions++;
+}
+
+// Set the capacity, Kin and Kout
+static void size_queues(Cache* cache, int capacity) {
+    int in_target = (int)((long long)capacity * TWOQ_IN_PERCENT / 100);
+    int out_limit = (int)((long long)capacity * TWOQ_OUT_PERCENT / 100);
+
+    cache->in_target = in_target > 0 ? in_target : 1;
+    cache->out_limit = out_limit > 0 ? (uint32_t)out_limit : 1;
+    cache->capacity = capacity;
+}
+
+// Create a new cache
+Cache* create_twoq_cache(int capacity) {
+    return create_twoq_cache_sized(capacity, CACHE_INDEX_PRESIZED);
+}
+
+// Create a new cache with the given index sizing mode
+Cache* create_twoq_cache_sized(int capacity, CacheIndexSizing sizing) {
+    if (capacity <= 0 || capacity > INT_MAX / 2) {
+        return NULL;
+    }
+
+    Cache* cache = (Cache*)malloc(sizeof(Cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    size_queues(cache, capacity);
+
+    // The index holds resident keys plus every A1out key
+    if (cache_index_init(&cache->index, capacity + (int)cache->out_limit, sizing) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(TwoQNode), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    // A1in can hold every entry until the first key reaches Am, plus the
+    // spare slots for holes
+    if (queue_init(&cache->in, (uint32_t)capacity + (uint32_t)capacity / 4 + 1) != 0 ||
+        queue_init(&cache->out, cache->out_limit) != 0) {
+        free(cache->in.slots);
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
+
+    cache->main_head = NODE_ARENA_NONE;
+    cache->main_tail = NODE_ARENA_NONE;
+    cache->evictions = 0;
+    cache->size = 0;
+
+    return cache;
+}
+
+// Destroy the cache
+void destroy_twoq_cache(Cache* cache) {
+    if (!cache) {
+        return;
+    }
+
+    free(cache->out.slots);
+    free(cache->in.slots);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
+    free(cache);
+}
+
+// Get value from cache
+int get_twoq(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & TWOQ_GHOST)) {
+        return -1;  // Key not found (A1out holds no values)
+    }
+
+    TwoQNode* node = node_at(cache, handle & TWOQ_HANDLE_MASK);
+    if ((handle & TWOQ_MAIN) && cache->main_head != (handle & TWOQ_HANDLE_MASK)) {
+        main_unlink(cache, node);
+        main_push_front(cache, node, handle & TWOQ_HANDLE_MASK);
+    }
+    return node->value;
+}
+
+// Put value in cache
+void put_twoq(Cache* cache, int key, int value) {
+    if (!cache) {
+        return;
+    }
+
+    // Check if key exists; an update counts as a hit
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle != CACHE_INDEX_NONE && !(handle & TWOQ_GHOST)) {
+        get_twoq(cache, key);
+        node_at(cache, handle & TWOQ_HANDLE_MASK)->value = value;
+        return;
+    }
+    int was_ghost = handle != CACHE_INDEX_NONE;
+
+    if (cache->size >= cache->capacity) {
+        evict(cache);
+    }
+
+    TwoQNode* node = (TwoQNode*)node_arena_alloc(&cache->nodes);
+    if (!node) {
+        return;
+    }
+    node->key = key;
+    node->value = value;
+    handle = node_arena_handle(&cache->nodes, node);
+    uint32_t tagged = was_ghost ? (TWOQ_MAIN | handle) : handle;
+
+    // Evicting may have pushed the key's own ghost out of A1out
+    if ((!was_ghost || cache_index_update(&cache->index, key, tagged) != 0) &&
+        cache_index_insert(&cache->index, key, tagged) != 0) {
+        node_arena_free(&cache->nodes, node);
+        return;
+    }
+
+    if (was_ghost) {
+        main_push_front(cache, node, handle);
+    } else {
+        in_push(cache, handle);
+    }
+    cache->size++;
+}
+
+// Batched get and put (see cache_batch.h)
+CACHE_BATCH_DEFINE(twoq, nodes, TWOQ_HANDLE_MASK, TWOQ_GHOST)
+
+// Remove key from the cache; returns -1 if it was not cached
+int erase_twoq(Cache* cache, int key) {
+    if (!cache) {
+        return -1;
+    }
+
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE || (handle & TWOQ_GHOST)) {
+        return -1;
+    }
+
+    TwoQNode* node = node_at(cache, handle & TWOQ_HANDLE_MASK);
+    if (handle & TWOQ_MAIN) {
+        main_unlink(cache, node);
+    } else {
+        cache->in.slots[node->prev] = TWOQ_HOLE;
+        cache->in.holes++;
+    }
+    cache_index_remove(&cache->index, key);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
+    return 0;
+}
+
+// Evict the entry a new key would displace; returns -1 if the cache is empty
+int evict_twoq(Cache* cache) {
+    if (!cache || cache->size == 0) {
+        return -1;
+    }
+
+    evict(cache);
+    return 0;
+}
+
+// Change the capacity, up to the one the cache was created with; returns
+// -1 if it is out of range. Kin and Kout scale with it, entries are
+// evicted as a put would evict them until the cache fits, and the oldest
+// keys in A1out are forgotten until it fits Kout
+int resize_twoq(Cache* cache, int capacity) {
+    if (!cache || capacity <= 0 || (uint32_t)capacity > cache->nodes.capacity) {
+        return -1;
+    }
+
+    size_queues(cache, capacity);
+    while (cache->size > capacity) {
+        evict(cache);
+    }
+    while (cache->out.size > cache->out_limit) {
+        drop_ghost(cache);
+    }
+    return 0;
+}
+
+// Report size, capacity and evictions
+void get_twoq_stats(Cache* cache, CacheStats* stats) {
+    stats->size = cache->size;
+    stats->capacity = cache->capacity;
+    stats->evictions = cache->evictions;
+}
+
+// Print cache contents
+void print_twoq_cache_contents(Cache* cache, const char* message) {
+    printf("\n%s:\n", message);
+    printf("Cache contents (A1in oldest first, then Am most recent first):\n");
+    printf("------------------------------------------------\n");
+    printf("Key\tValue\tQueue\n");
+    printf("------------------------------------------------\n");
+
+    for (uint32_t i = 0; i < cache->in.size; i++) {
+        uint32_t handle = cache->in.slots[(cache->in.head + i) % cache->in.capacity];
+        if (handle == TWOQ_HOLE) {
+            continue;
+        }
+        TwoQNode* current = node_at(cache, handle);
+        printf("%d\t%d\tA1in\n", current->key, current->value);
+    }
+    for (uint32_t h = cache->main_head; h != NODE_ARENA_NONE; h = node_at(cache, h)->next) {
+        TwoQNode* current = node_at(cache, h);
+        printf("%d\t%d\tAm\n", current->key, current->value);
+    }
+    printf("------------------------------------------------\n");
+    printf("Cache size: %d/%d (A1in target %d, A1out %u/%u)\n",
+           cache->size, cache->capacity, cache->in_target,
+           cache->out.size, cache->out.capacity);
+}
@@ -0,0 +1,21 @@
+#ifndef TWOQ_CACHE_H
+#define TWOQ_CACHE_H
+
+#include "cache_interface.h"
+
+Cache* create_twoq_cache(int capacity);
+Cache* create_twoq_cache_sized(int capacity, CacheIndexSizing sizing);
+void destroy_twoq_cache(Cache* cache);
+int get_twoq(Cache* cache, int key);
+void put_twoq(Cache* cache, int key, int value);
+void get_many_twoq(Cache* cache, const int* keys, int* values, int count);
+void put_many_twoq(Cache* cache, const int* keys, const int* values, int count);
+int erase_twoq(Cache* cache, int key);
+int evict_twoq(Cache* cache);
+int resize_twoq(Cache* cache, int capacity);
+void get_twoq_stats(Cache* cache, CacheStats* stats);
+void print_twoq_cache_contents(Cache* cache, const char* message);
+
+// 2Q specific declarations can be added here if needed
+
+#endif // TWOQ_CACHE_H 
\ No newline at end of file
@@ -1,14 +1,9 @@
 #include "cache_replacement.h"
 #include <string.h>
 
-// Hash function
-static unsigned int hash(int key) {
-    return (unsigned int)key % HASH_SIZE;
-}
-
 // Create a new LRU node
 static LRUNode* create_node(int key, int value, Cache* cache) {
-    LRUNode* node = (LRUNode*)malloc(sizeof(LRUNode));
+    LRUNode* node = (LRUNode*)node_arena_alloc(&cache->nodes);
     if (node) {
         node->key = key;
         node->value = value;
@@ -20,20 +15,14 @@ static LRUNode* create_node(int key, int value, Cache* cache) {
     return node;
 }
 
-// Create a new hash entry
-static HashEntry* create_hash_entry(int key, LRUNode* node) {
-    HashEntry* entry = (HashEntry*)malloc(sizeof(HashEntry));
-    if (entry) {
-        entry->key = key;
-        entry->node = node;
-        entry->next = NULL;
-    }
-    return entry;
+// Node for a handle
+static LRUNode* node_at(Cache* cache, uint32_t handle) {
+    return (LRUNode*)node_arena_at(&cache->nodes, handle);
 }
 
-// Create a new cache with specified capacity
-Cache* create_cache(int capacity) {
-    if (capacity <= 0 || capacity > MAX_CACHE_SIZE) {
+// Create a new cache with specified capacity and replacement policy
+Cache* create_cache(int capacity, const ReplacementPolicy* policy) {
+    if (capacity <= 0 || capacity > MAX_CACHE_SIZE || !policy) {
         return NULL;
     }
 
@@ -42,8 +31,13 @@ Cache* create_cache(int capacity) {
         return NULL;
     }
 
-    cache->hash_table = (HashEntry**)calloc(HASH_SIZE, sizeof(HashEntry*));
-    if (!cache->hash_table) {
+    if (cache_index_init(&cache->index, capacity, CACHE_INDEX_PRESIZED) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    if (node_arena_init(&cache->nodes, sizeof(LRUNode), (uint32_t)capacity) != 0) {
+        cache_index_destroy(&cache->index);
         free(cache);
         return NULL;
     }
@@ -53,36 +47,38 @@ Cache* create_cache(int capacity) {
     cache->size = 0;
     cache->capacity = capacity;
     cache->current_time = 0;
-    cache->replacement_policy = NULL;
+    cache->policy = policy;
+    cache->policy_data = NULL;
+    cache_rng_seed(&cache->rng, CACHE_RNG_DEFAULT_SEED, 0);
+
+    if (policy->init && policy->init(cache) != 0) {
+        node_arena_destroy(&cache->nodes);
+        cache_index_destroy(&cache->index);
+        free(cache);
+        return NULL;
+    }
 
     return cache;
 }
 
+// Reseed the generator the random policy picks victims with
+void seed_cache(Cache* cache, uint64_t seed) {
+    if (cache) {
+        cache_rng_seed(&cache->rng, seed, 0);
+    }
+}
+
 // Destroy the cache and free memory
 void destroy_cache(Cache* cache) {
     if (!cache) {
         return;
     }
 
-    // Free all nodes in the linked list
-    LRUNode* current = cache->head;
-    while (current) {
-        LRUNode* next = current->next;
-        free(current);
-        current = next;
-    }
-
-    // Free all hash entries
-    for (int i = 0; i < HASH_SIZE; i++) {
-        HashEntry* entry = cache->hash_table[i];
-        while (entry) {
-            HashEntry* next = entry->next;
-            free(entry);
-            entry = next;
-        }
+    if (cache->policy->destroy) {
+        cache->policy->destroy(cache);
     }
-
-    free(cache->hash_table);
+    node_arena_destroy(&cache->nodes);
+    cache_index_destroy(&cache->index);
     free(cache);
 }
 
@@ -122,33 +118,21 @@ static void move_to_front(Cache* cache, LRUNode* node) {
     add_to_front(cache, node);
 }
 
-// Remove entry from hash table
-static void remove_from_hash(Cache* cache, int key) {
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    HashEntry* prev = NULL;
-
-    while (entry) {
-        if (entry->key == key) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                cache->hash_table[h] = entry->next;
-            }
-            free(entry);
-            return;
-        }
-        prev = entry;
-        entry = entry->next;
-    }
+// Count an access to a cached node
+static void hit_node(Cache* cache, uint32_t handle) {
+    node_at(cache, handle)->frequency++;
+    cache->policy->on_hit(cache, handle);
 }
 
-// Add entry to hash table
-static void add_to_hash(Cache* cache, int key, LRUNode* node) {
-    unsigned int h = hash(key);
-    HashEntry* entry = create_hash_entry(key, node);
-    entry->next = cache->hash_table[h];
-    cache->hash_table[h] = entry;
+// Drop a node from the policy, the index and the list
+static void remove_entry(Cache* cache, uint32_t handle) {
+    LRUNode* node = node_at(cache, handle);
+
+    cache->policy->on_remove(cache, handle);
+    cache_index_remove(&cache->index, node->key);
+    remove_node(cache, node);
+    node_arena_free(&cache->nodes, node);
+    cache->size--;
 }
 
 // Get value for a key from cache
@@ -157,46 +141,35 @@ int get(Cache* cache, int key) {
         return -1;
     }
 
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            // Update frequency for LFU
-            entry->node->frequency++;
-            // Move to front only if using LRU policy
-            if (cache->replacement_policy == lru_policy) {
-                move_to_front(cache, entry->node);
-            }
-            return entry->node->value;
-        }
-        entry = entry->next;
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle == CACHE_INDEX_NONE) {
+        return -1;  // Key not found
     }
-    
-    return -1;  // Key not found
+
+    hit_node(cache, handle);
+    return node_at(cache, handle)->value;
 }
 
 // Put a key-value pair in the cache
 void put(Cache* cache, int key, int value) {
-    if (!cache || !cache->replacement_policy) {
+    if (!cache) {
         return;
     }
 
     // Check if key exists
-    unsigned int h = hash(key);
-    HashEntry* entry = cache->hash_table[h];
-    
-    while (entry) {
-        if (entry->key == key) {
-            entry->node->value = value;
-            entry->node->frequency++;
-            // Move to front only if using LRU policy
-            if (cache->replacement_policy == lru_policy) {
-                move_to_front(cache, entry->node);
-            }
-            return;
+    uint32_t handle = cache_index_find(&cache->index, key);
+    if (handle != CACHE_INDEX_NONE) {
+        node_at(cache, handle)->value = value;
+        hit_node(cache, handle);
+        return;
+    }
+
+    // If cache is full, remove the node the policy picks
+    if (cache->size >= cache->capacity) {
+        uint32_t victim = cache->policy->pick_victim(cache);
+        if (victim != NODE_ARENA_NONE) {
+            remove_entry(cache, victim);
         }
-        entry = entry->next;
     }
 
     // Create new node
@@ -205,107 +178,228 @@ void put(Cache* cache, int key, int value) {
         return;
     }
 
-    // If cache is full, remove entry based on policy
-    if (cache->size >= cache->capacity) {
-        int remove_key = cache->replacement_policy(cache);
-        if (remove_key != -1) {
-            // Find and remove the node
-            entry = cache->hash_table[hash(remove_key)];
-            while (entry && entry->key != remove_key) {
-                entry = entry->next;
-            }
-            if (entry) {
-                remove_node(cache, entry->node);
-                remove_from_hash(cache, remove_key);
-                free(entry->node);
-                cache->size--;
-            }
-        }
-    }
-
     // Add new node
+    handle = node_arena_handle(&cache->nodes, new_node);
+    if (cache_index_insert(&cache->index, key, handle) != 0) {
+        node_arena_free(&cache->nodes, new_node);
+        return;
+    }
     add_to_front(cache, new_node);
-    add_to_hash(cache, key, new_node);
     cache->size++;
+    cache->policy->on_insert(cache, handle);
 }
 
-// LRU replacement policy
-int lru_policy(Cache* cache) {
-    if (!cache || !cache->tail) {
-        return -1;
+// Hook for events a policy doesn't track
+static void ignore_node(Cache* cache, uint32_t handle) {
+    (void)cache;
+    (void)handle;
+}
+
+// Tail of the list, the oldest insertion or least recently used node
+static uint32_t list_tail(Cache* cache) {
+    if (!cache->tail) {
+        return NODE_ARENA_NONE;
     }
-    return cache->tail->key;
+    return node_arena_handle(&cache->nodes, cache->tail);
+}
+
+// LRU: hits move the node to the front, so the tail is the victim
+static void lru_on_hit(Cache* cache, uint32_t handle) {
+    move_to_front(cache, node_at(cache, handle));
+}
+
+const ReplacementPolicy lru_policy = {
+    "LRU", NULL, NULL, ignore_node, lru_on_hit, ignore_node, list_tail
+};
+
+// LFU: every node sits in the bucket for its frequency, least recently
+// used last, and buckets are linked in order of frequency, so the victim
+// is the tail of the first bucket. Links are kept per node handle.
+typedef struct LFUBucket {
+    int frequency;
+    uint32_t head;          // Most recently used
+    uint32_t tail;          // Least recently used
+    uint32_t prev;
+    uint32_t next;
+} LFUBucket;
+
+typedef struct LFULinks {
+    uint32_t bucket;
+    uint32_t prev;
+    uint32_t next;
+} LFULinks;
+
+typedef struct LFUData {
+    LFULinks* links;        // Indexed by node handle
+    NodeArena buckets;      // At most capacity + 1 buckets are ever live
+    uint32_t min_bucket;    // Lowest frequency, head of the bucket list
+} LFUData;
+
+static LFUData* lfu_data(Cache* cache) {
+    return (LFUData*)cache->policy_data;
 }
 
-// LFU replacement policy
-int lfu_policy(Cache* cache) {
-    if (!cache || !cache->head) {
+static LFUBucket* bucket_at(LFUData* data, uint32_t handle) {
+    return (LFUBucket*)node_arena_at(&data->buckets, handle);
+}
+
+static int lfu_init(Cache* cache) {
+    LFUData* data = (LFUData*)malloc(sizeof(LFUData));
+    if (!data) {
         return -1;
     }
 
-    LRUNode* current = cache->head;
-    LRUNode* min_freq_node = current;
-    int min_freq = current->frequency;
-
-    while (current) {
-        if (current->frequency < min_freq) {
-            min_freq = current->frequency;
-            min_freq_node = current;
-        }
-        current = current->next;
+    data->links = (LFULinks*)malloc((size_t)cache->capacity * sizeof(LFULinks));
+    if (!data->links ||
+        node_arena_init(&data->buckets, sizeof(LFUBucket), (uint32_t)cache->capacity + 1) != 0) {
+        free(data->links);
+        free(data);
+        return -1;
     }
+    data->min_bucket = NODE_ARENA_NONE;
+    cache->policy_data = data;
+    return 0;
+}
+
+static void lfu_destroy(Cache* cache) {
+    LFUData* data = lfu_data(cache);
 
-    return min_freq_node->key;
+    node_arena_destroy(&data->buckets);
+    free(data->links);
+    free(data);
 }
 
-// FIFO replacement policy
-int fifo_policy(Cache* cache) {
-    if (!cache || !cache->head) {
-        return -1;
+// Create an empty bucket and link it after prev (or first if prev is none)
+static uint32_t insert_bucket_after(LFUData* data, uint32_t prev, int frequency) {
+    LFUBucket* bucket = (LFUBucket*)node_arena_alloc(&data->buckets);
+    uint32_t handle = node_arena_handle(&data->buckets, bucket);
+
+    bucket->frequency = frequency;
+    bucket->head = NODE_ARENA_NONE;
+    bucket->tail = NODE_ARENA_NONE;
+    bucket->prev = prev;
+    bucket->next = prev != NODE_ARENA_NONE ? bucket_at(data, prev)->next : data->min_bucket;
+
+    if (bucket->next != NODE_ARENA_NONE) {
+        bucket_at(data, bucket->next)->prev = handle;
     }
+    if (prev != NODE_ARENA_NONE) {
+        bucket_at(data, prev)->next = handle;
+    } else {
+        data->min_bucket = handle;
+    }
+    return handle;
+}
 
-    LRUNode* current = cache->head;
-    LRUNode* oldest_node = current;
-    int min_time = current->time_added;
+// Put a node at the front of a bucket
+static void bucket_push(LFUData* data, uint32_t bucket_handle, uint32_t handle) {
+    LFUBucket* bucket = bucket_at(data, bucket_handle);
+    LFULinks* links = &data->links[handle];
 
-    while (current) {
-        if (current->time_added < min_time) {
-            min_time = current->time_added;
-            oldest_node = current;
-        }
-        current = current->next;
+    links->bucket = bucket_handle;
+    links->prev = NODE_ARENA_NONE;
+    links->next = bucket->head;
+    if (bucket->head != NODE_ARENA_NONE) {
+        data->links[bucket->head].prev = handle;
+    } else {
+        bucket->tail = handle;
+    }
+    bucket->head = handle;
+}
+
+// Take a node out of its bucket, freeing the bucket once empty; returns
+// the bucket if it is still live, else its predecessor
+static uint32_t bucket_unlink(LFUData* data, uint32_t handle) {
+    LFULinks* links = &data->links[handle];
+    uint32_t bucket_handle = links->bucket;
+    LFUBucket* bucket = bucket_at(data, bucket_handle);
+
+    if (links->prev != NODE_ARENA_NONE) {
+        data->links[links->prev].next = links->next;
+    } else {
+        bucket->head = links->next;
+    }
+    if (links->next != NODE_ARENA_NONE) {
+        data->links[links->next].prev = links->prev;
+    } else {
+        bucket->tail = links->prev;
     }
 
-    return oldest_node->key;
+    if (bucket->head != NODE_ARENA_NONE) {
+        return bucket_handle;
+    }
+
+    uint32_t prev = bucket->prev;
+    if (prev != NODE_ARENA_NONE) {
+        bucket_at(data, prev)->next = bucket->next;
+    } else {
+        data->min_bucket = bucket->next;
+    }
+    if (bucket->next != NODE_ARENA_NONE) {
+        bucket_at(data, bucket->next)->prev = prev;
+    }
+    node_arena_free(&data->buckets, bucket);
+    return prev;
 }
 
-// Random replacement policy
-int random_policy(Cache* cache) {
-    if (!cache || !cache->head) {
-        return -1;
+static void lfu_on_insert(Cache* cache, uint32_t handle) {
+    LFUData* data = lfu_data(cache);
+    uint32_t first = data->min_bucket;
+
+    if (first == NODE_ARENA_NONE || bucket_at(data, first)->frequency != 1) {
+        first = insert_bucket_after(data, NODE_ARENA_NONE, 1);
     }
+    bucket_push(data, first, handle);
+}
 
-    // Count total nodes
-    int count = 0;
-    LRUNode* current = cache->head;
-    while (current) {
-        count++;
-        current = current->next;
+// Move the node into the bucket for its new frequency
+static void lfu_on_hit(Cache* cache, uint32_t handle) {
+    LFUData* data = lfu_data(cache);
+    int frequency = node_at(cache, handle)->frequency;
+    uint32_t prev = bucket_unlink(data, handle);
+    uint32_t next = prev != NODE_ARENA_NONE ? bucket_at(data, prev)->next : data->min_bucket;
+
+    if (next == NODE_ARENA_NONE || bucket_at(data, next)->frequency != frequency) {
+        next = insert_bucket_after(data, prev, frequency);
     }
+    bucket_push(data, next, handle);
+}
 
-    // Select random position
-    int random_pos = rand() % count;
-    
-    // Find node at random position
-    current = cache->head;
-    while (random_pos > 0) {
-        current = current->next;
-        random_pos--;
+static void lfu_on_remove(Cache* cache, uint32_t handle) {
+    bucket_unlink(lfu_data(cache), handle);
+}
+
+static uint32_t lfu_pick_victim(Cache* cache) {
+    LFUData* data = lfu_data(cache);
+    if (data->min_bucket == NODE_ARENA_NONE) {
+        return NODE_ARENA_NONE;
     }
+    return bucket_at(data, data->min_bucket)->tail;
+}
 
-    return current->key;
+const ReplacementPolicy lfu_policy = {
+    "LFU", lfu_init, lfu_destroy, lfu_on_insert, lfu_on_hit, lfu_on_remove, lfu_pick_victim
+};
+
+// FIFO: new nodes go to the front and nothing reorders the list, so the
+// tail is always the oldest insertion
+const ReplacementPolicy fifo_policy = {
+    "FIFO", NULL, NULL, ignore_node, ignore_node, ignore_node, list_tail
+};
+
+// Random: eviction only happens once every arena node is live, so any
+// handle below the size is a valid uniformly chosen entry
+static uint32_t random_pick_victim(Cache* cache) {
+    if (cache->size == 0) {
+        return NODE_ARENA_NONE;
+    }
+    return cache_rng_below(&cache->rng, (uint32_t)cache->size);
 }
 
+const ReplacementPolicy random_policy = {
+    "Random", NULL, NULL, ignore_node, ignore_node, ignore_node, random_pick_victim
+};
+
 void print_cache_contents(Cache* cache, const char* message) {
     printf("\n%s:\n", message);
     printf("Cache contents (Most Recent → Least Recent):\n");
@@ -326,8 +420,8 @@ void print_cache_contents(Cache* cache, const char* message) {
     printf("Cache size: %d/%d\n", cache->size, cache->capacity);
 }
 
-void test_cache(Cache* cache, const char* policy_name) {
-    printf("\nTesting %s policy:\n", policy_name);
+void test_cache(Cache* cache) {
+    printf("\nTesting %s policy:\n", cache->policy->name);
     
     // Show initial empty cache state
     print_cache_contents(cache, "Initial cache state (empty)");
@@ -378,10 +472,16 @@ void display_menu() {
     printf("Enter your choice (1-6): ");
 }
 
+// Policies in menu order
+static const ReplacementPolicy* const policies[] = {
+    &lru_policy, &lfu_policy, &fifo_policy, &random_policy
+};
+
+#define POLICY_COUNT ((int)(sizeof(policies) / sizeof(policies[0])))
+
 void run_interactive_mode() {
     int choice;
     int capacity;
-    Cache* cache = NULL;
     
     printf("Enter cache capacity (1-%d): ", MAX_CACHE_SIZE);
     scanf("%d", &capacity);
@@ -395,77 +495,34 @@ void run_interactive_mode() {
         display_menu();
         scanf("%d", &choice);
         
-        if (choice == 6) {
-            if (cache) {
-                destroy_cache(cache);
-            }
+        if (choice == POLICY_COUNT + 2) {
             break;
         }
         
-        if (choice == 5) {
+        int first = choice - 1;
+        int last = choice - 1;
+        if (choice == POLICY_COUNT + 1) {
             // Run all policies
-            Cache* lru_cache = create_cache(capacity);
-            lru_cache->replacement_policy = lru_policy;
-            test_cache(lru_cache, "LRU");
-            destroy_cache(lru_cache);
-            
-            Cache* lfu_cache = create_cache(capacity);
-            lfu_cache->replacement_policy = lfu_policy;
-            test_cache(lfu_cache, "LFU");
-            destroy_cache(lfu_cache);
-            
-            Cache* fifo_cache = create_cache(capacity);
-            fifo_cache->replacement_policy = fifo_policy;
-            test_cache(fifo_cache, "FIFO");
-            destroy_cache(fifo_cache);
-            
-            Cache* random_cache = create_cache(capacity);
-            random_cache->replacement_policy = random_policy;
-            test_cache(random_cache, "Random");
-            destroy_cache(random_cache);
-            
+            first = 0;
+            last = POLICY_COUNT - 1;
+        } else if (choice < 1 || choice > POLICY_COUNT) {
+            printf("Invalid choice. Please try again.\n");
             continue;
         }
         
-        // Create new cache with selected policy
-        if (cache) {
+        for (int i = first; i <= last; i++) {
+            Cache* cache = create_cache(capacity, policies[i]);
+            if (!cache) {
+                printf("Failed to create cache. Exiting...\n");
+                return;
+            }
+            test_cache(cache);
             destroy_cache(cache);
         }
-        
-        cache = create_cache(capacity);
-        if (!cache) {
-            printf("Failed to create cache. Exiting...\n");
-            break;
-        }
-        
-        switch (choice) {
-            case 1:
-                cache->replacement_policy = lru_policy;
-                test_cache(cache, "LRU");
-                break;
-            case 2:
-                cache->replacement_policy = lfu_policy;
-                test_cache(cache, "LFU");
-                break;
-            case 3:
-                cache->replacement_policy = fifo_policy;
-                test_cache(cache, "FIFO");
-                break;
-            case 4:
-                cache->replacement_policy = random_policy;
-                test_cache(cache, "Random");
-                break;
-            default:
-                printf("Invalid choice. Please try again.\n");
-                break;
-        }
     }
 }
 
 int main() {
-    // Seed random number generator
-    srand(time(NULL));
-    
     printf("Welcome to Cache Replacement Policy Simulator\n");
     printf("===========================================\n");
     
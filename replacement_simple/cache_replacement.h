@@ -4,9 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include "../replacement_algorithms/cache_index.h"
+#include "../replacement_algorithms/node_arena.h"
+#include "../replacement_algorithms/cache_rng.h"
 
 #define MAX_CACHE_SIZE 100
-#define HASH_SIZE 1000  // Size of hash table, should be larger than cache size
+
+typedef struct Cache Cache;
 
 // Node structure for doubly linked list
 typedef struct LRUNode {
@@ -14,43 +18,55 @@ typedef struct LRUNode {
     int value;
     struct LRUNode* prev;
     struct LRUNode* next;
-    int frequency;      // For LFU policy
-    int time_added;     // For FIFO policy
+    int frequency;      // Accesses so far
+    int time_added;     // Insertion order
 } LRUNode;
 
-// Hash entry structure
-typedef struct HashEntry {
-    int key;
-    LRUNode* node;
-    struct HashEntry* next;  // For handling collisions
-} HashEntry;
+// Replacement policy. The cache calls the hooks with the handle of the
+// node an event concerns (its position in the node arena) and evicts the
+// node pick_victim returns, so a policy can keep its own structures in
+// policy_data and eviction needs no second lookup. init and destroy may
+// be NULL for policies without any state of their own
+typedef struct ReplacementPolicy {
+    const char* name;
+    int (*init)(Cache* cache);                      // Set up policy_data; 0 or -1
+    void (*destroy)(Cache* cache);
+    void (*on_insert)(Cache* cache, uint32_t handle);
+    void (*on_hit)(Cache* cache, uint32_t handle);
+    void (*on_remove)(Cache* cache, uint32_t handle);
+    uint32_t (*pick_victim)(Cache* cache);          // NODE_ARENA_NONE if empty
+} ReplacementPolicy;
 
 // Cache structure
-typedef struct Cache {
-    LRUNode* head;      // Most recently used
-    LRUNode* tail;      // Least recently used
-    HashEntry** hash_table;
+struct Cache {
+    LRUNode* head;      // Newest insertion, or most recently used under LRU
+    LRUNode* tail;
+    CacheIndex index;
+    NodeArena nodes;
     int size;
     int capacity;
     int current_time;   // For tracking insertion order
-    int (*replacement_policy)(struct Cache*);
-} Cache;
+    CacheRng rng;       // For random policy
+    const ReplacementPolicy* policy;
+    void* policy_data;
+};
 
 // Function declarations
-Cache* create_cache(int capacity);
+Cache* create_cache(int capacity, const ReplacementPolicy* policy);
 void destroy_cache(Cache* cache);
+void seed_cache(Cache* cache, uint64_t seed);
 int get(Cache* cache, int key);
 void put(Cache* cache, int key, int value);
 
-// Replacement policy functions
-int lru_policy(Cache* cache);
-int lfu_policy(Cache* cache);
-int fifo_policy(Cache* cache);
-int random_policy(Cache* cache);
+// Replacement policies
+extern const ReplacementPolicy lru_policy;
+extern const ReplacementPolicy lfu_policy;
+extern const ReplacementPolicy fifo_policy;
+extern const ReplacementPolicy random_policy;
 
 // Utility functions
 void print_cache_contents(Cache* cache, const char* message);
-void test_cache(Cache* cache, const char* policy_name);
+void test_cache(Cache* cache);
 void run_interactive_mode();
 void display_menu();
 
@@ -1,151 +1,317 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "replacement_algorithms/cache_interface.h"
+#include <math.h>
+#include "replacement_algorithms/cache_registry.h"
 
 #define CACHE_SIZE 3  // Fixed cache size to demonstrate replacement
 
+// Hit ratio comparison settings
+#define COMPARE_CAPACITY 100
+#define COMPARE_KEYS 1000
+#define COMPARE_OPS 100000
+#define COMPARE_ZIPF_KEYS 10000
+#define COMPARE_ZIPF_EXPONENT 0.9
+#define COMPARE_LOOP_KEYS 110       // Loop slightly larger than the cache
+#define COMPARE_SCAN_PERIOD 1200    // Accesses per hot phase plus scan
+#define COMPARE_SCAN_LENGTH 200     // New keys read by each scan
+#define COMPARE_SCAN_HOT_KEYS 80
+
 void print_menu() {
+    size_t count = cache_policy_count();
+
     printf("\nCache Replacement Algorithm Tester\n");
     printf("=================================\n");
-    printf("1. LRU (Least Recently Used)\n");
-    printf("2. LFU (Least Frequently Used)\n");
-    printf("3. FIFO (First In First Out)\n");
-    printf("4. Random Replacement\n");
-    printf("5. Run All Algorithms\n");
+    for (size_t i = 0; i < count; i++) {
+        const CacheOps* ops = cache_policy_at(i);
+        printf("%zu. %s (%s)\n", i + 1, ops->label, ops->description);
+    }
+    printf("%zu. Run All Algorithms\n", count + 1);
+    printf("%zu. Compare Hit Ratios\n", count + 2);
+    printf("%zu. Run Regression Checks\n", count + 3);
     printf("0. Exit\n");
     printf("Enter your choice: ");
 }
 
-void test_lru_cache(Cache* cache) {
-    printf("\n=== Testing LRU Cache ===\n");
-    put_lru(cache, 1, 100);
-    put_lru(cache, 2, 200);
-    put_lru(cache, 3, 300);
-    print_lru_cache_contents(cache, "After initial insertions (1,2,3)");
+// Walk one policy through a few puts, gets, an erase and an evict
+void test_cache(const CacheOps* ops) {
+    CacheConfig config = { CACHE_SIZE, CACHE_INDEX_PRESIZED, 0 };
+    CacheHandle* cache = cache_create(ops->name, &config);
+    if (!cache) {
+        printf("Could not create a %s cache\n", ops->label);
+        return;
+    }
+
+    printf("\n=== Testing %s Cache ===\n", ops->label);
+    cache_put(cache, 1, 100);
+    cache_put(cache, 2, 200);
+    cache_put(cache, 3, 300);
+    cache_print(cache, "After initial insertions (1,2,3)");
     
-    printf("Getting key 1: %d\n", get_lru(cache, 1));
-    printf("Getting key 2: %d\n", get_lru(cache, 2));
-    printf("Getting key 1 again: %d\n", get_lru(cache, 1));
-    print_lru_cache_contents(cache, "After accessing 1,2,1");
+    printf("Getting key 1: %d\n", cache_get(cache, 1));
+    printf("Getting key 2: %d\n", cache_get(cache, 2));
+    printf("Getting key 1 again: %d\n", cache_get(cache, 1));
+    cache_print(cache, "After accessing 1,2,1");
     
-    put_lru(cache, 4, 400);
-    print_lru_cache_contents(cache, "After adding 4 (might trigger replacement)");
+    cache_put(cache, 4, 400);
+    cache_print(cache, "After adding 4 (might trigger replacement)");
     
-    int result = get_lru(cache, 999);
+    int result = cache_get(cache, 999);
     printf("Getting non-existent key 999: %d\n", result);
-    printf("=== End of LRU Cache Test ===\n\n");
-}
-
-void test_lfu_cache(Cache* cache) {
-    printf("\n=== Testing LFU Cache ===\n");
-    put_lfu(cache, 1, 100);
-    put_lfu(cache, 2, 200);
-    put_lfu(cache, 3, 300);
-    print_lfu_cache_contents(cache, "After initial insertions (1,2,3)");
-    
-    printf("Getting key 1: %d\n", get_lfu(cache, 1));
-    printf("Getting key 2: %d\n", get_lfu(cache, 2));
-    printf("Getting key 1 again: %d\n", get_lfu(cache, 1));
-    print_lfu_cache_contents(cache, "After accessing 1,2,1");
     
-    put_lfu(cache, 4, 400);
-    print_lfu_cache_contents(cache, "After adding 4 (might trigger replacement)");
+    printf("Erasing key 1: %s\n", cache_erase(cache, 1) == 0 ? "erased" : "not cached");
+    cache_evict(cache);
+    cache_print(cache, "After erasing 1 and evicting one entry");
     
-    int result = get_lfu(cache, 999);
-    printf("Getting non-existent key 999: %d\n", result);
-    printf("=== End of LFU Cache Test ===\n\n");
+    CacheStats stats;
+    cache_get_stats(cache, &stats);
+    printf("Hits %llu, misses %llu, puts %llu, erases %llu, evictions %llu\n",
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           (unsigned long long)stats.puts, (unsigned long long)stats.erases,
+           (unsigned long long)stats.evictions);
+    printf("=== End of %s Cache Test ===\n\n", ops->label);
+    cache_destroy(cache);
 }
 
-void test_fifo_cache(Cache* cache) {
-    printf("\n=== Testing FIFO Cache ===\n");
-    put_fifo(cache, 1, 100);
-    put_fifo(cache, 2, 200);
-    put_fifo(cache, 3, 300);
-    print_fifo_cache_contents(cache, "After initial insertions (1,2,3)");
-    
-    printf("Getting key 1: %d\n", get_fifo(cache, 1));
-    printf("Getting key 2: %d\n", get_fifo(cache, 2));
-    printf("Getting key 1 again: %d\n", get_fifo(cache, 1));
-    print_fifo_cache_contents(cache, "After accessing 1,2,1");
-    
-    put_fifo(cache, 4, 400);
-    print_fifo_cache_contents(cache, "After adding 4 (might trigger replacement)");
-    
-    int result = get_fifo(cache, 999);
-    printf("Getting non-existent key 999: %d\n", result);
-    printf("=== End of FIFO Cache Test ===\n\n");
+// Next key of a fixed skewed workload: 80% of accesses go to the first 20%
+// of the key space
+static int next_hotspot_key(unsigned int* state, int i) {
+    (void)i;
+    *state = *state * 1103515245u + 12345u;
+    unsigned int r = *state >> 8;
+    if (r % 100 < 80) {
+        return (int)((r / 100) % (COMPARE_KEYS / 5));
+    }
+    return (int)((r / 100) % COMPARE_KEYS);
 }
 
-void test_random_cache(Cache* cache) {
-    printf("\n=== Testing Random Cache ===\n");
-    put_random(cache, 1, 100);
-    put_random(cache, 2, 200);
-    put_random(cache, 3, 300);
-    print_random_cache_contents(cache, "After initial insertions (1,2,3)");
-    
-    printf("Getting key 1: %d\n", get_random(cache, 1));
-    printf("Getting key 2: %d\n", get_random(cache, 2));
-    printf("Getting key 1 again: %d\n", get_random(cache, 1));
-    print_random_cache_contents(cache, "After accessing 1,2,1");
-    
-    put_random(cache, 4, 400);
-    print_random_cache_contents(cache, "After adding 4 (might trigger replacement)");
-    
-    int result = get_random(cache, 999);
-    printf("Getting non-existent key 999: %d\n", result);
-    printf("=== End of Random Cache Test ===\n\n");
+// Next key of a Zipf workload over COMPARE_ZIPF_KEYS keys: key k is drawn
+// with probability proportional to 1 / (k + 1)^COMPARE_ZIPF_EXPONENT
+static int next_zipf_key(unsigned int* state, int i) {
+    static double cdf[COMPARE_ZIPF_KEYS];
+    static int ready = 0;
+
+    (void)i;
+    if (!ready) {
+        double total = 0;
+        for (int k = 0; k < COMPARE_ZIPF_KEYS; k++) {
+            total += 1.0 / pow(k + 1, COMPARE_ZIPF_EXPONENT);
+            cdf[k] = total;
+        }
+        for (int k = 0; k < COMPARE_ZIPF_KEYS; k++) {
+            cdf[k] /= total;
+        }
+        ready = 1;
+    }
+
+    *state = *state * 1103515245u + 12345u;
+    double u = (double)(*state >> 8) / (double)(1u << 24);
+
+    int lo = 0, hi = COMPARE_ZIPF_KEYS - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Next key of a loop over COMPARE_LOOP_KEYS keys, which defeats recency:
+// every key is evicted just before it comes round again
+static int next_loop_key(unsigned int* state, int i) {
+    (void)state;
+    return i % COMPARE_LOOP_KEYS;
+}
+
+// Next key of a hot set that is interrupted by one-off sequential scans:
+// each period starts with COMPARE_SCAN_LENGTH keys never seen before,
+// followed by uniform accesses to COMPARE_SCAN_HOT_KEYS hot keys
+static int next_scan_key(unsigned int* state, int i) {
+    int phase = i % COMPARE_SCAN_PERIOD;
+
+    if (phase < COMPARE_SCAN_LENGTH) {
+        return COMPARE_ZIPF_KEYS + (i / COMPARE_SCAN_PERIOD) * COMPARE_SCAN_LENGTH + phase;
+    }
+    *state = *state * 1103515245u + 12345u;
+    return (int)((*state >> 8) % COMPARE_SCAN_HOT_KEYS);
+}
+
+// A key stream for the hit ratio comparison; i is the access number
+typedef struct {
+    const char* name;
+    const char* description;
+    int (*next_key)(unsigned int* state, int i);
+} Workload;
+
+static const Workload workloads[] = {
+    { "Hotspot", "80% of accesses to 20% of 1000 keys", next_hotspot_key },
+    { "Zipf", "Zipf 0.9 over 10000 keys", next_zipf_key },
+    { "Loop", "keys 0-109 in order, repeated", next_loop_key },
+    { "Scan", "80 hot keys, each 1200 accesses opening with a 200-key scan", next_scan_key },
+};
+
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(workloads[0]))
+
+// Hit ratio of one policy on one workload: get, and put on a miss
+static double measure_hit_ratio(const CacheOps* ops, const Workload* workload) {
+    CacheConfig config = { COMPARE_CAPACITY, CACHE_INDEX_PRESIZED, 0 };
+    CacheHandle* cache = cache_create(ops->name, &config);
+    unsigned int state = 42;
+
+    if (!cache) {
+        return -1;
+    }
+
+    for (int i = 0; i < COMPARE_OPS; i++) {
+        int key = workload->next_key(&state, i);
+        if (cache_get(cache, key) == -1) {
+            cache_put(cache, key, key);
+        }
+    }
+
+    CacheStats stats;
+    cache_get_stats(cache, &stats);
+    cache_destroy(cache);
+    return 100.0 * (double)stats.hits / COMPARE_OPS;
+}
+
+// Replay the same workloads against every policy
+void compare_hit_ratios(void) {
+    printf("\nHit ratios, capacity %d, %d accesses per workload:\n",
+           COMPARE_CAPACITY, COMPARE_OPS);
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+        printf("  %s: %s\n", workloads[w].name, workloads[w].description);
+    }
+    printf("------------------------------------------------\n");
+    printf("%-10s", "Policy");
+    for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+        printf("%10s", workloads[w].name);
+    }
+    printf("\n------------------------------------------------\n");
+
+    for (size_t p = 0; p < cache_policy_count(); p++) {
+        const CacheOps* ops = cache_policy_at(p);
+        printf("%-10s", ops->label);
+        for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+            double ratio = measure_hit_ratio(ops, &workloads[w]);
+            if (ratio < 0) {
+                printf("%10s", "failed");
+            } else {
+                printf("%9.2f%%", ratio);
+            }
+        }
+        printf("\n");
+    }
+    printf("------------------------------------------------\n");
+}
+
+// Report one check's outcome; returns 1 if it failed
+static int report_check(const char* name, int passed) {
+    printf("%-56s %s\n", name, passed ? "ok" : "FAILED");
+    return !passed;
+}
+
+// Keys among 0..count-1 that a get finds
+static int count_cached(CacheHandle* cache, int count) {
+    int found = 0;
+    for (int key = 0; key < count; key++) {
+        found += cache_get(cache, key) != -1;
+    }
+    return found;
+}
+
+// LIRS at capacity 2: erasing the only LIR entry used to let a hit push a
+// HIR entry to the bottom of the stack, after which an evicted key was
+// demoted into the resident queue. Every key a get finds must be counted
+// in the size, and evicting must empty the cache
+static int check_lirs_erase(void) {
+    CacheConfig config = { 2, CACHE_INDEX_PRESIZED, 0 };
+    CacheHandle* cache = cache_create("lirs", &config);
+    CacheStats stats;
+    int passed;
+
+    cache_put(cache, 0, 0);
+    cache_put(cache, 3, 3);
+    cache_erase(cache, 0);
+    cache_get(cache, 3);
+    cache_put(cache, 5, 5);
+    cache_evict(cache);
+    cache_erase(cache, 5);
+    cache_put(cache, 7, 7);
+    cache_put(cache, 8, 8);
+    cache_get(cache, 8);
+
+    cache_get_stats(cache, &stats);
+    passed = count_cached(cache, 10) == stats.size;
+    while (cache_evict(cache) == 0) {
+    }
+    cache_get_stats(cache, &stats);
+    passed = passed && stats.size == 0 && count_cached(cache, 10) == 0;
+    cache_destroy(cache);
+    return report_check("LIRS: erase, hit and evict keep the stack consistent", passed);
+}
+
+// Shrink a full cache whose newest keys were erased, then insert new keys:
+// the size must stay within the new capacity. W-TinyLFU used to keep an
+// oversized main region, and refill its window on top of it
+static int check_resize(const CacheOps* ops, int capacity, int erased, int resized) {
+    CacheConfig config = { capacity, CACHE_INDEX_PRESIZED, 0 };
+    CacheHandle* cache = cache_create(ops->name, &config);
+    CacheStats stats;
+    char name[64];
+    int passed = cache != NULL;
+
+    for (int key = 0; passed && key < capacity; key++) {
+        cache_put(cache, key, key);
+    }
+    for (int key = capacity - erased; passed && key < capacity; key++) {
+        cache_erase(cache, key);
+    }
+    passed = passed && cache_resize(cache, resized) == 0;
+    for (int key = capacity; passed && key < 11 * capacity; key++) {
+        if (cache_get(cache, key) == -1) {
+            cache_put(cache, key, key);
+        }
+        cache_get_stats(cache, &stats);
+        passed = stats.size <= resized && stats.capacity == resized;
+    }
+    cache_destroy(cache);
+
+    snprintf(name, sizeof(name), "%s: resize %d -> %d, then insert", ops->label, capacity, resized);
+    return report_check(name, passed);
+}
+
+// Regression checks for bugs found in review; returns the failure count
+int run_regression_checks(void) {
+    int failures = check_lirs_erase();
+
+    for (size_t p = 0; p < cache_policy_count(); p++) {
+        const CacheOps* ops = cache_policy_at(p);
+        failures += check_resize(ops, 1000, 10, 500);
+        failures += check_resize(ops, ops->min_capacity + 1, 0, ops->min_capacity);
+    }
+    printf("%d check(s) failed\n", failures);
+    return failures;
 }
 
 void run_selected_algorithm(int choice) {
-    Cache* cache = NULL;
-    
-    switch(choice) {
-        case 1:
-            cache = create_lru_cache(CACHE_SIZE);
-            test_lru_cache(cache);
-            destroy_lru_cache(cache);
-            break;
-            
-        case 2:
-            cache = create_lfu_cache(CACHE_SIZE);
-            test_lfu_cache(cache);
-            destroy_lfu_cache(cache);
-            break;
-            
-        case 3:
-            cache = create_fifo_cache(CACHE_SIZE);
-            test_fifo_cache(cache);
-            destroy_fifo_cache(cache);
-            break;
-            
-        case 4:
-            cache = create_random_cache(CACHE_SIZE);
-            test_random_cache(cache);
-            destroy_random_cache(cache);
-            break;
-            
-        case 5:
-            printf("\nRunning all cache replacement algorithms...\n");
-            
-            cache = create_lru_cache(CACHE_SIZE);
-            test_lru_cache(cache);
-            destroy_lru_cache(cache);
-            
-            cache = create_lfu_cache(CACHE_SIZE);
-            test_lfu_cache(cache);
-            destroy_lfu_cache(cache);
-            
-            cache = create_fifo_cache(CACHE_SIZE);
-            test_fifo_cache(cache);
-            destroy_fifo_cache(cache);
-            
-            cache = create_random_cache(CACHE_SIZE);
-            test_random_cache(cache);
-            destroy_random_cache(cache);
-            break;
-            
-        default:
-            printf("Invalid choice!\n");
+    size_t count = cache_policy_count();
+
+    if (choice >= 1 && (size_t)choice <= count) {
+        test_cache(cache_policy_at((size_t)choice - 1));
+    } else if ((size_t)choice == count + 1) {
+        printf("\nRunning all cache replacement algorithms...\n");
+        for (size_t i = 0; i < count; i++) {
+            test_cache(cache_policy_at(i));
+        }
+    } else if ((size_t)choice == count + 2) {
+        compare_hit_ratios();
+    } else if ((size_t)choice == count + 3) {
+        run_regression_checks();
+    } else {
+        printf("Invalid choice!\n");
     }
 }
 
@@ -165,10 +331,11 @@ int main() {
             break;
         }
         
-        if (choice >= 1 && choice <= 5) {
+        int last = (int)cache_policy_count() + 3;
+        if (choice >= 1 && choice <= last) {
             run_selected_algorithm(choice);
         } else {
-            printf("Invalid choice! Please select a number between 0 and 5.\n");
+            printf("Invalid choice! Please select a number between 0 and %d.\n", last);
         }
         
         printf("\nPress Enter to continue...");
@@ -0,0 +1,244 @@
+#include "trace_mrc.h"
+#include <stdlib.h>
+#include <string.h>
+#include "replacement_algorithms/cache_index.h"
+
+#define INITIAL_TIMES 4096
+#define MAX_TIMES (1u << 30)
+#define INITIAL_DISTANCES 1024
+
+// MRC state. Times run from 0 to now - 1; tree[t + 1] is the Fenwick node
+// for time t, and a time is live while it is some key's last access
+struct TraceMrc {
+    CacheIndex last;            // Key -> time of its last access
+    uint32_t* tree;             // times + 1 entries, 1-based
+    int* keys;                  // Key accessed at each time
+    uint32_t times;
+    uint32_t now;
+    uint64_t* hits;             // hits[d - 1]: gets at stack distance d
+    uint64_t* hit_bytes;
+    size_t distances;           // Entries allocated in hits and hit_bytes
+    size_t max_distance;        // Largest distance seen so far
+    TraceSimStats totals;       // Requests, bytes, writes and deletes
+};
+
+static void tree_add(uint32_t* tree, uint32_t times, uint32_t t, int delta) {
+    for (uint32_t i = t + 1; i <= times; i += i & -i) {
+        tree[i] += (uint32_t)delta;
+    }
+}
+
+// Live times in 0..t
+static uint32_t tree_prefix(const uint32_t* tree, uint32_t t) {
+    uint32_t sum = 0;
+    for (uint32_t i = t + 1; i > 0; i -= i & -i) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+// Free the MRC state
+void trace_mrc_destroy(TraceMrc* mrc) {
+    if (!mrc) {
+        return;
+    }
+    cache_index_destroy(&mrc->last);
+    free(mrc->tree);
+    free(mrc->keys);
+    free(mrc->hits);
+    free(mrc->hit_bytes);
+    free(mrc);
+}
+
+// Create an empty MRC; returns NULL if it can't be allocated
+TraceMrc* trace_mrc_create(void) {
+    TraceMrc* mrc = (TraceMrc*)calloc(1, sizeof(TraceMrc));
+    if (!mrc) {
+        return NULL;
+    }
+    if (cache_index_init(&mrc->last, INITIAL_TIMES, CACHE_INDEX_GROWABLE) != 0) {
+        free(mrc);
+        return NULL;
+    }
+
+    mrc->times = INITIAL_TIMES;
+    mrc->tree = (uint32_t*)calloc(mrc->times + 1, sizeof(uint32_t));
+    mrc->keys = (int*)malloc(mrc->times * sizeof(int));
+    mrc->distances = INITIAL_DISTANCES;
+    mrc->hits = (uint64_t*)calloc(mrc->distances, sizeof(uint64_t));
+    mrc->hit_bytes = (uint64_t*)calloc(mrc->distances, sizeof(uint64_t));
+    if (!mrc->tree || !mrc->keys || !mrc->hits || !mrc->hit_bytes) {
+        trace_mrc_destroy(mrc);
+        return NULL;
+    }
+    return mrc;
+}
+
+// Renumber the live times to 0..live-1 once every time has been used,
+// doubling the tree first if more than half of it would stay live.
+// Returns -1 if it can't grow
+static int renumber(TraceMrc* mrc) {
+    size_t live = cache_index_count(&mrc->last);
+
+    if (live * 2 > mrc->times) {
+        if (mrc->times >= MAX_TIMES) {
+            return -1;
+        }
+        uint32_t times = mrc->times * 2;
+        int* keys = (int*)realloc(mrc->keys, times * sizeof(int));
+        if (!keys) {
+            return -1;
+        }
+        mrc->keys = keys;
+        uint32_t* tree = (uint32_t*)realloc(mrc->tree, (times + 1) * sizeof(uint32_t));
+        if (!tree) {
+            return -1;
+        }
+        mrc->tree = tree;
+        mrc->times = times;
+    }
+
+    // Live times keep their order, so stack distances are unchanged
+    uint32_t next = 0;
+    for (uint32_t t = 0; t < mrc->now; t++) {
+        int key = mrc->keys[t];
+        if (cache_index_find(&mrc->last, key) == t) {
+            mrc->keys[next] = key;
+            cache_index_update(&mrc->last, key, next);
+            next++;
+        }
+    }
+    mrc->now = next;
+
+    // Linear-time Fenwick build over the new times
+    uint32_t* tree = mrc->tree;
+    memset(tree, 0, (mrc->times + 1) * sizeof(uint32_t));
+    for (uint32_t i = 1; i <= next; i++) {
+        tree[i] = 1;
+    }
+    for (uint32_t i = 1; i <= mrc->times; i++) {
+        uint32_t parent = i + (i & -i);
+        if (parent <= mrc->times) {
+            tree[parent] += tree[i];
+        }
+    }
+    return 0;
+}
+
+// Count a get at stack distance distance; returns -1 if the histogram
+// can't grow
+static int record_hit(TraceMrc* mrc, size_t distance, uint32_t size) {
+    if (distance > mrc->distances) {
+        size_t distances = mrc->distances;
+        while (distances < distance) {
+            distances *= 2;
+        }
+        uint64_t* hits = (uint64_t*)realloc(mrc->hits, distances * sizeof(uint64_t));
+        if (!hits) {
+            return -1;
+        }
+        mrc->hits = hits;
+        uint64_t* hit_bytes = (uint64_t*)realloc(mrc->hit_bytes, distances * sizeof(uint64_t));
+        if (!hit_bytes) {
+            return -1;
+        }
+        mrc->hit_bytes = hit_bytes;
+        memset(hits + mrc->distances, 0, (distances - mrc->distances) * sizeof(uint64_t));
+        memset(hit_bytes + mrc->distances, 0, (distances - mrc->distances) * sizeof(uint64_t));
+        mrc->distances = distances;
+    }
+
+    mrc->hits[distance - 1]++;
+    mrc->hit_bytes[distance - 1] += size;
+    if (distance > mrc->max_distance) {
+        mrc->max_distance = distance;
+    }
+    return 0;
+}
+
+// Move key to the top of the stack, recording a get's distance. Returns
+// -1 if the state can't grow
+static int touch(TraceMrc* mrc, const TraceRecord* record) {
+    if (mrc->now == mrc->times && renumber(mrc) != 0) {
+        return -1;
+    }
+
+    uint32_t t = mrc->now;
+    uint32_t last = cache_index_find(&mrc->last, record->key);
+    if (last != CACHE_INDEX_NONE) {
+        // Keys touched after last, plus the key itself
+        size_t distance = cache_index_count(&mrc->last) - tree_prefix(mrc->tree, last) + 1;
+        if (record->op == TRACE_GET && record_hit(mrc, distance, record->size) != 0) {
+            return -1;
+        }
+        tree_add(mrc->tree, mrc->times, last, -1);
+        cache_index_update(&mrc->last, record->key, t);
+    } else if (cache_index_insert(&mrc->last, record->key, t) != 0) {
+        return -1;
+    }
+
+    tree_add(mrc->tree, mrc->times, t, 1);
+    mrc->keys[t] = record->key;
+    mrc->now++;
+    return 0;
+}
+
+// Add count records to the curve; returns -1 if memory runs out, leaving
+// the curve covering the records before the failing one
+int trace_mrc_replay(TraceMrc* mrc, const TraceRecord* records, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const TraceRecord* record = &records[i];
+        switch (record->op) {
+            case TRACE_GET:
+            case TRACE_PUT:
+                if (touch(mrc, record) != 0) {
+                    return -1;
+                }
+                if (record->op == TRACE_GET) {
+                    mrc->totals.requests++;
+                    mrc->totals.bytes += record->size;
+                } else {
+                    mrc->totals.writes++;
+                }
+                break;
+            case TRACE_DELETE: {
+                mrc->totals.deletes++;
+                uint32_t last = cache_index_remove(&mrc->last, record->key);
+                if (last != CACHE_INDEX_NONE) {
+                    tree_add(mrc->tree, mrc->times, last, -1);
+                }
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+// Smallest capacity that gets the most hits: the curve is flat beyond it
+size_t trace_mrc_max_distance(const TraceMrc* mrc) {
+    return mrc->max_distance;
+}
+
+// What a trace_sim replay of the same records against an LRU cache of the
+// given capacity would report, except for evictions and timing
+void trace_mrc_stats(const TraceMrc* mrc, size_t capacity, TraceSimStats* stats) {
+    *stats = mrc->totals;
+    size_t limit = capacity < mrc->max_distance ? capacity : mrc->max_distance;
+    for (size_t d = 0; d < limit; d++) {
+        stats->hits += mrc->hits[d];
+        stats->hit_bytes += mrc->hit_bytes[d];
+    }
+}
+
+// Fill miss_ratios[c - 1] with the get miss ratio at capacity c, for
+// every capacity from 1 to max_capacity
+void trace_mrc_curve(const TraceMrc* mrc, double* miss_ratios, size_t max_capacity) {
+    uint64_t hits = 0;
+    for (size_t c = 1; c <= max_capacity; c++) {
+        if (c <= mrc->max_distance) {
+            hits += mrc->hits[c - 1];
+        }
+        miss_ratios[c - 1] = mrc->totals.requests
+            ? 1.0 - (double)hits / (double)mrc->totals.requests : 0.0;
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef TRACE_MRC_H
+#define TRACE_MRC_H
+
+#include "trace_reader.h"
+#include "trace_sim.h"
+
+// Exact LRU miss-ratio curve from one pass over a trace.
+//
+// LRU is a stack algorithm: a cache of capacity c always holds the c most
+// recently used keys, so a get hits exactly when fewer than c other keys
+// were touched since the key's last use (its stack distance). Each key's
+// last-access time is kept in a key index, and a Fenwick tree over time
+// holds a 1 at every key's latest access, so the distance is one prefix
+// sum and each record costs O(log n). A histogram of distances then gives
+// the hit ratio at every capacity at once.
+//
+// Gets and puts both move a key to the top of the stack, and only gets are
+// counted, as in trace_sim. A delete drops the key from the stack; the
+// curve is exact for traces without deletes and an approximation with them.
+// Timestamps are renumbered when the tree fills, so memory stays
+// proportional to the number of distinct keys, not the trace length.
+
+typedef struct TraceMrc TraceMrc;
+
+TraceMrc* trace_mrc_create(void);
+void trace_mrc_destroy(TraceMrc* mrc);
+int trace_mrc_replay(TraceMrc* mrc, const TraceRecord* records, size_t count);
+size_t trace_mrc_max_distance(const TraceMrc* mrc);
+void trace_mrc_stats(const TraceMrc* mrc, size_t capacity, TraceSimStats* stats);
+void trace_mrc_curve(const TraceMrc* mrc, double* miss_ratios, size_t max_capacity);
+
+#endif // TRACE_MRC_H 
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "trace_opt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "replacement_algorithms/cache_index.h"
+
+#define INITIAL_KEYS 4096
+
+// Resident key, ordered by its next use
+typedef struct OptEntry {
+    uint32_t next;
+    uint32_t weight;            // 1, or the object's size in bytes
+    int key;
+} OptEntry;
+
+// Resident set: a max-heap by next use, with each key's heap position
+// kept in the index so a hit can find and move its entry
+typedef struct OptCache {
+    OptEntry* heap;
+    OptEntry* popped;           // Bytes mode: entries taken out to make room
+    size_t count;
+    size_t slots;               // Of heap and of popped
+    CacheIndex positions;       // Key -> heap position
+    uint64_t used;              // Sum of the residents' weights
+} OptCache;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Fill next[i] with the index of the next request for records[i]'s key,
+// or TRACE_OPT_NEVER. Returns -1 if the trace is too long or the key map
+// can't be allocated
+int trace_opt_next_uses(const TraceRecord* records, size_t count, uint32_t* next) {
+    CacheIndex later;   // Key -> index of its earliest request seen so far
+
+    if (count >= TRACE_OPT_NEVER || cache_index_init(&later, INITIAL_KEYS, CACHE_INDEX_GROWABLE) != 0) {
+        return -1;
+    }
+
+    for (size_t i = count; i-- > 0;) {
+        int key = records[i].key;
+        if (records[i].op == TRACE_DELETE) {
+            // Requests before the delete can't reuse anything after it
+            next[i] = TRACE_OPT_NEVER;
+            cache_index_remove(&later, key);
+            continue;
+        }
+
+        next[i] = cache_index_find(&later, key);
+        if (next[i] != CACHE_INDEX_NONE) {
+            cache_index_update(&later, key, (uint32_t)i);
+        } else if (cache_index_insert(&later, key, (uint32_t)i) != 0) {
+            cache_index_destroy(&later);
+            return -1;
+        }
+    }
+
+    cache_index_destroy(&later);
+    return 0;
+}
+
+// Put entry at position i and record it in the index
+static inline void place(OptCache* cache, size_t i, OptEntry entry) {
+    cache->heap[i] = entry;
+    cache_index_update(&cache->positions, entry.key, (uint32_t)i);
+}
+
+static void sift_up(OptCache* cache, size_t i) {
+    OptEntry entry = cache->heap[i];
+    while (i > 0 && cache->heap[(i - 1) / 2].next < entry.next) {
+        place(cache, i, cache->heap[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    place(cache, i, entry);
+}
+
+static void sift_down(OptCache* cache, size_t i) {
+    OptEntry entry = cache->heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= cache->count) {
+            break;
+        }
+        if (child + 1 < cache->count && cache->heap[child + 1].next > cache->heap[child].next) {
+            child++;
+        }
+        if (cache->heap[child].next <= entry.next) {
+            break;
+        }
+        place(cache, i, cache->heap[child]);
+        i = child;
+    }
+    place(cache, i, entry);
+}
+
+// Remove the entry at position i
+static void remove_at(OptCache* cache, size_t i) {
+    OptEntry removed = cache->heap[i];
+    cache_index_remove(&cache->positions, removed.key);
+    cache->used -= removed.weight;
+
+    OptEntry last = cache->heap[--cache->count];
+    if (i == cache->count) {
+        return;
+    }
+    cache->heap[i] = last;
+    if (last.next > removed.next) {
+        sift_up(cache, i);
+    } else {
+        sift_down(cache, i);
+    }
+}
+
+// Add a key that isn't resident; returns -1 if the heap can't grow
+static int insert(OptCache* cache, int key, uint32_t next, uint32_t weight) {
+    if (cache->count == cache->slots) {
+        size_t slots = cache->slots * 2;
+        OptEntry* heap = (OptEntry*)realloc(cache->heap, slots * sizeof(OptEntry));
+        if (!heap) {
+            return -1;
+        }
+        cache->heap = heap;
+        OptEntry* popped = (OptEntry*)realloc(cache->popped, slots * sizeof(OptEntry));
+        if (!popped) {
+            return -1;
+        }
+        cache->popped = popped;
+        cache->slots = slots;
+    }
+    if (cache_index_insert(&cache->positions, key, (uint32_t)cache->count) != 0) {
+        return -1;
+    }
+
+    cache->heap[cache->count].next = next;
+    cache->heap[cache->count].weight = weight;
+    cache->heap[cache->count].key = key;
+    cache->used += weight;
+    sift_up(cache, cache->count++);
+    return 0;
+}
+
+// Make room for weight more by evicting the entries used latest, as long
+// as they are used after next_use, adding their count to evictions. They
+// are taken out into popped first and put back if that doesn't free
+// enough, so nothing is evicted for an object that won't be admitted.
+// Returns 0 if there is room, 1 if not, and -1 if an entry can't be put
+// back
+static int make_room(OptCache* cache, uint32_t next_use, uint32_t weight, uint64_t capacity,
+                     uint64_t* evictions) {
+    size_t popped = 0;
+
+    while (cache->used + weight > capacity && cache->count > 0 && cache->heap[0].next > next_use) {
+        cache->popped[popped++] = cache->heap[0];
+        remove_at(cache, 0);
+    }
+    if (cache->used + weight <= capacity) {
+        *evictions += popped;
+        return 0;
+    }
+
+    while (popped > 0) {
+        const OptEntry* entry = &cache->popped[--popped];
+        if (insert(cache, entry->key, entry->next, entry->weight) != 0) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+// Replay count records under OPT with the given capacity, in objects or
+// bytes, using next from trace_opt_next_uses. Returns -1 if the resident
+// set can't be allocated
+int trace_opt_run(const TraceRecord* records, const uint32_t* next, size_t count,
+                  uint64_t capacity, TraceOptMode mode, TraceSimStats* stats) {
+    OptCache cache;
+    memset(&cache, 0, sizeof(cache));
+    memset(stats, 0, sizeof(*stats));
+    cache.slots = INITIAL_KEYS;
+    cache.heap = (OptEntry*)malloc(cache.slots * sizeof(OptEntry));
+    cache.popped = (OptEntry*)malloc(cache.slots * sizeof(OptEntry));
+    if (!cache.heap || !cache.popped ||
+        cache_index_init(&cache.positions, INITIAL_KEYS, CACHE_INDEX_GROWABLE) != 0) {
+        free(cache.popped);
+        free(cache.heap);
+        return -1;
+    }
+
+    int failed = 0;
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < count && !failed; i++) {
+        const TraceRecord* record = &records[i];
+        uint32_t position = cache_index_find(&cache.positions, record->key);
+
+        if (record->op == TRACE_DELETE) {
+            stats->deletes++;
+            if (position != CACHE_INDEX_NONE) {
+                remove_at(&cache, position);
+            }
+            continue;
+        }
+
+        uint32_t weight = mode == TRACE_OPT_BYTES ? record->size : 1;
+        if (record->op == TRACE_GET) {
+            stats->requests++;
+            stats->bytes += record->size;
+        } else {
+            stats->writes++;
+        }
+
+        if (position != CACHE_INDEX_NONE) {
+            if (record->op == TRACE_GET) {
+                stats->hits++;
+                stats->hit_bytes += record->size;
+            }
+            // The entry was due now, so its next use can only move later
+            OptEntry* entry = &cache.heap[position];
+            cache.used += (uint64_t)weight - entry->weight;
+            entry->weight = weight;
+            entry->next = next[i];
+            sift_up(&cache, position);
+            while (cache.used > capacity) {
+                remove_at(&cache, 0);
+                stats->evictions++;
+            }
+            continue;
+        }
+
+        // Evict what is used later than this key, if that makes it fit
+        if (next[i] == TRACE_OPT_NEVER || weight > capacity) {
+            continue;
+        }
+        int room = make_room(&cache, next[i], weight, capacity, &stats->evictions);
+        if (room == 0) {
+            failed = insert(&cache, record->key, next[i], weight) != 0;
+        } else {
+            failed = room < 0;
+        }
+    }
+    stats->elapsed_ns = now_ns() - start;
+
+    free(cache.popped);
+    free(cache.heap);
+    cache_index_destroy(&cache.positions);
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,41 @@
+#ifndef TRACE_OPT_H
+#define TRACE_OPT_H
+
+#include "trace_reader.h"
+#include "trace_sim.h"
+
+// Belady's offline optimal policy (MIN), as a reference line for the
+// online policies.
+//
+// OPT needs the future, so it runs over a whole trace held in memory. A
+// reverse pass records, for every request, when its key is next used
+// (trace_opt_next_uses); the replay then keeps the resident keys in a
+// max-heap by next use and, when room is needed, evicts the one used
+// farthest in the future, in O(log c) per request. A key that won't be
+// used again, or would be used later than anything it could displace, is
+// not cached at all, which loses no hits against demand filling.
+//
+// Gets and puts are both uses, and only gets are counted, as in trace_sim.
+// A delete ends a key's life: it leaves the cache, and its next use is a
+// cold miss.
+//
+// TRACE_OPT_OBJECTS counts capacity in objects and is exactly optimal.
+// TRACE_OPT_BYTES counts capacity in bytes and weighs each object by its
+// size. It still evicts the farthest next use until the new object fits,
+// but only if the keys used later than it free enough bytes; otherwise
+// nothing is evicted and the object isn't cached. That is the usual
+// size-aware Belady; the true optimum with variable sizes
+// is NP-hard to compute.
+
+#define TRACE_OPT_NEVER UINT32_MAX     // Next use of a key that isn't used again
+
+typedef enum {
+    TRACE_OPT_OBJECTS,
+    TRACE_OPT_BYTES
+} TraceOptMode;
+
+int trace_opt_next_uses(const TraceRecord* records, size_t count, uint32_t* next);
+int trace_opt_run(const TraceRecord* records, const uint32_t* next, size_t count,
+                  uint64_t capacity, TraceOptMode mode, TraceSimStats* stats);
+
+#endif // TRACE_OPT_H 
\ No newline at end of file
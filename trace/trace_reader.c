@@ -0,0 +1,490 @@
+#include "trace_reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define READ_CHUNK (4u << 20)       // Bytes read per call
+#define SNIFF_BYTES 4096            // Read before the thread starts, to detect the format
+#define INPUT_BYTES (READ_CHUNK + SNIFF_BYTES)
+#define MAGIC_BYTES 8
+#define RECORD_BYTES 8
+
+// Reader structure. Block i of the stream lives in blocks[i % depth]; the
+// consumer holds block head while it reads it, and the decoder fills
+// block tail once the consumer has handed back the one that slot held
+struct TraceReader {
+    int fd;
+    TraceFormat format;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;      // tail moved or decoding ended
+    pthread_cond_t drained;     // head moved or the reader is closing
+    TraceRecord* blocks[TRACE_QUEUE_DEPTH];
+    size_t counts[TRACE_QUEUE_DEPTH];
+    uint64_t head;
+    uint64_t tail;
+    int holding;                // Consumer holds block head
+    int done;
+    int failed;
+    int closing;
+    uint64_t skipped;
+
+    // Decoder input; the decoder thread owns these once it starts
+    char* input;
+    size_t input_len;
+    int first_line;             // CSV: the next line may be a header
+    int overlong;               // Dropping the rest of a line longer than the input buffer
+};
+
+// Hash a non-numeric key (FNV-1a)
+static int hash_key(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return (int)h;
+}
+
+// Parse a decimal field; returns -1 if it isn't one or doesn't fit 32 bits
+static int parse_u32(const char* s, size_t len, uint32_t* value) {
+    uint64_t v = 0;
+    if (len == 0 || len > 10) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') {
+            return -1;
+        }
+        v = v * 10 + (uint64_t)(s[i] - '0');
+    }
+    if (v > UINT32_MAX) {
+        return -1;
+    }
+    *value = (uint32_t)v;
+    return 0;
+}
+
+// Key of a field: its value if it is a 32-bit integer, else its hash
+static int parse_key(const char* s, size_t len) {
+    uint32_t value;
+    if (len > 1 && s[0] == '-' && parse_u32(s + 1, len - 1, &value) == 0 && value <= 2147483648u) {
+        return (int)(0u - value);
+    }
+    if (parse_u32(s, len, &value) == 0) {
+        return (int)value;
+    }
+    return hash_key(s, len);
+}
+
+// Parse a CSV op field; returns -1 if it names no op
+static int parse_op(const char* s, size_t len, TraceOp* op) {
+    static const struct {
+        const char* name;
+        TraceOp op;
+    } names[] = {
+        { "get", TRACE_GET }, { "read", TRACE_GET }, { "r", TRACE_GET },
+        { "put", TRACE_PUT }, { "set", TRACE_PUT }, { "write", TRACE_PUT }, { "w", TRACE_PUT },
+        { "delete", TRACE_DELETE }, { "del", TRACE_DELETE }, { "d", TRACE_DELETE }
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strlen(names[i].name) == len && strncasecmp(names[i].name, s, len) == 0) {
+            *op = names[i].op;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Trim spaces, tabs and a trailing carriage return
+static void trim(const char** s, size_t* len) {
+    while (*len > 0 && (**s == ' ' || **s == '\t')) {
+        (*s)++;
+        (*len)--;
+    }
+    while (*len > 0 && ((*s)[*len - 1] == ' ' || (*s)[*len - 1] == '\t' || (*s)[*len - 1] == '\r')) {
+        (*len)--;
+    }
+}
+
+// Decode one line into record; returns 1 if it holds a request, 0 if it is
+// blank, a comment or a header, and -1 if it can't be parsed
+static int parse_line(TraceReader* reader, const char* line, size_t len, TraceRecord* record) {
+    trim(&line, &len);
+    if (len == 0 || line[0] == '#') {
+        return 0;
+    }
+    int first = reader->first_line;
+    reader->first_line = 0;
+
+    record->size = 1;
+    record->op = TRACE_GET;
+    if (reader->format == TRACE_FORMAT_TEXT) {
+        record->key = parse_key(line, len);
+        return 1;
+    }
+
+    // CSV: op,key[,size]
+    const char* fields[3];
+    size_t lens[3];
+    int n = 0;
+    const char* end = line + len;
+    while (n < 3) {
+        const char* comma = memchr(line, ',', (size_t)(end - line));
+        fields[n] = line;
+        lens[n] = (size_t)((comma ? comma : end) - line);
+        trim(&fields[n], &lens[n]);
+        n++;
+        if (!comma) {
+            break;
+        }
+        line = comma + 1;
+    }
+
+    if (n < 2 || parse_op(fields[0], lens[0], &record->op) != 0) {
+        return first ? 0 : -1;
+    }
+    record->key = parse_key(fields[1], lens[1]);
+    if (n == 3 && lens[2] > 0) {
+        uint32_t size;
+        if (parse_u32(fields[2], lens[2], &size) != 0) {
+            return first ? 0 : -1;
+        }
+        record->size = size < TRACE_MAX_SIZE ? size : TRACE_MAX_SIZE;
+    }
+    return 1;
+}
+
+// Decode one binary record; returns -1 for an unknown op
+static int parse_binary(const unsigned char* p, TraceRecord* record) {
+    uint32_t key = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    uint32_t word = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+    if ((word >> 30) > TRACE_DELETE) {
+        return -1;
+    }
+    record->key = (int)key;
+    record->size = word & TRACE_MAX_SIZE;
+    record->op = (TraceOp)(word >> 30);
+    return 0;
+}
+
+// Block to decode into next, waiting for the consumer to hand one back;
+// NULL if the reader is closing
+static TraceRecord* claim_block(TraceReader* reader) {
+    pthread_mutex_lock(&reader->lock);
+    while (reader->tail - reader->head >= TRACE_QUEUE_DEPTH && !reader->closing) {
+        pthread_cond_wait(&reader->drained, &reader->lock);
+    }
+    TraceRecord* block = reader->closing ? NULL : reader->blocks[reader->tail % TRACE_QUEUE_DEPTH];
+    pthread_mutex_unlock(&reader->lock);
+    return block;
+}
+
+// Hand a decoded block to the consumer
+static void publish_block(TraceReader* reader, size_t count, uint64_t skipped) {
+    pthread_mutex_lock(&reader->lock);
+    reader->counts[reader->tail % TRACE_QUEUE_DEPTH] = count;
+    reader->tail++;
+    reader->skipped += skipped;
+    pthread_cond_signal(&reader->filled);
+    pthread_mutex_unlock(&reader->lock);
+}
+
+// Decoder thread: read, split into lines or records, and fill blocks
+static void* decode_thread(void* arg) {
+    TraceReader* reader = (TraceReader*)arg;
+    size_t unit = reader->format == TRACE_FORMAT_BINARY ? RECORD_BYTES : 1;
+    size_t pos = 0;             // Start of the undecoded input
+    int eof = 0;
+    int failed = 0;
+
+    TraceRecord* block = claim_block(reader);
+    size_t count = 0;
+    uint64_t skipped = 0;
+
+    while (block) {
+        // Decode every complete line or record in the input
+        while (block) {
+            const char* start = reader->input + pos;
+            size_t avail = reader->input_len - pos;
+            TraceRecord* record = &block[count];
+            int result;
+
+            if (unit == RECORD_BYTES) {
+                if (avail < RECORD_BYTES) {
+                    break;
+                }
+                result = parse_binary((const unsigned char*)start, record) == 0 ? 1 : -1;
+                pos += RECORD_BYTES;
+            } else {
+                const char* newline = memchr(start, '\n', avail);
+                if (!newline && !(eof && avail > 0)) {
+                    break;
+                }
+                size_t len = newline ? (size_t)(newline - start) : avail;
+                result = reader->overlong ? 0 : parse_line(reader, start, len, record);
+                reader->overlong = 0;
+                pos += newline ? len + 1 : len;
+            }
+
+            if (result > 0 && ++count == TRACE_BLOCK_RECORDS) {
+                publish_block(reader, count, skipped);
+                block = claim_block(reader);
+                count = 0;
+                skipped = 0;
+            } else if (result < 0) {
+                skipped++;
+            }
+        }
+        if (!block || eof) {
+            break;
+        }
+
+        // Move the partial line or record to the front and read more
+        memmove(reader->input, reader->input + pos, reader->input_len - pos);
+        reader->input_len -= pos;
+        pos = 0;
+        if (reader->input_len == INPUT_BYTES) {
+            // No newline in the whole buffer: skip the line
+            skipped += !reader->overlong;
+            reader->input_len = 0;
+            reader->overlong = 1;
+        }
+        ssize_t n = read(reader->fd, reader->input + reader->input_len, INPUT_BYTES - reader->input_len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            failed = 1;
+            eof = 1;
+        } else if (n == 0) {
+            eof = 1;
+            skipped += reader->input_len % unit != 0;   // Truncated record
+        } else {
+            reader->input_len += (size_t)n;
+        }
+    }
+
+    if (block && count > 0) {
+        publish_block(reader, count, skipped);
+        skipped = 0;
+    }
+
+    pthread_mutex_lock(&reader->lock);
+    reader->skipped += skipped;
+    reader->failed |= failed;
+    reader->done = 1;
+    pthread_cond_signal(&reader->filled);
+    pthread_mutex_unlock(&reader->lock);
+    return NULL;
+}
+
+// Guess the format from the file name, then from the first bytes
+static TraceFormat detect_format(const char* path, const char* data, size_t len) {
+    const char* dot = strrchr(path, '.');
+    if (dot && strcasecmp(dot, ".csv") == 0) {
+        return TRACE_FORMAT_CSV;
+    }
+    if (dot && strcasecmp(dot, ".bin") == 0) {
+        return TRACE_FORMAT_BINARY;
+    }
+    if (len >= MAGIC_BYTES && memcmp(data, TRACE_BINARY_MAGIC, MAGIC_BYTES) == 0) {
+        return TRACE_FORMAT_BINARY;
+    }
+
+    const char* newline = memchr(data, '\n', len);
+    return memchr(data, ',', newline ? (size_t)(newline - data) : len) ? TRACE_FORMAT_CSV
+                                                                        : TRACE_FORMAT_TEXT;
+}
+
+// Free a reader whose thread isn't running
+static void free_reader(TraceReader* reader) {
+    for (int i = 0; i < TRACE_QUEUE_DEPTH; i++) {
+        free(reader->blocks[i]);
+    }
+    free(reader->input);
+    if (reader->fd > STDIN_FILENO) {
+        close(reader->fd);
+    }
+    free(reader);
+}
+
+// Open a trace ("-" reads standard input) and start decoding it; returns
+// NULL if it can't be opened or isn't in the given format
+TraceReader* trace_reader_open(const char* path, TraceFormat format) {
+    TraceReader* reader = (TraceReader*)calloc(1, sizeof(TraceReader));
+    if (!reader) {
+        return NULL;
+    }
+
+    reader->fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    reader->input = (char*)malloc(INPUT_BYTES);
+    int allocated = reader->input != NULL;
+    for (int i = 0; i < TRACE_QUEUE_DEPTH; i++) {
+        reader->blocks[i] = (TraceRecord*)malloc(TRACE_BLOCK_RECORDS * sizeof(TraceRecord));
+        allocated &= reader->blocks[i] != NULL;
+    }
+    if (reader->fd < 0 || !allocated) {
+        free_reader(reader);
+        return NULL;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Read the first bytes now, so the format can be checked here
+    while (reader->input_len < SNIFF_BYTES) {
+        ssize_t n = read(reader->fd, reader->input + reader->input_len, SNIFF_BYTES - reader->input_len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            free_reader(reader);
+            return NULL;
+        }
+        if (n == 0) {
+            break;
+        }
+        reader->input_len += (size_t)n;
+    }
+
+    if (format == TRACE_FORMAT_AUTO) {
+        format = detect_format(path, reader->input, reader->input_len);
+    }
+    if (format == TRACE_FORMAT_BINARY) {
+        if (reader->input_len < MAGIC_BYTES ||
+            memcmp(reader->input, TRACE_BINARY_MAGIC, MAGIC_BYTES) != 0) {
+            free_reader(reader);
+            return NULL;
+        }
+        reader->input_len -= MAGIC_BYTES;
+        memmove(reader->input, reader->input + MAGIC_BYTES, reader->input_len);
+    }
+    reader->format = format;
+    reader->first_line = 1;
+
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->filled, NULL);
+    pthread_cond_init(&reader->drained, NULL);
+    if (pthread_create(&reader->thread, NULL, decode_thread, reader) != 0) {
+        pthread_mutex_destroy(&reader->lock);
+        pthread_cond_destroy(&reader->filled);
+        pthread_cond_destroy(&reader->drained);
+        free_reader(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+// Next block of decoded records, or NULL at the end of the trace. The
+// block stays valid until the next call
+const TraceRecord* trace_reader_next(TraceReader* reader, size_t* count) {
+    pthread_mutex_lock(&reader->lock);
+    if (reader->holding) {
+        reader->head++;
+        reader->holding = 0;
+        pthread_cond_signal(&reader->drained);
+    }
+    while (reader->head == reader->tail && !reader->done) {
+        pthread_cond_wait(&reader->filled, &reader->lock);
+    }
+
+    const TraceRecord* block = NULL;
+    if (reader->head != reader->tail) {
+        block = reader->blocks[reader->head % TRACE_QUEUE_DEPTH];
+        *count = reader->counts[reader->head % TRACE_QUEUE_DEPTH];
+        reader->holding = 1;
+    }
+    pthread_mutex_unlock(&reader->lock);
+    return block;
+}
+
+// Stop decoding and free the reader
+void trace_reader_close(TraceReader* reader) {
+    if (!reader) {
+        return;
+    }
+
+    pthread_mutex_lock(&reader->lock);
+    reader->closing = 1;
+    pthread_cond_signal(&reader->drained);
+    pthread_mutex_unlock(&reader->lock);
+    pthread_join(reader->thread, NULL);
+
+    pthread_mutex_destroy(&reader->lock);
+    pthread_cond_destroy(&reader->filled);
+    pthread_cond_destroy(&reader->drained);
+    free_reader(reader);
+}
+
+// 1 if reading the trace failed part way
+int trace_reader_failed(TraceReader* reader) {
+    pthread_mutex_lock(&reader->lock);
+    int failed = reader->failed;
+    pthread_mutex_unlock(&reader->lock);
+    return failed;
+}
+
+// Lines or records skipped as unparseable so far
+uint64_t trace_reader_skipped(TraceReader* reader) {
+    pthread_mutex_lock(&reader->lock);
+    uint64_t skipped = reader->skipped;
+    pthread_mutex_unlock(&reader->lock);
+    return skipped;
+}
+
+// Format the trace is being decoded as
+TraceFormat trace_reader_format(const TraceReader* reader) {
+    return reader->format;
+}
+
+static const char* const format_names[] = { "auto", "text", "csv", "binary" };
+
+// Look a format up by name; returns -1 if there is none
+int trace_format_parse(const char* name, TraceFormat* format) {
+    for (int i = 0; i < (int)(sizeof(format_names) / sizeof(format_names[0])); i++) {
+        if (strcasecmp(name, format_names[i]) == 0) {
+            *format = (TraceFormat)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Name of a format
+const char* trace_format_name(TraceFormat format) {
+    return format_names[format];
+}
+
+// Start a binary trace
+int trace_write_binary_header(FILE* out) {
+    return fwrite(TRACE_BINARY_MAGIC, 1, MAGIC_BYTES, out) == MAGIC_BYTES ? 0 : -1;
+}
+
+// Append records to a binary trace
+int trace_write_binary(FILE* out, const TraceRecord* records, size_t count) {
+    unsigned char buffer[RECORD_BYTES * 1024];
+
+    for (size_t base = 0; base < count; base += 1024) {
+        size_t n = count - base < 1024 ? count - base : 1024;
+        for (size_t i = 0; i < n; i++) {
+            const TraceRecord* record = &records[base + i];
+            uint32_t key = (uint32_t)record->key;
+            uint32_t word = (record->size < TRACE_MAX_SIZE ? record->size : TRACE_MAX_SIZE) |
+                            (uint32_t)record->op << 30;
+            unsigned char* p = buffer + i * RECORD_BYTES;
+            for (int b = 0; b < 4; b++) {
+                p[b] = (unsigned char)(key >> (8 * b));
+                p[4 + b] = (unsigned char)(word >> (8 * b));
+            }
+        }
+        if (fwrite(buffer, RECORD_BYTES, n, out) != n) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Streaming decoder for cache access traces.
+//
+// A background thread reads the trace in large chunks and decodes it into
+// blocks of TRACE_BLOCK_RECORDS records, keeping up to TRACE_QUEUE_DEPTH
+// blocks ahead of the consumer, so decoding overlaps with simulation and a
+// trace of any length is replayed in constant memory. Formats:
+//
+//   text    one key per line
+//   csv     op,key[,size] per line; op is get/read/r, put/set/write/w or
+//           delete/del/d, and an optional header line is skipped
+//   binary  the TRACE_BINARY_MAGIC header, then 8-byte little-endian
+//           records: key (u32), then size (low 30 bits) and op (top 2)
+//
+// Numeric keys are used as they are; any other key is hashed to 32 bits.
+// Lines that can't be parsed are skipped and counted. A missing size is 1.
+
+#define TRACE_BLOCK_RECORDS 65536
+#define TRACE_QUEUE_DEPTH 4
+#define TRACE_BINARY_MAGIC "CTRACE01"   // 8 bytes, no terminator
+#define TRACE_MAX_SIZE ((1u << 30) - 1)
+
+typedef enum {
+    TRACE_GET,
+    TRACE_PUT,
+    TRACE_DELETE
+} TraceOp;
+
+typedef enum {
+    TRACE_FORMAT_AUTO,      // By extension (.csv, .bin), else by content
+    TRACE_FORMAT_TEXT,
+    TRACE_FORMAT_CSV,
+    TRACE_FORMAT_BINARY
+} TraceFormat;
+
+// One request
+typedef struct TraceRecord {
+    int key;
+    uint32_t size;          // Object size in bytes
+    TraceOp op;
+} TraceRecord;
+
+typedef struct TraceReader TraceReader;
+
+TraceReader* trace_reader_open(const char* path, TraceFormat format);
+const TraceRecord* trace_reader_next(TraceReader* reader, size_t* count);
+void trace_reader_close(TraceReader* reader);
+int trace_reader_failed(TraceReader* reader);
+uint64_t trace_reader_skipped(TraceReader* reader);
+TraceFormat trace_reader_format(const TraceReader* reader);
+
+int trace_format_parse(const char* name, TraceFormat* format);
+const char* trace_format_name(TraceFormat format);
+
+int trace_write_binary_header(FILE* out);
+int trace_write_binary(FILE* out, const TraceRecord* records, size_t count);
+
+#endif // TRACE_READER_H 
\ No newline at end of file
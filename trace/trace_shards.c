@@ -0,0 +1,313 @@
+#include "trace_shards.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "replacement_algorithms/cache_index.h"
+
+#define HASH_RANGE (1u << TRACE_SHARDS_HASH_BITS)
+
+// Sampled key and its hash, in the fixed-size heap
+typedef struct SampledKey {
+    uint32_t hash;
+    int key;
+} SampledKey;
+
+// One miniature cache
+typedef struct Miniature {
+    CacheHandle* cache;
+    int capacity;               // Full-size capacity it stands for
+    int limit;                  // Capacity at the current rate
+    double hits;                // Scaled to the full trace
+    double hit_bytes;
+} Miniature;
+
+// Sampler structure
+struct TraceShards {
+    Miniature* minis;
+    int count;
+    TraceShardsMode mode;
+    int min_capacity;           // Smallest capacity the policy accepts
+    uint32_t threshold;         // Keys hashing below this are sampled
+    size_t max_keys;
+    CacheIndex sampled;         // Fixed size: keys in the sample
+    SampledKey* heap;           // Fixed size: the sample as a max-heap by hash
+    size_t heap_count;
+    double sampled_requests;    // Scaled to the full trace
+    double sampled_bytes;
+    TraceSimStats totals;       // Every record, sampled or not
+    uint64_t elapsed_ns;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Sampling hash (murmur3's finalizer over a salted key, since the bare
+// finalizer maps 0 to 0 and key 0 would always be sampled). It must not be
+// cache_hash_key: the miniature caches' indexes pick groups from that
+// hash's top bits, so every sampled key would land in the first few groups
+static inline uint32_t sample_hash(int key) {
+    uint32_t h = (uint32_t)key ^ 0x9e3779b9u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h >> (32 - TRACE_SHARDS_HASH_BITS);
+}
+
+// Miniature capacity standing for capacity at the given rate, no smaller
+// than the policy accepts
+static int scaled_capacity(int capacity, double rate, int min_capacity) {
+    double scaled = (double)capacity * rate + 0.5;
+    return scaled < (double)min_capacity ? min_capacity : (int)scaled;
+}
+
+// Current sampling rate
+double trace_shards_rate(const TraceShards* shards) {
+    return (double)shards->threshold / (double)HASH_RANGE;
+}
+
+// Free the sampler and its miniature caches
+void trace_shards_destroy(TraceShards* shards) {
+    if (!shards) {
+        return;
+    }
+    for (int i = 0; shards->minis && i < shards->count; i++) {
+        cache_destroy(shards->minis[i].cache);
+    }
+    if (shards->heap) {
+        cache_index_destroy(&shards->sampled);
+    }
+    free(shards->heap);
+    free(shards->minis);
+    free(shards);
+}
+
+// Create a sampler with one miniature cache per capacity; returns NULL on
+// a bad rate or key budget, an unknown policy, or no memory
+TraceShards* trace_shards_create(const TraceShardsConfig* config) {
+    int fixed_size = config->mode == TRACE_SHARDS_FIXED_SIZE;
+    const CacheOps* ops = cache_policy_find(config->policy);
+    if (!ops || config->capacity_count <= 0 ||
+        (fixed_size ? config->max_keys == 0 || config->max_keys > 0x7fffffff
+                    : !(config->rate > 0.0 && config->rate <= 1.0))) {
+        return NULL;
+    }
+
+    TraceShards* shards = (TraceShards*)calloc(1, sizeof(TraceShards));
+    if (!shards) {
+        return NULL;
+    }
+    shards->mode = config->mode;
+    shards->min_capacity = ops->min_capacity;
+    shards->count = config->capacity_count;
+    shards->max_keys = config->max_keys;
+    if (fixed_size) {
+        shards->threshold = HASH_RANGE;
+    } else {
+        double threshold = config->rate * HASH_RANGE + 0.5;
+        shards->threshold = threshold < 1.0 ? 1 : (uint32_t)threshold;
+    }
+
+    shards->minis = (Miniature*)calloc((size_t)shards->count, sizeof(Miniature));
+    if (!shards->minis) {
+        trace_shards_destroy(shards);
+        return NULL;
+    }
+    if (fixed_size) {
+        shards->heap = (SampledKey*)malloc((config->max_keys + 1) * sizeof(SampledKey));
+        if (!shards->heap) {
+            trace_shards_destroy(shards);
+            return NULL;
+        }
+        if (cache_index_init(&shards->sampled, (int)config->max_keys + 1, CACHE_INDEX_PRESIZED) != 0) {
+            free(shards->heap);
+            shards->heap = NULL;
+            trace_shards_destroy(shards);
+            return NULL;
+        }
+    }
+
+    // A fixed-size sample never holds more than max_keys keys, so neither
+    // does any of its caches, whatever capacity they stand for
+    for (int i = 0; i < shards->count; i++) {
+        Miniature* mini = &shards->minis[i];
+        mini->capacity = config->capacities[i];
+        mini->limit = scaled_capacity(mini->capacity, trace_shards_rate(shards), shards->min_capacity);
+        if (fixed_size && (size_t)mini->limit > config->max_keys) {
+            mini->limit = (int)config->max_keys > shards->min_capacity
+                          ? (int)config->max_keys : shards->min_capacity;
+        }
+
+        CacheConfig cache_config = { mini->limit, fixed_size ? CACHE_INDEX_GROWABLE : CACHE_INDEX_PRESIZED,
+                                     config->seed };
+        mini->cache = cache_create(config->policy, &cache_config);
+        if (!mini->cache) {
+            trace_shards_destroy(shards);
+            return NULL;
+        }
+    }
+    return shards;
+}
+
+static void heap_push(TraceShards* shards, uint32_t hash, int key) {
+    SampledKey* heap = shards->heap;
+    size_t i = shards->heap_count++;
+    while (i > 0 && heap[(i - 1) / 2].hash < hash) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i].hash = hash;
+    heap[i].key = key;
+}
+
+static SampledKey heap_pop(TraceShards* shards) {
+    SampledKey* heap = shards->heap;
+    SampledKey top = heap[0];
+    SampledKey last = heap[--shards->heap_count];
+    size_t n = shards->heap_count;
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && heap[child + 1].hash > heap[child].hash) {
+            child++;
+        }
+        if (heap[child].hash <= last.hash) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (n > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// Fixed size: add key to the sample, and if that makes it too large, lower
+// the threshold to the largest hash in it and drop every key at or above
+// it from the sample and the miniature caches, which are then resized to
+// the new rate, segments and ghosts included, so each behaves like a
+// cache built at that rate. Returns -1 if the key can't be tracked
+static int track(TraceShards* shards, int key, uint32_t hash) {
+    if (cache_index_find(&shards->sampled, key) != CACHE_INDEX_NONE) {
+        return 0;
+    }
+    if (cache_index_insert(&shards->sampled, key, hash) != 0) {
+        return -1;
+    }
+    heap_push(shards, hash, key);
+    if (shards->heap_count <= shards->max_keys) {
+        return 0;
+    }
+
+    shards->threshold = shards->heap[0].hash;
+    while (shards->heap_count > 0 && shards->heap[0].hash >= shards->threshold) {
+        SampledKey dropped = heap_pop(shards);
+        cache_index_remove(&shards->sampled, dropped.key);
+        for (int i = 0; i < shards->count; i++) {
+            cache_erase(shards->minis[i].cache, dropped.key);
+        }
+    }
+
+    double rate = trace_shards_rate(shards);
+    for (int i = 0; i < shards->count; i++) {
+        Miniature* mini = &shards->minis[i];
+        int limit = scaled_capacity(mini->capacity, rate, shards->min_capacity);
+        if (limit < mini->limit && cache_resize(mini->cache, limit) == 0) {
+            mini->limit = limit;
+        }
+    }
+    return 0;
+}
+
+// Replay the sampled records among count, as trace_sim_replay would;
+// returns -1 if a fixed-size sample runs out of memory
+int trace_shards_replay(TraceShards* shards, const TraceRecord* records, size_t count) {
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < count; i++) {
+        const TraceRecord* record = &records[i];
+        if (record->op == TRACE_GET) {
+            shards->totals.requests++;
+            shards->totals.bytes += record->size;
+        } else if (record->op == TRACE_PUT) {
+            shards->totals.writes++;
+        } else {
+            shards->totals.deletes++;
+        }
+
+        uint32_t hash = sample_hash(record->key);
+        if (hash >= shards->threshold) {
+            continue;
+        }
+        if (shards->mode == TRACE_SHARDS_FIXED_SIZE) {
+            if (track(shards, record->key, hash) != 0) {
+                shards->elapsed_ns += now_ns() - start;
+                return -1;
+            }
+            if (hash >= shards->threshold) {
+                continue;       // Dropped by the threshold it just lowered
+            }
+        }
+
+        // Each sampled request stands for 1 / rate requests
+        double weight = (double)HASH_RANGE / (double)shards->threshold;
+        switch (record->op) {
+            case TRACE_GET:
+                shards->sampled_requests += weight;
+                shards->sampled_bytes += weight * record->size;
+                for (int m = 0; m < shards->count; m++) {
+                    Miniature* mini = &shards->minis[m];
+                    if (cache_get(mini->cache, record->key) != -1) {
+                        mini->hits += weight;
+                        mini->hit_bytes += weight * record->size;
+                    } else {
+                        cache_put(mini->cache, record->key, (int)record->size);
+                    }
+                }
+                break;
+            case TRACE_PUT:
+                for (int m = 0; m < shards->count; m++) {
+                    cache_put(shards->minis[m].cache, record->key, (int)record->size);
+                }
+                break;
+            case TRACE_DELETE:
+                for (int m = 0; m < shards->count; m++) {
+                    cache_erase(shards->minis[m].cache, record->key);
+                }
+                break;
+        }
+    }
+
+    shards->elapsed_ns += now_ns() - start;
+    return 0;
+}
+
+// Scaled sampled hits, corrected as in SHARDS-adj: a sample that drew more
+// (or fewer) requests than its rate predicts most likely did so through a
+// popular key, and popular keys hit, so the excess comes off the hits
+static uint64_t adjusted_hits(double hits, double sampled, uint64_t total) {
+    double adjusted = hits + (double)total - sampled + 0.5;
+    if (adjusted < 0.0) {
+        return 0;
+    }
+    return adjusted > (double)total ? total : (uint64_t)adjusted;
+}
+
+// Estimated stats at capacities[capacity_index]. Request, write and delete
+// counts are exact; hits are estimated and evictions left at 0
+void trace_shards_stats(const TraceShards* shards, int capacity_index, TraceSimStats* stats) {
+    const Miniature* mini = &shards->minis[capacity_index];
+
+    *stats = shards->totals;
+    stats->hits = adjusted_hits(mini->hits, shards->sampled_requests, shards->totals.requests);
+    stats->hit_bytes = adjusted_hits(mini->hit_bytes, shards->sampled_bytes, shards->totals.bytes);
+    stats->elapsed_ns = shards->elapsed_ns;
+}
@@ -0,0 +1,50 @@
+#ifndef TRACE_SHARDS_H
+#define TRACE_SHARDS_H
+
+#include "trace_reader.h"
+#include "trace_sim.h"
+
+// Approximate miss-ratio curves for any policy from miniature simulations
+// over a spatially hashed sample of the keys (SHARDS).
+//
+// A key is sampled when its hash falls below a threshold, so every request
+// to a sampled key is kept and the sample behaves like a smaller trace with
+// the same reuse pattern. A cache of capacity c is then simulated by a
+// miniature cache of capacity c * rate fed only the sampled requests, and
+// its hit ratio estimates the full one. Counts are scaled back up by
+// 1 / rate.
+//
+// Fixed rate keeps the rate given. Fixed size starts by sampling every key
+// and lowers the threshold whenever more than max_keys distinct keys are
+// sampled. The keys with the largest hashes are dropped from the sample and
+// from the miniature caches, and the caches are shrunk to their new
+// scaled capacity. Memory then stays bounded by max_keys however many keys
+// the trace has. Evictions are not estimated.
+
+#define TRACE_SHARDS_HASH_BITS 24   // Sampling threshold resolution
+
+typedef enum {
+    TRACE_SHARDS_FIXED_RATE,
+    TRACE_SHARDS_FIXED_SIZE
+} TraceShardsMode;
+
+// What to sample and simulate
+typedef struct TraceShardsConfig {
+    const char* policy;
+    const int* capacities;          // Full-size capacities to estimate
+    int capacity_count;
+    TraceShardsMode mode;
+    double rate;                    // Fixed rate: fraction of keys sampled
+    size_t max_keys;                // Fixed size: most distinct keys sampled
+    uint64_t seed;                  // Random eviction seed; 0 for the default
+} TraceShardsConfig;
+
+typedef struct TraceShards TraceShards;
+
+TraceShards* trace_shards_create(const TraceShardsConfig* config);
+void trace_shards_destroy(TraceShards* shards);
+int trace_shards_replay(TraceShards* shards, const TraceRecord* records, size_t count);
+double trace_shards_rate(const TraceShards* shards);
+void trace_shards_stats(const TraceShards* shards, int capacity_index, TraceSimStats* stats);
+
+#endif // TRACE_SHARDS_H 
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "trace_sim.h"
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Create the cache for a replay, seeding random eviction with seed (0 for
+// the default); returns -1 if the policy is unknown or the cache can't be
+// allocated
+int trace_sim_init(TraceSim* sim, const char* policy, int capacity, uint64_t seed) {
+    CacheConfig config = { capacity, CACHE_INDEX_PRESIZED, seed };
+
+    memset(&sim->stats, 0, sizeof(sim->stats));
+    sim->cache = cache_create(policy, &config);
+    return sim->cache ? 0 : -1;
+}
+
+// Free the cache
+void trace_sim_destroy(TraceSim* sim) {
+    cache_destroy(sim->cache);
+    sim->cache = NULL;
+}
+
+// Replay count records in order
+void trace_sim_replay(TraceSim* sim, const TraceRecord* records, size_t count) {
+    CacheHandle* cache = sim->cache;
+    TraceSimStats* stats = &sim->stats;
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < count; i++) {
+        const TraceRecord* record = &records[i];
+        switch (record->op) {
+            case TRACE_GET:
+                stats->requests++;
+                stats->bytes += record->size;
+                if (cache_get(cache, record->key) != -1) {
+                    stats->hits++;
+                    stats->hit_bytes += record->size;
+                } else {
+                    cache_put(cache, record->key, (int)record->size);
+                }
+                break;
+            case TRACE_PUT:
+                stats->writes++;
+                cache_put(cache, record->key, (int)record->size);
+                break;
+            case TRACE_DELETE:
+                stats->deletes++;
+                cache_erase(cache, record->key);
+                break;
+        }
+    }
+
+    stats->elapsed_ns += now_ns() - start;
+}
+
+// Report the replay so far, with the cache's evictions
+void trace_sim_get_stats(TraceSim* sim, TraceSimStats* stats) {
+    CacheStats cache_stats;
+    cache_get_stats(sim->cache, &cache_stats);
+
+    *stats = sim->stats;
+    stats->evictions = cache_stats.evictions;
+}
@@ -0,0 +1,37 @@
+#ifndef TRACE_SIM_H
+#define TRACE_SIM_H
+
+#include "replacement_algorithms/cache_registry.h"
+#include "trace_reader.h"
+
+// Replays trace records against one cache.
+//
+// A get that misses fills the cache with the key (demand fill), a put
+// stores it, and a delete erases it. Hit ratios count gets only; the byte
+// hit ratio weights each get by the size the trace gives for it. Capacity
+// is a number of objects, whatever their sizes.
+
+// Outcome of a replay
+typedef struct TraceSimStats {
+    uint64_t requests;      // Gets
+    uint64_t hits;
+    uint64_t bytes;         // Bytes requested by gets
+    uint64_t hit_bytes;
+    uint64_t writes;        // Puts
+    uint64_t deletes;
+    uint64_t evictions;
+    uint64_t elapsed_ns;    // Time spent in the cache calls' loop
+} TraceSimStats;
+
+// Simulator structure
+typedef struct TraceSim {
+    CacheHandle* cache;
+    TraceSimStats stats;
+} TraceSim;
+
+int trace_sim_init(TraceSim* sim, const char* policy, int capacity, uint64_t seed);
+void trace_sim_destroy(TraceSim* sim);
+void trace_sim_replay(TraceSim* sim, const TraceRecord* records, size_t count);
+void trace_sim_get_stats(TraceSim* sim, TraceSimStats* stats);
+
+#endif // TRACE_SIM_H 
\ No newline at end of file
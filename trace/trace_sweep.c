@@ -0,0 +1,301 @@
+#include "trace_sweep.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// One shared chunk of the trace; chunk n lives in slot n % TRACE_SWEEP_WINDOW
+typedef struct Chunk {
+    TraceRecord* records;
+    size_t count;
+    int remaining;              // Tasks that haven't replayed it yet
+} Chunk;
+
+// One (policy, capacity) pair
+typedef struct Task {
+    TraceSim sim;
+    uint64_t next_chunk;
+} Task;
+
+// Worker's deque of runnable tasks: the owner pushes and pops at the
+// bottom, thieves take from the top. Each task is in at most one deque,
+// so task_count slots always suffice
+typedef struct Deque {
+    pthread_mutex_t lock;
+    int* tasks;                 // Ring of task indexes
+    size_t top;
+    size_t bottom;
+} __attribute__((aligned(64))) Deque;
+
+// Sweep state
+typedef struct Sweep {
+    Task* tasks;
+    int task_count;
+    Deque* deques;
+    int threads;
+    Chunk chunks[TRACE_SWEEP_WINDOW];
+
+    pthread_mutex_t lock;       // Guards everything below
+    pthread_cond_t work;        // A task became runnable, or the sweep finished
+    pthread_cond_t slot_free;   // A chunk was replayed by every task
+    uint64_t published;         // Chunks available to the tasks
+    int eof;
+    int queued;                 // Tasks sitting in deques
+    int done;                   // Tasks that have replayed the whole trace
+    int* waiting;               // Tasks that have replayed every published chunk
+    int waiting_count;
+} Sweep;
+
+typedef struct Worker {
+    Sweep* sweep;
+    int id;
+    pthread_t thread;
+} Worker;
+
+static void deque_push(Sweep* sweep, int worker, int task) {
+    Deque* deque = &sweep->deques[worker];
+    pthread_mutex_lock(&deque->lock);
+    deque->tasks[deque->bottom++ % (size_t)sweep->task_count] = task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+// Newest task of a worker's own deque, or -1
+static int deque_pop(Sweep* sweep, int worker) {
+    Deque* deque = &sweep->deques[worker];
+    int task = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top) {
+        task = deque->tasks[--deque->bottom % (size_t)sweep->task_count];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+// Oldest task of another worker's deque, or -1
+static int deque_steal(Sweep* sweep, int victim) {
+    Deque* deque = &sweep->deques[victim];
+    int task = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top) {
+        task = deque->tasks[deque->top++ % (size_t)sweep->task_count];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+// Make a task runnable on a worker; the sweep lock must be held
+static void enqueue(Sweep* sweep, int worker, int task) {
+    deque_push(sweep, worker, task);
+    sweep->queued++;
+    pthread_cond_signal(&sweep->work);
+}
+
+// Take a task to run: the worker's own newest, else another's oldest
+static int take_task(Sweep* sweep, int worker) {
+    int task = deque_pop(sweep, worker);
+    for (int i = 1; task < 0 && i < sweep->threads; i++) {
+        task = deque_steal(sweep, (worker + i) % sweep->threads);
+    }
+    if (task >= 0) {
+        pthread_mutex_lock(&sweep->lock);
+        sweep->queued--;
+        pthread_mutex_unlock(&sweep->lock);
+    }
+    return task;
+}
+
+// Replay a task's next chunk, then requeue it, park it until the next
+// chunk is published, or retire it at the end of the trace
+static void run_task(Sweep* sweep, int worker, int index) {
+    Task* task = &sweep->tasks[index];
+    Chunk* chunk = &sweep->chunks[task->next_chunk % TRACE_SWEEP_WINDOW];
+
+    trace_sim_replay(&task->sim, chunk->records, chunk->count);
+    task->next_chunk++;
+
+    pthread_mutex_lock(&sweep->lock);
+    if (--chunk->remaining == 0) {
+        pthread_cond_signal(&sweep->slot_free);
+    }
+    if (task->next_chunk < sweep->published) {
+        enqueue(sweep, worker, index);
+    } else if (sweep->eof) {
+        if (++sweep->done == sweep->task_count) {
+            pthread_cond_broadcast(&sweep->work);
+        }
+    } else {
+        sweep->waiting[sweep->waiting_count++] = index;
+    }
+    pthread_mutex_unlock(&sweep->lock);
+}
+
+static void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Sweep* sweep = worker->sweep;
+
+    for (;;) {
+        int task = take_task(sweep, worker->id);
+        if (task >= 0) {
+            run_task(sweep, worker->id, task);
+            continue;
+        }
+
+        pthread_mutex_lock(&sweep->lock);
+        while (sweep->queued == 0 && sweep->done < sweep->task_count) {
+            pthread_cond_wait(&sweep->work, &sweep->lock);
+        }
+        int finished = sweep->done == sweep->task_count;
+        pthread_mutex_unlock(&sweep->lock);
+        if (finished) {
+            return NULL;
+        }
+    }
+}
+
+// Copy the reader's next block into the next chunk slot once every task
+// has replayed the chunk it held, and release the parked tasks. Returns 0
+// at the end of the trace
+static int publish_next(Sweep* sweep, TraceReader* reader) {
+    size_t count;
+    const TraceRecord* block = trace_reader_next(reader, &count);
+
+    pthread_mutex_lock(&sweep->lock);
+    if (!block) {
+        sweep->eof = 1;
+        sweep->done += sweep->waiting_count;    // Parked tasks have replayed everything
+        sweep->waiting_count = 0;
+        pthread_cond_broadcast(&sweep->work);
+        pthread_mutex_unlock(&sweep->lock);
+        return 0;
+    }
+
+    Chunk* chunk = &sweep->chunks[sweep->published % TRACE_SWEEP_WINDOW];
+    while (chunk->remaining > 0) {
+        pthread_cond_wait(&sweep->slot_free, &sweep->lock);
+    }
+    pthread_mutex_unlock(&sweep->lock);
+
+    memcpy(chunk->records, block, count * sizeof(TraceRecord));
+    chunk->count = count;
+
+    pthread_mutex_lock(&sweep->lock);
+    chunk->remaining = sweep->task_count;
+    sweep->published++;
+    for (int i = 0; i < sweep->waiting_count; i++) {
+        enqueue(sweep, i % sweep->threads, sweep->waiting[i]);
+    }
+    sweep->waiting_count = 0;
+    pthread_cond_broadcast(&sweep->work);
+    pthread_mutex_unlock(&sweep->lock);
+    return 1;
+}
+
+// Free everything the sweep allocated; the first created tasks have caches
+static void sweep_free(Sweep* sweep, int created) {
+    for (int i = 0; i < created; i++) {
+        trace_sim_destroy(&sweep->tasks[i].sim);
+    }
+    for (int i = 0; sweep->deques && i < sweep->threads; i++) {
+        pthread_mutex_destroy(&sweep->deques[i].lock);
+        free(sweep->deques[i].tasks);
+    }
+    for (int i = 0; i < TRACE_SWEEP_WINDOW; i++) {
+        free(sweep->chunks[i].records);
+    }
+    free(sweep->deques);
+    free(sweep->tasks);
+    free(sweep->waiting);
+    pthread_mutex_destroy(&sweep->lock);
+    pthread_cond_destroy(&sweep->work);
+    pthread_cond_destroy(&sweep->slot_free);
+}
+
+// Replay the whole trace against every policy at every capacity.
+// results[p * capacity_count + c] receives the outcome for policies[p] at
+// capacities[c], and *records the number of records in the trace. Returns
+// -1 if a cache or the sweep itself can't be set up
+int trace_sweep_run(TraceReader* reader, const TraceSweepConfig* config,
+                    TraceSimStats* results, uint64_t* records) {
+    Sweep sweep;
+    memset(&sweep, 0, sizeof(sweep));
+    pthread_mutex_init(&sweep.lock, NULL);
+    pthread_cond_init(&sweep.work, NULL);
+    pthread_cond_init(&sweep.slot_free, NULL);
+
+    sweep.task_count = config->policy_count * config->capacity_count;
+    sweep.threads = config->threads;
+    if (sweep.threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        sweep.threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (sweep.threads > sweep.task_count) {
+        sweep.threads = sweep.task_count > 0 ? sweep.task_count : 1;
+    }
+
+    sweep.tasks = (Task*)calloc((size_t)sweep.task_count, sizeof(Task));
+    sweep.waiting = (int*)malloc((size_t)sweep.task_count * sizeof(int));
+    sweep.deques = (Deque*)aligned_alloc(64, (size_t)sweep.threads * sizeof(Deque));
+    int failed = !sweep.tasks || !sweep.waiting || !sweep.deques;
+    if (sweep.deques) {
+        for (int i = 0; i < sweep.threads; i++) {
+            pthread_mutex_init(&sweep.deques[i].lock, NULL);
+            sweep.deques[i].tasks = (int*)malloc((size_t)sweep.task_count * sizeof(int));
+            sweep.deques[i].top = 0;
+            sweep.deques[i].bottom = 0;
+            failed |= !sweep.deques[i].tasks;
+        }
+    }
+    for (int i = 0; i < TRACE_SWEEP_WINDOW; i++) {
+        sweep.chunks[i].records = (TraceRecord*)malloc(TRACE_BLOCK_RECORDS * sizeof(TraceRecord));
+        failed |= !sweep.chunks[i].records;
+    }
+
+    // Every task starts parked, waiting for the first chunk
+    int created = 0;
+    for (int p = 0; !failed && p < config->policy_count; p++) {
+        for (int c = 0; c < config->capacity_count; c++) {
+            if (trace_sim_init(&sweep.tasks[created].sim, config->policies[p], config->capacities[c],
+                               config->seed) != 0) {
+                failed = 1;
+                break;
+            }
+            sweep.waiting[sweep.waiting_count++] = created++;
+        }
+    }
+    if (failed) {
+        sweep_free(&sweep, created);
+        return -1;
+    }
+
+    Worker* workers = (Worker*)malloc((size_t)sweep.threads * sizeof(Worker));
+    int started = 0;
+    for (; workers && started < sweep.threads; started++) {
+        workers[started].sweep = &sweep;
+        workers[started].id = started;
+        if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) {
+            break;
+        }
+    }
+    if (started == 0) {
+        free(workers);
+        sweep_free(&sweep, created);
+        return -1;
+    }
+    // Deques of workers that failed to start are still drained by stealing
+
+    *records = 0;
+    while (publish_next(&sweep, reader)) {
+        *records += sweep.chunks[(sweep.published - 1) % TRACE_SWEEP_WINDOW].count;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    free(workers);
+
+    for (int i = 0; i < sweep.task_count; i++) {
+        trace_sim_get_stats(&sweep.tasks[i].sim, &results[i]);
+    }
+    sweep_free(&sweep, created);
+    return 0;
+}
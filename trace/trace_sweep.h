@@ -0,0 +1,32 @@
+#ifndef TRACE_SWEEP_H
+#define TRACE_SWEEP_H
+
+#include "trace_reader.h"
+#include "trace_sim.h"
+
+// Replays one trace against many (policy, capacity) pairs at once.
+//
+// The trace is decoded once, into a window of shared chunks of up to
+// TRACE_BLOCK_RECORDS records. Each pair is a task that replays the chunks
+// in order, one chunk at a time, on a pool of worker threads. A worker
+// keeps running the task it just ran (its cache is still warm there) from
+// the bottom of its own deque, and a worker whose deque is empty steals the
+// oldest task from another's. A chunk's buffer is reused once every task
+// has replayed it, so memory stays bounded by the window, not the trace.
+
+#define TRACE_SWEEP_WINDOW 64       // Chunks decoded ahead of the slowest task
+
+// What to sweep
+typedef struct TraceSweepConfig {
+    const char* const* policies;
+    int policy_count;
+    const int* capacities;
+    int capacity_count;
+    int threads;                    // Workers; 0 means one per online CPU
+    uint64_t seed;                  // Random eviction seed; 0 for the default
+} TraceSweepConfig;
+
+int trace_sweep_run(TraceReader* reader, const TraceSweepConfig* config,
+                    TraceSimStats* results, uint64_t* records);
+
+#endif // TRACE_SWEEP_H 
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "trace_workload.h"
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+
+#define RECORD_CHUNK 256    // Keys generated at a time for trace_workload_records
+
+static const char* const kind_names[] = { "zipf", "scrambled-zipf", "scan", "loop", "hotspot" };
+
+// Uniform double in [0, 1) with 53 random bits
+static inline double uniform01(CacheRng* rng) {
+    uint64_t bits = ((uint64_t)cache_rng_next(rng) << 32) | cache_rng_next(rng);
+    return (double)(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Probability as a threshold on 32 random bits
+static uint64_t probability_threshold(double p) {
+    return (uint64_t)(p * 4294967296.0);
+}
+
+// log1p(x) / x, accurate near 0
+static double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+// expm1(x) / x, accurate near 0
+static double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+// The rejection-inversion hat: h(x) = x^-alpha, its integral H and H's
+// inverse, written so that alpha = 1 needs no special case
+static inline double zipf_h(double x, double alpha) {
+    return exp(-alpha * log(x));
+}
+
+static inline double zipf_h_integral(double x, double alpha) {
+    double log_x = log(x);
+    return helper2((1.0 - alpha) * log_x) * log_x;
+}
+
+static inline double zipf_h_integral_inverse(double x, double alpha) {
+    double t = x * (1.0 - alpha);
+    if (t < -1.0) {
+        t = -1.0;
+    }
+    return exp(helper1(t) * x);
+}
+
+// Zipf rank in 1..keys. Draws a point under the hat, inverts it to a
+// candidate rank and accepts it if the point also lies under the true
+// probability mass; fewer than 1.1 draws per rank on average
+static inline int zipf_rank(TraceWorkload* workload) {
+    double alpha = workload->config.alpha;
+    int keys = workload->config.keys;
+    for (;;) {
+        double u = workload->h_integral_n +
+                   uniform01(&workload->rng) * (workload->h_integral_x1 - workload->h_integral_n);
+        double x = zipf_h_integral_inverse(u, alpha);
+        int k = (int)(x + 0.5);
+        if (k < 1) {
+            k = 1;
+        } else if (k > keys) {
+            k = keys;
+        }
+        if (k - x <= workload->s || u >= zipf_h_integral(k + 0.5, alpha) - zipf_h(k, alpha)) {
+            return k;
+        }
+    }
+}
+
+// One round of a bijection on 0..mask: xor, odd multiply and xorshift
+// are each invertible modulo a power of two
+static inline uint32_t permute_round(const TraceWorkload* workload, uint32_t x) {
+    x = ((x ^ workload->scramble) * 0x9e3779b1u) & workload->mask;
+    x ^= x >> workload->shift;
+    x = (x * 0x85ebca6bu) & workload->mask;
+    return x ^ (x >> workload->shift);
+}
+
+// Scrambled-Zipf key for a 0-based rank: a fixed permutation of
+// 0..keys-1 that applies the bijection until the value is back in range
+// (cycle walking), which takes under two rounds on average
+int trace_workload_scramble(const TraceWorkload* workload, int key) {
+    uint32_t x = (uint32_t)key;
+    do {
+        x = permute_round(workload, x);
+    } while (x >= (uint32_t)workload->config.keys);
+    return (int)x;
+}
+
+// Fill config with the defaults for kind over keys keys: alpha 0.99, a
+// loop over every key, a hot tenth of the keys taking 90% of the
+// requests and moving every keys requests, gets only, size 1
+void trace_workload_config_default(TraceWorkloadConfig* config, TraceWorkloadKind kind, int keys) {
+    memset(config, 0, sizeof(*config));
+    config->kind = kind;
+    config->keys = keys;
+    config->alpha = 0.99;
+    config->loop_length = 0;
+    config->hot_fraction = 0.1;
+    config->hot_probability = 0.9;
+    config->shift_every = (uint64_t)(keys > 0 ? keys : 0);
+    config->put_ratio = 0.0;
+    config->min_size = 1;
+    config->max_size = 1;
+    config->seed = 1;
+}
+
+// Set up a generator; returns -1 on a bad config
+int trace_workload_init(TraceWorkload* workload, const TraceWorkloadConfig* config) {
+    if (config->keys <= 0 || (int)config->kind < 0 || config->kind > TRACE_WORKLOAD_HOTSPOT ||
+        !(config->alpha > 0.0) || config->loop_length < 0 ||
+        !(config->hot_fraction >= 0.0 && config->hot_fraction <= 1.0) ||
+        !(config->hot_probability >= 0.0 && config->hot_probability <= 1.0) ||
+        !(config->put_ratio >= 0.0 && config->put_ratio <= 1.0) ||
+        config->min_size == 0 || config->min_size > config->max_size || config->max_size > TRACE_MAX_SIZE) {
+        return -1;
+    }
+
+    memset(workload, 0, sizeof(*workload));
+    workload->config = *config;
+    if (workload->config.loop_length == 0) {
+        workload->config.loop_length = config->keys;
+    }
+    cache_rng_seed(&workload->rng, config->seed, 1);
+    cache_rng_seed(&workload->op_rng, config->seed, 2);
+    workload->put_threshold = probability_threshold(config->put_ratio);
+
+    double alpha = config->alpha;
+    workload->h_integral_x1 = zipf_h_integral(1.5, alpha) - 1.0;
+    workload->h_integral_n = zipf_h_integral(config->keys + 0.5, alpha);
+    workload->s = 2.0 - zipf_h_integral_inverse(zipf_h_integral(2.5, alpha) - zipf_h(2.0, alpha), alpha);
+
+    int bits = 1;
+    while (bits < 31 && (1u << bits) < (uint32_t)config->keys) {
+        bits++;
+    }
+    workload->mask = (1u << bits) - 1;
+    workload->shift = bits / 2 > 0 ? bits / 2 : 1;
+    workload->scramble = (uint32_t)(config->seed * 0x9e3779b97f4a7c15ull >> 32) & workload->mask;
+
+    double hot = config->hot_fraction * config->keys;
+    workload->hot_keys = hot < 1.0 ? 1 : (int)hot;
+    workload->hot_base = 0;
+    workload->hot_threshold = probability_threshold(config->hot_probability);
+    return 0;
+}
+
+// Write the next count keys of the stream
+void trace_workload_keys(TraceWorkload* workload, int* keys, size_t count) {
+    const TraceWorkloadConfig* config = &workload->config;
+    uint64_t generated = workload->generated;
+
+    switch (config->kind) {
+        case TRACE_WORKLOAD_ZIPF:
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = zipf_rank(workload) - 1;
+            }
+            break;
+        case TRACE_WORKLOAD_SCRAMBLED_ZIPF:
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = trace_workload_scramble(workload, zipf_rank(workload) - 1);
+            }
+            break;
+        case TRACE_WORKLOAD_SCAN:
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = (int)((generated + i) & 0x7fffffff);
+            }
+            break;
+        case TRACE_WORKLOAD_LOOP: {
+            int position = (int)(generated % (uint64_t)config->loop_length);
+            for (size_t i = 0; i < count; i++) {
+                keys[i] = position;
+                position = position + 1 == config->loop_length ? 0 : position + 1;
+            }
+            break;
+        }
+        case TRACE_WORKLOAD_HOTSPOT:
+            for (size_t i = 0; i < count; i++) {
+                if (cache_rng_next(&workload->rng) < workload->hot_threshold) {
+                    int64_t key = (int64_t)workload->hot_base +
+                                  cache_rng_below(&workload->rng, (uint32_t)workload->hot_keys);
+                    keys[i] = (int)(key % config->keys);
+                } else {
+                    keys[i] = (int)cache_rng_below(&workload->rng, (uint32_t)config->keys);
+                }
+                if (config->shift_every && (generated + i + 1) % config->shift_every == 0) {
+                    workload->hot_base = (int)(((int64_t)workload->hot_base + workload->hot_keys) % config->keys);
+                }
+            }
+            break;
+    }
+
+    workload->generated = generated + count;
+}
+
+// Write the next count requests: keys from the stream, with ops and sizes
+void trace_workload_records(TraceWorkload* workload, TraceRecord* records, size_t count) {
+    uint32_t size_range = workload->config.max_size - workload->config.min_size;
+    int keys[RECORD_CHUNK];
+
+    for (size_t base = 0; base < count; base += RECORD_CHUNK) {
+        size_t n = count - base < RECORD_CHUNK ? count - base : RECORD_CHUNK;
+        trace_workload_keys(workload, keys, n);
+        for (size_t i = 0; i < n; i++) {
+            TraceRecord* record = &records[base + i];
+            record->key = keys[i];
+            record->op = cache_rng_next(&workload->op_rng) < workload->put_threshold ? TRACE_PUT : TRACE_GET;
+            record->size = workload->config.min_size +
+                           (size_range ? cache_rng_below(&workload->op_rng, size_range + 1) : 0);
+        }
+    }
+}
+
+// Look a workload kind up by name; returns -1 if there is none
+int trace_workload_parse_kind(const char* name, TraceWorkloadKind* kind) {
+    for (size_t i = 0; i < sizeof(kind_names) / sizeof(kind_names[0]); i++) {
+        if (strcasecmp(name, kind_names[i]) == 0) {
+            *kind = (TraceWorkloadKind)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* trace_workload_kind_name(TraceWorkloadKind kind) {
+    return (size_t)kind < sizeof(kind_names) / sizeof(kind_names[0]) ? kind_names[kind] : "unknown";
+}
@@ -0,0 +1,85 @@
+#ifndef TRACE_WORKLOAD_H
+#define TRACE_WORKLOAD_H
+
+#include "replacement_algorithms/cache_rng.h"
+#include "trace_reader.h"
+
+// Synthetic workload generators for benchmarks and trace experiments.
+//
+// Each generator writes keys (trace_workload_keys) or complete requests
+// (trace_workload_records) in bulk into a caller-supplied buffer, so a
+// benchmark can generate its stream up front, or a block at a time, and
+// keep generation out of its timed loop. Every sampler is O(1) per key
+// with no tables, so the key space can be as large as an int allows.
+// Streams are reproducible from the seed. Kinds:
+//
+//   zipf            rank r in 1..keys with probability proportional to
+//                   r^-alpha, for any alpha > 0, by rejection-inversion
+//                   (Hoermann and Derflinger). Key r - 1, so popular keys
+//                   are numerically adjacent
+//   scrambled-zipf  the same ranks, passed through a fixed permutation of
+//                   0..keys-1, so popular keys are spread over the space
+//   scan            0, 1, 2, ... never repeating (until the int range wraps)
+//   loop            0..loop_length-1 over and over
+//   hotspot         hot_probability of requests go uniformly to a window
+//                   of hot_fraction * keys keys, the rest uniformly to all
+//                   keys; the window moves to the next keys after every
+//                   shift_every requests
+//
+// put_ratio of the requests are puts and the rest gets. Sizes are uniform
+// in min_size..max_size.
+
+typedef enum {
+    TRACE_WORKLOAD_ZIPF,
+    TRACE_WORKLOAD_SCRAMBLED_ZIPF,
+    TRACE_WORKLOAD_SCAN,
+    TRACE_WORKLOAD_LOOP,
+    TRACE_WORKLOAD_HOTSPOT
+} TraceWorkloadKind;
+
+// What to generate; trace_workload_config_default fills in the defaults
+typedef struct TraceWorkloadConfig {
+    TraceWorkloadKind kind;
+    int keys;                   // Key space size
+    double alpha;               // Zipf exponent
+    int loop_length;            // Loop: keys in the cycle; 0 means keys
+    double hot_fraction;        // Hotspot: share of the keys that are hot
+    double hot_probability;     // Hotspot: share of the requests they get
+    uint64_t shift_every;       // Hotspot: requests between moves; 0 never moves
+    double put_ratio;
+    uint32_t min_size;
+    uint32_t max_size;
+    uint64_t seed;
+} TraceWorkloadConfig;
+
+// Generator state
+typedef struct TraceWorkload {
+    TraceWorkloadConfig config;
+    CacheRng rng;
+    CacheRng op_rng;            // Ops and sizes, so keys don't depend on them
+    uint64_t generated;         // Keys produced so far
+    uint64_t put_threshold;     // A request is a put when 32 random bits fall below it
+    // Zipf
+    double h_integral_x1;
+    double h_integral_n;
+    double s;
+    // Scrambled Zipf: a permutation of 0..mask walked until it lands below keys
+    uint32_t mask;
+    uint32_t scramble;
+    int shift;
+    // Hotspot
+    int hot_keys;
+    int hot_base;
+    uint64_t hot_threshold;     // Like put_threshold, for the hot window
+} TraceWorkload;
+
+void trace_workload_config_default(TraceWorkloadConfig* config, TraceWorkloadKind kind, int keys);
+int trace_workload_init(TraceWorkload* workload, const TraceWorkloadConfig* config);
+void trace_workload_keys(TraceWorkload* workload, int* keys, size_t count);
+void trace_workload_records(TraceWorkload* workload, TraceRecord* records, size_t count);
+int trace_workload_scramble(const TraceWorkload* workload, int key);
+
+int trace_workload_parse_kind(const char* name, TraceWorkloadKind* kind);
+const char* trace_workload_kind_name(TraceWorkloadKind kind);
+
+#endif // TRACE_WORKLOAD_H 
\ No newline at end of file
@@ -0,0 +1,657 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "replacement_algorithms/cache_registry.h"
+#include "trace/trace_mrc.h"
+#include "trace/trace_opt.h"
+#include "trace/trace_reader.h"
+#include "trace/trace_shards.h"
+#include "trace/trace_sim.h"
+#include "trace/trace_sweep.h"
+
+// Replay a cache access trace against one or more policies and report how
+// each one did. The trace is decoded once, block by block, and every block
+// is replayed against each selected policy in turn. With -C, every policy
+// is instead replayed at every listed capacity in parallel (see
+// trace/trace_sweep.h) and the hit ratios are printed as a matrix. With
+// -M, the exact LRU miss-ratio curve is computed in one pass instead (see
+// trace/trace_mrc.h), and with -S every policy is estimated from a sample
+// of the keys (see trace/trace_shards.h). The offline optimum (opt and
+// opt-bytes, see trace/trace_opt.h) needs the whole trace, so selecting it
+// keeps a copy of the records and runs it once the trace has been read.
+
+#define DEFAULT_CAPACITY 100000
+#define MAX_CAPACITIES 256
+
+// Command line settings
+typedef struct Options {
+    const char* path;
+    TraceFormat format;
+    const char* policies;       // Comma-separated names, or "all"
+    int capacity;
+    const char* binary_out;     // Also write the trace here in binary form
+    int capacities[MAX_CAPACITIES];     // Sweep capacities, if any
+    int capacity_count;
+    int threads;                // Sweep workers; 0 means one per CPU
+    int mrc;                    // Compute the LRU miss-ratio curve
+    const char* curve_out;      // Write the full curve here as CSV
+    int sample;                 // Estimate from a SHARDS sample of the keys
+    TraceShardsMode sample_mode;
+    double sample_rate;
+    size_t sample_keys;
+    int opt;                    // Also run OPT with -c objects
+    int opt_bytes;              // Also run byte-weighted OPT
+    uint64_t byte_capacity;     // For opt-bytes; 0 means -c times the mean get size
+    uint64_t seed;              // Random eviction seed; 0 for the default
+} Options;
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [-f auto|text|csv|binary] [-p policy,...|all] [-c capacity]\n"
+            "          [-B byte_capacity] [-w binary_out] [-r seed] trace|-\n"
+            "       %s -C capacity,...|min:max:count [-t threads] [-f format] [-p policy,...|all]\n"
+            "          [-r seed] trace|-\n"
+            "       %s -M [-C capacity,...|min:max:count] [-o curve.csv] [-f format] trace|-\n"
+            "       %s -S rate|keys [-C capacity,...|min:max:count] [-f format] [-p policy,...|all]\n"
+            "          [-r seed] trace|-\n"
+            "Policies:", program, program, program, program);
+    for (size_t i = 0; i < cache_policy_count(); i++) {
+        fprintf(stderr, " %s", cache_policy_at(i)->name);
+    }
+    fprintf(stderr, ", and opt and opt-bytes (offline optimum) without -C, -M or -S\n");
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+// Parse a capacity list: "a,b,c", or "min:max:count" for count sizes
+// spaced geometrically from min to max. Returns -1 on a bad one
+static int parse_capacities(const char* spec, Options* options) {
+    long min, max;
+    int count;
+    char tail;
+
+    if (sscanf(spec, "%ld:%ld:%d%c", &min, &max, &count, &tail) == 3) {
+        if (min <= 0 || max < min || max > 0x7fffffff || count < 1 || count > MAX_CAPACITIES) {
+            return -1;
+        }
+        options->capacity_count = 0;
+        for (int i = 0; i < count; i++) {
+            double t = count > 1 ? (double)i / (count - 1) : 0.0;
+            int capacity = (int)(min * pow((double)max / (double)min, t) + 0.5);
+            if (options->capacity_count == 0 ||
+                capacity != options->capacities[options->capacity_count - 1]) {
+                options->capacities[options->capacity_count++] = capacity;
+            }
+        }
+        return 0;
+    }
+
+    options->capacity_count = 0;
+    for (const char* p = spec; *p; ) {
+        char* end;
+        long capacity = strtol(p, &end, 10);
+        if (end == p || capacity <= 0 || capacity > 0x7fffffff ||
+            options->capacity_count == MAX_CAPACITIES || (*end && *end != ',')) {
+            return -1;
+        }
+        options->capacities[options->capacity_count++] = (int)capacity;
+        p = *end ? end + 1 : end;
+    }
+    return options->capacity_count > 0 ? 0 : -1;
+}
+
+// Parse a sample spec: a rate in (0, 1] for fixed-rate sampling, or a
+// whole number of keys above 1 for fixed-size sampling. Returns -1 on a
+// bad one
+static int parse_sample(const char* spec, Options* options) {
+    char* end;
+    double value = strtod(spec, &end);
+
+    if (end == spec || *end || !(value > 0.0)) {
+        return -1;
+    }
+    options->sample = 1;
+    if (value <= 1.0) {
+        options->sample_mode = TRACE_SHARDS_FIXED_RATE;
+        options->sample_rate = value;
+        return 0;
+    }
+    if (value != (double)(size_t)value || value > 0x7fffffff) {
+        return -1;
+    }
+    options->sample_mode = TRACE_SHARDS_FIXED_SIZE;
+    options->sample_keys = (size_t)value;
+    return 0;
+}
+
+// Parse the command line; returns -1 on a bad one
+static int parse_options(int argc, char** argv, Options* options) {
+    options->format = TRACE_FORMAT_AUTO;
+    options->policies = "all";
+    options->capacity = DEFAULT_CAPACITY;
+    options->binary_out = NULL;
+    options->capacity_count = 0;
+    options->threads = 0;
+    options->mrc = 0;
+    options->curve_out = NULL;
+    options->sample = 0;
+    options->opt = 0;
+    options->opt_bytes = 0;
+    options->byte_capacity = 0;
+    options->seed = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:p:c:B:w:C:t:Mo:S:r:h")) != -1) {
+        switch (opt) {
+            case 'f':
+                if (trace_format_parse(optarg, &options->format) != 0) {
+                    fprintf(stderr, "Unknown trace format %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'p':
+                options->policies = optarg;
+                break;
+            case 'c':
+                options->capacity = atoi(optarg);
+                if (options->capacity <= 0) {
+                    fprintf(stderr, "Capacity must be positive\n");
+                    return -1;
+                }
+                break;
+            case 'B':
+                options->byte_capacity = strtoull(optarg, NULL, 10);
+                if (options->byte_capacity == 0) {
+                    fprintf(stderr, "Byte capacity must be positive\n");
+                    return -1;
+                }
+                break;
+            case 'w':
+                options->binary_out = optarg;
+                break;
+            case 'C':
+                if (parse_capacities(optarg, options) != 0) {
+                    fprintf(stderr, "Bad capacity list %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 't':
+                options->threads = atoi(optarg);
+                break;
+            case 'M':
+                options->mrc = 1;
+                break;
+            case 'o':
+                options->curve_out = optarg;
+                break;
+            case 'S':
+                if (parse_sample(optarg, options) != 0) {
+                    fprintf(stderr, "Bad sample %s: give a rate up to 1 or a number of keys\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'r':
+                options->seed = strtoull(optarg, NULL, 0);
+                if (options->seed == 0) {
+                    fprintf(stderr, "Seed must be a nonzero number\n");
+                    return -1;
+                }
+                break;
+            default:
+                return -1;
+        }
+    }
+
+    if (optind != argc - 1) {
+        return -1;
+    }
+    if (options->capacity_count > 0 && options->binary_out) {
+        fprintf(stderr, "-w can't be combined with -C\n");
+        return -1;
+    }
+    if (options->mrc && options->binary_out) {
+        fprintf(stderr, "-w can't be combined with -M\n");
+        return -1;
+    }
+    if (options->sample && (options->mrc || options->binary_out)) {
+        fprintf(stderr, "-S can't be combined with -M or -w\n");
+        return -1;
+    }
+    if (options->curve_out && !options->mrc) {
+        fprintf(stderr, "-o needs -M\n");
+        return -1;
+    }
+    options->path = argv[optind];
+    return 0;
+}
+
+// Names of the selected registered policies; returns how many, or -1.
+// "all" stands for every registered policy, and opt and opt-bytes set
+// the matching flags instead of adding a name
+static int select_policies(const char* list, const char** names, int* opt, int* opt_bytes) {
+    int count = 0;
+    char* copy = strdup(list);
+    char* saved = NULL;
+
+    for (char* name = strtok_r(copy, ",", &saved); name; name = strtok_r(NULL, ",", &saved)) {
+        if (strcmp(name, "opt") == 0) {
+            *opt = 1;
+            continue;
+        }
+        if (strcmp(name, "opt-bytes") == 0) {
+            *opt_bytes = 1;
+            continue;
+        }
+
+        int all = strcmp(name, "all") == 0;
+        const CacheOps* ops = all ? NULL : cache_policy_find(name);
+        if (!all && !ops) {
+            fprintf(stderr, "Unknown policy %s\n", name);
+            free(copy);
+            return -1;
+        }
+        for (size_t i = 0; i < (all ? cache_policy_count() : 1); i++) {
+            if (count == (int)cache_policy_count()) {
+                fprintf(stderr, "Too many policies\n");
+                free(copy);
+                return -1;
+            }
+            names[count++] = all ? cache_policy_at(i)->name : ops->name;
+        }
+    }
+    free(copy);
+    return count;
+}
+
+// Print hit ratios with a row per capacity and a column per policy, from
+// results[p * capacity_count + c]
+static void print_matrix(const char** names, int policy_count, const int* capacities,
+                         int capacity_count, const TraceSimStats* results) {
+    printf("\nHit ratio (%%)\n%-10s", "Capacity");
+    for (int p = 0; p < policy_count; p++) {
+        printf(" %9s", cache_policy_find(names[p])->label);
+    }
+    printf("\n");
+    for (int c = 0; c < capacity_count; c++) {
+        printf("%-10d", capacities[c]);
+        for (int p = 0; p < policy_count; p++) {
+            const TraceSimStats* stats = &results[p * capacity_count + c];
+            printf(" %9.2f", percent(stats->hits, stats->requests));
+        }
+        printf("\n");
+    }
+}
+
+// Replay every selected policy at every capacity and print the hit ratios
+static int run_sweep(const Options* options, TraceReader* reader, const char** names, int policy_count) {
+    TraceSweepConfig config = { names, policy_count, options->capacities, options->capacity_count,
+                                options->threads, options->seed };
+    TraceSimStats* results = (TraceSimStats*)malloc((size_t)policy_count * options->capacity_count *
+                                                    sizeof(TraceSimStats));
+    uint64_t records;
+    uint64_t start = now_ns();
+    if (!results || trace_sweep_run(reader, &config, results, &records) != 0) {
+        fprintf(stderr, "Could not set up the sweep\n");
+        free(results);
+        return 1;
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("%s (%s): %llu records, %llu skipped, %d policies x %d capacities, %.2f s, "
+           "%.1f Mops/s over all replays\n",
+           options->path, trace_format_name(trace_reader_format(reader)), (unsigned long long)records,
+           (unsigned long long)trace_reader_skipped(reader), policy_count, options->capacity_count,
+           (double)elapsed / 1e9,
+           (double)records * policy_count * options->capacity_count * 1e3 / (double)elapsed);
+    print_matrix(names, policy_count, options->capacities, options->capacity_count, results);
+
+    free(results);
+    return trace_reader_failed(reader);
+}
+
+// Estimate every selected policy at the -C capacities (or -c) from a
+// sample of the keys and print the hit ratios
+static int run_shards(const Options* options, TraceReader* reader, const char** names, int policy_count) {
+    const int* capacities = options->capacity_count > 0 ? options->capacities : &options->capacity;
+    int capacity_count = options->capacity_count > 0 ? options->capacity_count : 1;
+    TraceShards** shards = (TraceShards**)calloc((size_t)policy_count, sizeof(TraceShards*));
+    TraceSimStats* results = (TraceSimStats*)malloc((size_t)policy_count * capacity_count *
+                                                    sizeof(TraceSimStats));
+    int failed = !shards || !results;
+
+    for (int p = 0; !failed && p < policy_count; p++) {
+        TraceShardsConfig config = { names[p], capacities, capacity_count, options->sample_mode,
+                                     options->sample_rate, options->sample_keys, options->seed };
+        shards[p] = trace_shards_create(&config);
+        if (!shards[p]) {
+            fprintf(stderr, "Could not create the %s miniature caches\n", names[p]);
+            failed = 1;
+        }
+    }
+
+    uint64_t records = 0;
+    uint64_t start = now_ns();
+    const TraceRecord* block;
+    size_t count;
+    while (!failed && (block = trace_reader_next(reader, &count)) != NULL) {
+        records += count;
+        for (int p = 0; p < policy_count; p++) {
+            if (trace_shards_replay(shards[p], block, count) != 0) {
+                fprintf(stderr, "Out of memory for the %s sample\n", names[p]);
+                failed = 1;
+                break;
+            }
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    if (!failed) {
+        if (trace_reader_failed(reader)) {
+            fprintf(stderr, "Reading %s failed part way\n", options->path);
+            failed = 1;
+        }
+        printf("%s (%s): %llu records, %llu skipped, %d policies x %d capacities, %.2f s, "
+               "estimated from %s sampling at rate %.5f\n",
+               options->path, trace_format_name(trace_reader_format(reader)), (unsigned long long)records,
+               (unsigned long long)trace_reader_skipped(reader), policy_count, capacity_count,
+               (double)elapsed / 1e9,
+               options->sample_mode == TRACE_SHARDS_FIXED_RATE ? "fixed-rate" : "fixed-size",
+               policy_count > 0 ? trace_shards_rate(shards[0]) : 0.0);
+        for (int p = 0; p < policy_count; p++) {
+            for (int c = 0; c < capacity_count; c++) {
+                trace_shards_stats(shards[p], c, &results[p * capacity_count + c]);
+            }
+        }
+        print_matrix(names, policy_count, capacities, capacity_count, results);
+    }
+
+    for (int p = 0; shards && p < policy_count; p++) {
+        trace_shards_destroy(shards[p]);
+    }
+    free(shards);
+    free(results);
+    return failed;
+}
+
+// Write the miss ratio at every capacity up to where the curve goes flat
+static int write_curve(const char* path, const TraceMrc* mrc) {
+    size_t max_capacity = trace_mrc_max_distance(mrc);
+    double* miss_ratios = (double*)malloc((max_capacity ? max_capacity : 1) * sizeof(double));
+    FILE* out = fopen(path, "w");
+    int failed = !miss_ratios || !out;
+
+    if (!failed) {
+        trace_mrc_curve(mrc, miss_ratios, max_capacity);
+        fprintf(out, "capacity,miss_ratio\n");
+        for (size_t c = 1; c <= max_capacity; c++) {
+            fprintf(out, "%zu,%.6f\n", c, miss_ratios[c - 1]);
+        }
+    }
+    if (out && fclose(out) != 0) {
+        failed = 1;
+    }
+    free(miss_ratios);
+    return failed ? -1 : 0;
+}
+
+// Compute the exact LRU miss-ratio curve and print it at the -C
+// capacities, or at powers of two up to where it goes flat
+static int run_mrc(const Options* options, TraceReader* reader) {
+    TraceMrc* mrc = trace_mrc_create();
+    if (!mrc) {
+        fprintf(stderr, "Could not allocate the miss-ratio curve\n");
+        return 1;
+    }
+
+    uint64_t records = 0;
+    uint64_t start = now_ns();
+    const TraceRecord* block;
+    size_t count;
+    while ((block = trace_reader_next(reader, &count)) != NULL) {
+        records += count;
+        if (trace_mrc_replay(mrc, block, count) != 0) {
+            fprintf(stderr, "Out of memory for the miss-ratio curve\n");
+            trace_mrc_destroy(mrc);
+            return 1;
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    int failed = trace_reader_failed(reader);
+    if (failed) {
+        fprintf(stderr, "Reading %s failed part way\n", options->path);
+    }
+
+    size_t max_capacity = trace_mrc_max_distance(mrc);
+    printf("%s (%s): %llu records, %llu skipped, LRU miss-ratio curve flat from capacity %zu, "
+           "%.2f s\n", options->path, trace_format_name(trace_reader_format(reader)),
+           (unsigned long long)records, (unsigned long long)trace_reader_skipped(reader),
+           max_capacity, (double)elapsed / 1e9);
+    printf("--------------------------------------------\n");
+    printf("Capacity     Miss ratio  Byte miss ratio\n");
+    printf("--------------------------------------------\n");
+    size_t points[MAX_CAPACITIES];
+    int point_count = 0;
+    for (int c = 0; c < options->capacity_count; c++) {
+        points[point_count++] = (size_t)options->capacities[c];
+    }
+    if (point_count == 0 && max_capacity > 0) {
+        for (size_t capacity = 1; capacity < max_capacity; capacity *= 2) {
+            points[point_count++] = capacity;
+        }
+        points[point_count++] = max_capacity;
+    }
+    for (int p = 0; p < point_count; p++) {
+        TraceSimStats stats;
+        trace_mrc_stats(mrc, points[p], &stats);
+        printf("%-12zu %9.2f%%  %14.2f%%\n", points[p],
+               100.0 - percent(stats.hits, stats.requests), 100.0 - percent(stats.hit_bytes, stats.bytes));
+    }
+    printf("--------------------------------------------\n");
+
+    if (options->curve_out && write_curve(options->curve_out, mrc) != 0) {
+        fprintf(stderr, "Could not write %s\n", options->curve_out);
+        failed = 1;
+    }
+    trace_mrc_destroy(mrc);
+    return failed;
+}
+
+// Run OPT over the buffered trace: with capacity objects, and if asked
+// byte-weighted with byte_capacity bytes. Returns -1 if it runs out of memory
+static int run_opt(const Options* options, const TraceRecord* trace, size_t count,
+                   uint64_t byte_capacity, TraceSimStats* stats, TraceSimStats* byte_stats) {
+    uint32_t* next = (uint32_t*)malloc((count ? count : 1) * sizeof(uint32_t));
+    uint64_t start = now_ns();
+    if (!next || trace_opt_next_uses(trace, count, next) != 0) {
+        free(next);
+        return -1;
+    }
+    uint64_t pass_ns = now_ns() - start;
+
+    int failed = 0;
+    if (options->opt) {
+        failed |= trace_opt_run(trace, next, count, (uint64_t)options->capacity, TRACE_OPT_OBJECTS, stats);
+        stats->elapsed_ns += pass_ns;
+    }
+    if (options->opt_bytes) {
+        failed |= trace_opt_run(trace, next, count, byte_capacity, TRACE_OPT_BYTES, byte_stats);
+        byte_stats->elapsed_ns += pass_ns;
+    }
+    free(next);
+    return failed ? -1 : 0;
+}
+
+static void print_row(const char* label, const TraceSimStats* stats, uint64_t records) {
+    printf("%-12s %8.2f%%  %13.2f%%  %12llu  %9.2f\n", label,
+           percent(stats->hits, stats->requests), percent(stats->hit_bytes, stats->bytes),
+           (unsigned long long)stats->evictions,
+           stats->elapsed_ns ? (double)records * 1e3 / (double)stats->elapsed_ns : 0.0);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (parse_options(argc, argv, &options) != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char** names = (const char**)malloc(cache_policy_count() * sizeof(const char*));
+    int sim_count = names ? select_policies(options.policies, names, &options.opt, &options.opt_bytes) : -1;
+    if (sim_count < 0) {
+        return 1;
+    }
+    int offline = options.opt || options.opt_bytes;
+    if (offline && (options.mrc || options.sample || options.capacity_count > 0)) {
+        fprintf(stderr, "opt and opt-bytes can't be combined with -C, -M or -S\n");
+        return 2;
+    }
+
+    TraceReader* reader = trace_reader_open(options.path, options.format);
+    if (!reader) {
+        fprintf(stderr, "Could not open %s as a %s trace\n", options.path,
+                trace_format_name(options.format));
+        return 1;
+    }
+
+    if (options.mrc) {
+        int status = run_mrc(&options, reader);
+        trace_reader_close(reader);
+        free(names);
+        return status;
+    }
+
+    if (options.sample) {
+        int status = run_shards(&options, reader, names, sim_count);
+        trace_reader_close(reader);
+        free(names);
+        return status;
+    }
+
+    if (options.capacity_count > 0) {
+        int status = run_sweep(&options, reader, names, sim_count);
+        trace_reader_close(reader);
+        free(names);
+        return status;
+    }
+
+    TraceSim* sims = (TraceSim*)calloc((size_t)sim_count, sizeof(TraceSim));
+    for (int s = 0; sims && s < sim_count; s++) {
+        if (trace_sim_init(&sims[s], names[s], options.capacity, options.seed) != 0) {
+            fprintf(stderr, "Could not create a %s cache\n", names[s]);
+            return 1;
+        }
+    }
+    if (!sims) {
+        return 1;
+    }
+
+    FILE* out = NULL;
+    if (options.binary_out) {
+        out = fopen(options.binary_out, "wb");
+        if (!out || trace_write_binary_header(out) != 0) {
+            fprintf(stderr, "Could not write %s\n", options.binary_out);
+            return 1;
+        }
+    }
+
+    // OPT replays the whole trace afterwards, from this copy
+    TraceRecord* trace = NULL;
+    size_t trace_slots = 0;
+    uint64_t get_bytes = 0;
+    uint64_t gets = 0;
+
+    uint64_t records = 0;
+    uint64_t start = now_ns();
+    const TraceRecord* block;
+    size_t count;
+    while ((block = trace_reader_next(reader, &count)) != NULL) {
+        if (offline) {
+            if (records + count > trace_slots) {
+                size_t slots = trace_slots ? trace_slots * 2 : TRACE_BLOCK_RECORDS;
+                TraceRecord* grown = (TraceRecord*)realloc(trace, slots * sizeof(TraceRecord));
+                if (!grown) {
+                    fprintf(stderr, "Out of memory keeping the trace for opt\n");
+                    return 1;
+                }
+                trace = grown;
+                trace_slots = slots;
+            }
+            memcpy(trace + records, block, count * sizeof(TraceRecord));
+            for (size_t i = 0; i < count; i++) {
+                if (block[i].op == TRACE_GET) {
+                    gets++;
+                    get_bytes += block[i].size;
+                }
+            }
+        }
+        records += count;
+        for (int s = 0; s < sim_count; s++) {
+            trace_sim_replay(&sims[s], block, count);
+        }
+        if (out && trace_write_binary(out, block, count) != 0) {
+            fprintf(stderr, "Could not write %s\n", options.binary_out);
+            return 1;
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    TraceSimStats opt_stats, opt_byte_stats;
+    uint64_t byte_capacity = options.byte_capacity;
+    if (byte_capacity == 0) {
+        byte_capacity = gets ? (uint64_t)options.capacity * get_bytes / gets : (uint64_t)options.capacity;
+    }
+    if (offline && run_opt(&options, trace, (size_t)records, byte_capacity, &opt_stats, &opt_byte_stats) != 0) {
+        fprintf(stderr, "Could not run opt: out of memory, or over 4G records\n");
+        return 1;
+    }
+    free(trace);
+
+    int failed = trace_reader_failed(reader);
+    if (failed) {
+        fprintf(stderr, "Reading %s failed part way\n", options.path);
+    }
+    if (out && fclose(out) != 0) {
+        fprintf(stderr, "Could not write %s\n", options.binary_out);
+        failed = 1;
+    }
+
+    printf("%s (%s): %llu records, %llu skipped, capacity %d, %.2f s\n", options.path,
+           trace_format_name(trace_reader_format(reader)), (unsigned long long)records,
+           (unsigned long long)trace_reader_skipped(reader), options.capacity, (double)elapsed / 1e9);
+    printf("--------------------------------------------------------------------\n");
+    printf("Policy       Hit ratio  Byte hit ratio     Evictions     Mops/s\n");
+    printf("--------------------------------------------------------------------\n");
+    for (int s = 0; s < sim_count; s++) {
+        TraceSimStats stats;
+        trace_sim_get_stats(&sims[s], &stats);
+        print_row(sims[s].cache->ops->label, &stats, records);
+        trace_sim_destroy(&sims[s]);
+    }
+    if (options.opt) {
+        print_row("OPT", &opt_stats, records);
+    }
+    if (options.opt_bytes) {
+        print_row("OPT-bytes", &opt_byte_stats, records);
+    }
+    printf("--------------------------------------------------------------------\n");
+    if (options.opt_bytes) {
+        printf("OPT-bytes capacity: %llu bytes\n", (unsigned long long)byte_capacity);
+    }
+
+    trace_reader_close(reader);
+    free(sims);
+    free(names);
+    return failed;
+}